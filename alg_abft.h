@@ -0,0 +1,255 @@
+//
+// ABFT (algorithm-based fault tolerance): GEMM с контрольными суммами
+// До умножения за O(n^2) считаются эталонные суммы строк C:
+//   r(i)  = A(i,:) (B e)     - сумма строки i
+//   rw(i) = A(i,:) (B w)     - взвешенная сумма, w_j = j + 1
+// C считается полосами по TB строк; как только полоса готова, каждая её строка
+// сверяется с r(i) за O(n). При расхождении d = sum_j C(i,j) - r(i) и
+// dw = sum_j w_j C(i,j) - rw(i) одиночная ошибка находится в столбце dw / d - 1,
+// и пересчитывается только содержащий её тайл. Итого поверх O(n^3) - O(n^2).
+// Опционально в конце сверяются суммы столбцов: (e^T A) B против e^T C.
+//
+
+#ifndef ALG_ABFT_H
+#define ALG_ABFT_H
+
+#include "structures.h"
+#include "alg_transpose.h"
+#include "parallel.h"
+#include "workspace.h"
+#include <cmath>
+#include <complex>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <set>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+struct AbftOptions {
+    int tile = 64;                // размер тайла C (и высота полосы)
+    double tol_factor = 16.0;     // как в freivalds_check
+    int max_retries = 2;          // повторных пересчётов полосы при неустранённой ошибке
+    bool column_check = true;     // финальная сверка сумм столбцов
+    int num_threads = 1;          // полосы параллельно (0 - все ядра)
+};
+
+struct AbftReport {
+    int tiles = 0;                        // посчитано тайлов (без пересчётов)
+    int rows_failed = 0;                  // строк с расхождением контрольной суммы
+    int tiles_recomputed = 0;
+    int unlocated = 0;                    // расхождений без однозначного столбца (пересчёт всей полосы)
+    std::vector<std::pair<int, int>> faulty_tiles;  // (ti, tj) пересчитанных тайлов
+    bool column_check_passed = true;
+    bool ok = true;                       // все проверки в итоге пройдены
+};
+
+// Хук для тестов: вызывается после вычисления тайла (ti, tj), может испортить данные.
+// При num_threads != 1 вызывается из разных потоков.
+template <class T>
+using AbftFaultHook = std::function<void(int ti, int tj, MatrixView<T> tile)>;
+
+// Машинный эпсилон для допуска: точная арифметика у целых, double для complex
+template <class T>
+double abft_eps() {
+    if constexpr (std::is_integral_v<T>) return 0.0;
+    else if constexpr (std::is_floating_point_v<T>) return std::numeric_limits<T>::epsilon();
+    else return std::numeric_limits<double>::epsilon();
+}
+
+template <class T>
+AbftReport mul_abft_view(MatrixView<const T> A, MatrixView<const T> B, MatrixView<T> C,
+                         const AbftOptions& opt = {},
+                         const AbftFaultHook<T>& inject = nullptr,
+                         OpCounter* cnt = nullptr) {
+    assert(A.cols == B.rows);
+    assert(A.rows == C.rows and B.cols == C.cols);
+    assert(opt.tile > 0);
+
+    const int m = A.rows, k = A.cols, n = B.cols;
+    const int TB = opt.tile;
+    const int tm = (m + TB - 1) / TB, tn = (n + TB - 1) / TB;
+    const double eps = abft_eps<T>();
+    AbftReport rep;
+
+    ///--- Эталонные суммы: O(kn + mk)
+    std::vector<T> be(k), bw(k);
+    std::vector<double> abs_be(k), abs_bw(k);
+    for (int p = 0; p < k; p++) {
+        T s = T{}, sw = T{};
+        double sa = 0.0, swa = 0.0;
+        for (int j = 0; j < n; j++) {
+            T b = B(p, j);
+            double w = j + 1.0;
+            s += b;
+            sw += b * T(w);
+            sa += std::abs(b);
+            swa += std::abs(b) * w;
+        }
+        be[p] = s; bw[p] = sw; abs_be[p] = sa; abs_bw[p] = swa;
+    }
+    std::vector<T> r(m), rw(m);
+    std::vector<double> bound(m), bound_w(m);
+    for (int i = 0; i < m; i++) {
+        T s = T{}, sw = T{};
+        double sa = 0.0, swa = 0.0;
+        for (int p = 0; p < k; p++) {
+            T a = A(i, p);
+            s += a * be[p];
+            sw += a * bw[p];
+            sa += std::abs(a) * abs_be[p];
+            swa += std::abs(a) * abs_bw[p];
+        }
+        r[i] = s; rw[i] = sw; bound[i] = sa; bound_w[i] = swa;
+    }
+
+    // B транспонируется один раз - тайлы считаются скалярными произведениями строк
+    Workspace& ws = thread_workspace();
+    Workspace::Scope scope(ws);
+    MatrixView<T> Bt(ws.alloc<T>((size_t)k * n), n, k, k);
+    transpose_view(B, Bt, opt.num_threads);
+
+    auto compute_tile = [&](int ti, int tj) {
+        int r0 = ti * TB, c0 = tj * TB;
+        int h = std::min(TB, m - r0), w = std::min(TB, n - c0);
+        mul_naive_bt_view<T>(subview(A, r0, 0, h, k), subview(MatrixView<const T>(Bt), c0, 0, w, k),
+                             subview(C, r0, c0, h, w), nullptr);
+    };
+
+    // Проверка строки i: 0 - в порядке, иначе столбец ошибки + 1 или -1, если не найден
+    auto check_row = [&](int i) -> int {
+        T s = T{}, sw = T{};
+        double ca = 0.0, cwa = 0.0;
+        for (int j = 0; j < n; j++) {
+            T c = C(i, j);
+            double w = j + 1.0;
+            s += c;
+            sw += c * T(w);
+            ca += std::abs(c);
+            cwa += std::abs(c) * w;
+        }
+        double d = std::abs(s - r[i]);
+        double tol = opt.tol_factor * eps * ((double)k * bound[i] + (double)n * ca);
+        if (d == d and d <= tol) return 0;
+
+        // Одиночная ошибка delta в столбце j: d = delta, dw = (j + 1) delta
+        T delta = s - r[i];
+        T delta_w = sw - rw[i];
+        if (!(d == d) or d == 0.0) return -1;
+        double pos = std::abs(delta_w / delta);
+        int j = (int)std::lround(pos) - 1;
+        double tol_w = opt.tol_factor * eps * ((double)k * bound_w[i] + (double)n * cwa);
+        if (j < 0 or j >= n or std::abs(delta_w - T(j + 1.0) * delta) > tol_w + 1e-3 * std::abs(delta_w)) return -1;
+        return j + 1;
+    };
+
+    std::mutex rep_mutex;
+
+    // Полоса строк ti: все тайлы, проверка строк, пересчёт найденных тайлов
+    auto do_panel = [&](int ti) {
+        AbftReport local;
+        for (int tj = 0; tj < tn; tj++) {
+            compute_tile(ti, tj);
+            local.tiles++;
+            if (inject) {
+                int r0 = ti * TB, c0 = tj * TB;
+                inject(ti, tj, subview(C, r0, c0, std::min(TB, m - r0), std::min(TB, n - c0)));
+            }
+        }
+
+        int r0 = ti * TB, h = std::min(TB, m - r0);
+        std::set<int> recomputed;
+        for (int attempt = 0; attempt <= opt.max_retries; attempt++) {
+            std::set<int> bad_cols;
+            bool unlocated = false;
+            for (int i = r0; i < r0 + h; i++) {
+                int res = check_row(i);
+                if (res == 0) continue;
+                local.rows_failed++;
+                int tj = (res - 1) / TB;
+                // Несколько ошибок в строке дают правдоподобный, но ложный столбец:
+                // если тайл уже пересчитан, а строка всё равно не сходится - пересчитываем полосу
+                if (res > 0 and !recomputed.count(tj)) bad_cols.insert(tj);
+                else unlocated = true;
+            }
+            if (bad_cols.empty() and !unlocated) return std::make_pair(local, true);
+            if (attempt == opt.max_retries) break;
+
+            if (unlocated) {
+                local.unlocated++;
+                for (int tj = 0; tj < tn; tj++) bad_cols.insert(tj);
+            }
+            for (int tj : bad_cols) {
+                recomputed.insert(tj);
+                compute_tile(ti, tj);
+                local.tiles_recomputed++;
+                local.faulty_tiles.push_back({ti, tj});
+            }
+        }
+        return std::make_pair(local, false);
+    };
+
+    parallel_for(0, tm, [&](int lo, int hi) {
+        for (int ti = lo; ti < hi; ti++) {
+            auto [local, ok] = do_panel(ti);
+            std::lock_guard<std::mutex> lock(rep_mutex);
+            rep.tiles += local.tiles;
+            rep.rows_failed += local.rows_failed;
+            rep.tiles_recomputed += local.tiles_recomputed;
+            rep.unlocated += local.unlocated;
+            rep.faulty_tiles.insert(rep.faulty_tiles.end(), local.faulty_tiles.begin(), local.faulty_tiles.end());
+            rep.ok = rep.ok and ok;
+        }
+    }, opt.num_threads);
+
+    ///--- Финальная сверка столбцов: (e^T A) B против e^T C, O(mk + kn + mn)
+    if (opt.column_check) {
+        std::vector<T> ea(k, T{});
+        std::vector<double> abs_ea(k, 0.0);
+        for (int i = 0; i < m; i++)
+            for (int p = 0; p < k; p++) {
+                ea[p] += A(i, p);
+                abs_ea[p] += std::abs(A(i, p));
+            }
+        std::vector<T> ref(n, T{}), col(n, T{});
+        std::vector<double> bnd(n, 0.0), cabs(n, 0.0);
+        for (int p = 0; p < k; p++)
+            for (int j = 0; j < n; j++) {
+                ref[j] += ea[p] * B(p, j);
+                bnd[j] += abs_ea[p] * std::abs(B(p, j));
+            }
+        for (int i = 0; i < m; i++)
+            for (int j = 0; j < n; j++) {
+                col[j] += C(i, j);
+                cabs[j] += std::abs(C(i, j));
+            }
+        for (int j = 0; j < n; j++) {
+            double d = std::abs(col[j] - ref[j]);
+            double tol = opt.tol_factor * eps * ((double)k * bnd[j] + (double)m * cabs[j]);
+            if (!(d == d and d <= tol)) rep.column_check_passed = false;
+        }
+        rep.ok = rep.ok and rep.column_check_passed;
+    }
+
+    if (cnt) {
+        // Сами тайлы + эталоны и проверки (без пересчётов)
+        uint64_t prod = (uint64_t)m * n * k;
+        uint64_t checks = 2ull * k * n + 2ull * m * k + 2ull * m * n
+                        + (opt.column_check ? (uint64_t)m * k + (uint64_t)k * n + (uint64_t)m * n : 0);
+        cnt->mul += prod + checks;
+        cnt->add += prod + checks;
+    }
+    return rep;
+}
+
+template <class T>
+AbftReport mul_abft(const Matrix<T>& A, const Matrix<T>& B, Matrix<T>& C,
+                    const AbftOptions& opt = {},
+                    const AbftFaultHook<T>& inject = nullptr,
+                    OpCounter* cnt = nullptr) {
+    C.resize(A.rows, B.cols);
+    return mul_abft_view<T>(view(A), view(B), view(C), opt, inject, cnt);
+}
+
+#endif // ALG_ABFT_H
@@ -8,14 +8,13 @@
 #include "structures.h"
 #include <complex>
 
-template <class T>
-void alphaevolve_4x4_complex(const Matrix<T>& A,
-                             const Matrix<T>& B,
-                             Matrix<T>& C,
-                             OpCounter* cnt = nullptr)
+// Ядро на любых аксессорах 4x4 (Matrix, MatrixView, FixedMatrix) - без копирования
+template <class AA, class BB, class CC>
+void alphaevolve_4x4_core(const AA& A,
+                          const BB& B,
+                          CC&& C,
+                          OpCounter* cnt = nullptr)
 {
-    C.resize(4,4);
-
     using Complex = std::complex<double>;
 
     auto mul_ = [&](const Complex& x, const Complex& y) -> Complex {
@@ -199,4 +198,14 @@ void alphaevolve_4x4_complex(const Matrix<T>& A,
     }
 }
 
+template <class T>
+void alphaevolve_4x4_complex(const Matrix<T>& A,
+                             const Matrix<T>& B,
+                             Matrix<T>& C,
+                             OpCounter* cnt = nullptr)
+{
+    C.resize(4,4);
+    alphaevolve_4x4_core(A, B, C, cnt);
+}
+
 #endif // ALG_ALPHA_EVOLVE_4X4_COMPLEX_H
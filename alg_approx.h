@@ -0,0 +1,289 @@
+//
+// Приближённое умножение с заданной относительной ошибкой (рандомизированная линейная алгебра)
+// Все методы сводят внутреннее измерение k к s << k: C ~ (A S)(S^T B), где S - k x s.
+//   SAMPLING    - выборка s столбцов A / строк B с вероятностями ~ |A(:,t)| |B(t,:)|
+//   GAUSSIAN    - плотный гауссов скетч, S(t, c) ~ N(0, 1/s)
+//   SPARSE_SIGN - разреженный скетч: у каждой строки S sparsity ненулей +-1/sqrt(sparsity)
+// s выбирается по целевой ошибке rel_error (в норме Фробениуса, в среднеквадратичном)
+// из известных оценок дисперсии; ||AB||_F оценивается случайными пробами до умножения,
+// а после умножения те же пробы дают апостериорную оценку ||AB - C||_F / ||AB||_F.
+//
+
+#ifndef ALG_APPROX_H
+#define ALG_APPROX_H
+
+#include "structures.h"
+#include "generators.h"
+#include "alg_transpose.h"
+#include "workspace.h"
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include <vector>
+
+enum class ApproxMethod {
+    SAMPLING,
+    GAUSSIAN,
+    SPARSE_SIGN
+};
+
+struct ApproxOptions {
+    ApproxMethod method = ApproxMethod::SAMPLING;
+    double rel_error = 0.1;   // целевая относительная ошибка ||AB - C||_F / ||AB||_F
+    int samples = 0;          // > 0 - задать s явно, rel_error тогда не используется
+    int probes = 8;           // случайных векторов для оценки норм
+    int sparsity = 2;         // ненулей на строку для SPARSE_SIGN
+    uint64_t seed = 1;
+};
+
+struct ApproxReport {
+    int samples = 0;                // выбранное s
+    bool exact = false;             // s >= k - посчитано точно
+    double predicted_error = 0.0;   // априорная оценка для выбранного s
+    double estimated_error = 0.0;   // апостериорная оценка по пробам
+    double norm_estimate = 0.0;     // оценка ||AB||_F
+};
+
+///--------------------------
+///  Оценка норм пробами
+///--------------------------
+// Для гауссовых g: E||X g||^2 = ||X||_F^2. Возвращает оценки ||AB||_F^2 и,
+// если C передана, ||AB - C||_F^2 (по тем же g).
+template <class T>
+std::pair<double, double> probe_norms(MatrixView<const T> A, MatrixView<const T> B, const MatrixView<const T>* C,
+                                      int probes, uint64_t seed, OpCounter* cnt = nullptr) {
+    int m = A.rows, k = A.cols, n = B.cols;
+    std::vector<T> g(n), y(k);
+    double ab2 = 0.0, err2 = 0.0;
+
+    for (int q = 0; q < probes; q++) {
+        for (int j = 0; j < n; j++) g[j] = T(rand_normal_at(seed, q, j));
+        for (int p = 0; p < k; p++) {
+            T s = T{};
+            for (int j = 0; j < n; j++) s += B(p, j) * g[j];
+            y[p] = s;
+        }
+        for (int i = 0; i < m; i++) {
+            T z = T{};
+            for (int p = 0; p < k; p++) z += A(i, p) * y[p];
+            double a = std::abs(z);
+            ab2 += a * a;
+            if (C) {
+                T w = T{};
+                for (int j = 0; j < n; j++) w += (*C)(i, j) * g[j];
+                double e = std::abs(z - w);
+                err2 += e * e;
+            }
+        }
+    }
+
+    if (cnt) {
+        uint64_t ops = (uint64_t)probes * ((uint64_t)k * n + (uint64_t)m * k + (C ? (uint64_t)m * n : 0));
+        cnt->mul += ops;
+        cnt->add += ops;
+    }
+    return {ab2 / std::max(probes, 1), err2 / std::max(probes, 1)};
+}
+
+// Апостериорная относительная ошибка готового C
+template <class T>
+double estimate_relative_error(const Matrix<T>& A, const Matrix<T>& B, const Matrix<T>& C,
+                               int probes = 8, uint64_t seed = 7) {
+    MatrixView<const T> Cv = view(C);
+    auto [ab2, err2] = probe_norms<T>(view(A), view(B), &Cv, probes, seed);
+    return ab2 > 0 ? std::sqrt(err2 / ab2) : std::sqrt(err2);
+}
+
+///--------------------------
+///  Скетчи
+///--------------------------
+// Все три метода строят As = A S (m x s) и Bts = B^T S (n x s), затем C = As * Bts^T.
+
+// Выборка по вероятностям p_t = w_t / sum w, w_t = |A(:,t)| |B(t,:)|; масштаб 1/sqrt(s p_t)
+template <class T>
+void sketch_sampling(MatrixView<const T> A, MatrixView<const T> B, const std::vector<double>& w, double wsum,
+                     int s, uint64_t seed, MatrixView<T> As, MatrixView<T> Bts, OpCounter* cnt) {
+    int k = A.cols;
+    std::vector<double> cdf(k);
+    double acc = 0.0;
+    for (int t = 0; t < k; t++) {
+        acc += w[t];
+        cdf[t] = acc;
+    }
+
+    for (int l = 0; l < s; l++) {
+        double u = bits_to_unit(counter_bits(seed, l, 0, 6)) * wsum;
+        int t = (int)(std::upper_bound(cdf.begin(), cdf.end(), u) - cdf.begin());
+        t = std::min(t, k - 1);
+        while (t > 0 and w[t] == 0.0) t--;  // на краю округления не выбираем нулевой вес
+        T scale = T(1.0 / std::sqrt(s * (w[t] / wsum)));
+        for (int i = 0; i < A.rows; i++) As(i, l) = A(i, t) * scale;
+        for (int j = 0; j < B.cols; j++) Bts(j, l) = B(t, j) * scale;
+    }
+    if (cnt) cnt->mul += (uint64_t)s * (A.rows + B.cols);
+}
+
+// Плотный гауссов S (k x s) во временном буфере, затем два потоковых прохода
+template <class T>
+void sketch_gaussian(MatrixView<const T> A, MatrixView<const T> B, int s, uint64_t seed,
+                     MatrixView<T> As, MatrixView<T> Bts, Workspace& ws, OpCounter* cnt) {
+    int m = A.rows, k = A.cols, n = B.cols;
+    T* S = ws.alloc<T>((size_t)k * s);
+    double inv = 1.0 / std::sqrt((double)s);
+    for (int t = 0; t < k; t++)
+        for (int c = 0; c < s; c++)
+            S[(size_t)t * s + c] = T(rand_normal_at(seed, t, c) * inv);
+
+    for (int i = 0; i < m; i++) {
+        for (int c = 0; c < s; c++) As(i, c) = T{};
+        for (int t = 0; t < k; t++) {
+            const T a = A(i, t);
+            const T* srow = S + (size_t)t * s;
+            for (int c = 0; c < s; c++) As(i, c) += a * srow[c];
+        }
+    }
+    for (int j = 0; j < n; j++)
+        for (int c = 0; c < s; c++) Bts(j, c) = T{};
+    for (int t = 0; t < k; t++) {
+        const T* srow = S + (size_t)t * s;
+        for (int j = 0; j < n; j++) {
+            const T b = B(t, j);
+            for (int c = 0; c < s; c++) Bts(j, c) += b * srow[c];
+        }
+    }
+    if (cnt) {
+        cnt->mul += (uint64_t)(m + n) * k * s;
+        cnt->add += (uint64_t)(m + n) * k * s;
+    }
+}
+
+// Разреженный знаковый скетч: строка t уходит в sparsity корзин со знаками
+template <class T>
+void sketch_sparse_sign(MatrixView<const T> A, MatrixView<const T> B, int s, int sparsity, uint64_t seed,
+                        MatrixView<T> As, MatrixView<T> Bts, OpCounter* cnt) {
+    int m = A.rows, k = A.cols, n = B.cols;
+    double inv = 1.0 / std::sqrt((double)sparsity);
+
+    for (int i = 0; i < m; i++)
+        for (int c = 0; c < s; c++) As(i, c) = T{};
+    for (int j = 0; j < n; j++)
+        for (int c = 0; c < s; c++) Bts(j, c) = T{};
+
+    for (int t = 0; t < k; t++) {
+        for (int l = 0; l < sparsity; l++) {
+            uint64_t h = counter_bits(seed, t, l, 3);
+            int c = (int)(h % (uint64_t)s);
+            T v = T((h >> 63) ? -inv : inv);
+            for (int i = 0; i < m; i++) As(i, c) += A(i, t) * v;
+            for (int j = 0; j < n; j++) Bts(j, c) += B(t, j) * v;
+        }
+    }
+    if (cnt) {
+        cnt->mul += (uint64_t)(m + n) * k * sparsity;
+        cnt->add += (uint64_t)(m + n) * k * sparsity;
+    }
+}
+
+///--------------------------
+///  Интерфейс
+///--------------------------
+template <class T>
+ApproxReport mul_approx_view(MatrixView<const T> A, MatrixView<const T> B, MatrixView<T> C,
+                             const ApproxOptions& opt = {},
+                             OpCounter* cnt = nullptr,
+                             Workspace* ws = nullptr) {
+    static_assert(!std::is_integral_v<T>, "approximate multiplication needs a floating-point type");
+    assert(A.cols == B.rows);
+    assert(A.rows == C.rows and B.cols == C.cols);
+
+    int m = A.rows, k = A.cols, n = B.cols;
+    if (ws == nullptr) ws = &thread_workspace();
+    Workspace::Scope scope(*ws);
+    ApproxReport rep;
+
+    // Нормы столбцов A и строк B: веса выборки и ||A||_F, ||B||_F
+    std::vector<double> w(k);
+    double a2 = 0.0, b2 = 0.0, wsum = 0.0;
+    {
+        std::vector<double> ca(k, 0.0);
+        for (int i = 0; i < m; i++)
+            for (int t = 0; t < k; t++) {
+                double x = std::abs(A(i, t));
+                ca[t] += x * x;
+            }
+        for (int t = 0; t < k; t++) {
+            double rb = 0.0;
+            for (int j = 0; j < n; j++) {
+                double x = std::abs(B(t, j));
+                rb += x * x;
+            }
+            a2 += ca[t];
+            b2 += rb;
+            w[t] = std::sqrt(ca[t] * rb);
+            wsum += w[t];
+        }
+    }
+
+    double ab2 = probe_norms<T>(A, B, nullptr, opt.probes, opt.seed ^ 0x5EED, cnt).first;
+    rep.norm_estimate = std::sqrt(ab2);
+    // Для выбора s берём осторожную (заниженную) оценку ||AB||_F^2: при малом числе
+    // проб её разброс ~ sqrt(2 / probes), а переоценка нормы дала бы слишком малое s
+    double ab2_low = ab2 / (1.0 + 2.0 * std::sqrt(2.0 / std::max(opt.probes, 1)));
+
+    // Дисперсия на одну выборку: E||AB - C||_F^2 = var1 / s
+    double var1 = opt.method == ApproxMethod::SAMPLING ? std::max(wsum * wsum - ab2_low, 0.0)
+                                                       : a2 * b2 + ab2_low;
+    int s = opt.samples;
+    if (s <= 0) {
+        double target2 = opt.rel_error * opt.rel_error * ab2_low;
+        s = target2 > 0 ? (int)std::min<double>(std::ceil(var1 / target2), (double)k) : k;
+    }
+    s = std::max(1, s);
+
+    // Стоимость скетча в умножениях против m*n*k у точного произведения
+    // (явно заданное s не пересматриваем - это нужно для кривых скорость/ошибка)
+    double sketch_cost = (double)m * n * s;
+    if (opt.method == ApproxMethod::GAUSSIAN) sketch_cost += (double)(m + n) * k * s;
+    if (opt.method == ApproxMethod::SPARSE_SIGN) sketch_cost += (double)(m + n) * k * std::max(1, opt.sparsity);
+
+    if (s >= k or wsum == 0.0 or (opt.samples <= 0 and sketch_cost >= (double)m * n * k)) {
+        // Скетч не дешевле точного произведения
+        rep.samples = k;
+        rep.exact = true;
+        mul_naive_transposed_view<T>(A, B, C, cnt, ws);
+        return rep;
+    }
+
+    rep.samples = s;
+    rep.predicted_error = ab2_low > 0 ? std::sqrt(var1 / s / ab2_low) : 0.0;
+
+    MatrixView<T> As(ws->alloc<T>((size_t)m * s), m, s, s);
+    MatrixView<T> Bts(ws->alloc<T>((size_t)n * s), n, s, s);
+    switch (opt.method) {
+        case ApproxMethod::SAMPLING:
+            sketch_sampling<T>(A, B, w, wsum, s, opt.seed, As, Bts, cnt);
+            break;
+        case ApproxMethod::GAUSSIAN:
+            sketch_gaussian<T>(A, B, s, opt.seed, As, Bts, *ws, cnt);
+            break;
+        case ApproxMethod::SPARSE_SIGN:
+            sketch_sparse_sign<T>(A, B, s, std::max(1, opt.sparsity), opt.seed, As, Bts, cnt);
+            break;
+    }
+    mul_naive_bt_view<T>(As, Bts, C, cnt);
+
+    MatrixView<const T> Cv = C;
+    auto [ab2_post, err2] = probe_norms<T>(A, B, &Cv, opt.probes, opt.seed ^ 0xC0FFEE, cnt);
+    rep.estimated_error = ab2_post > 0 ? std::sqrt(err2 / ab2_post) : std::sqrt(err2);
+    return rep;
+}
+
+template <class T>
+ApproxReport mul_approx(const Matrix<T>& A, const Matrix<T>& B, Matrix<T>& C,
+                        const ApproxOptions& opt = {},
+                        OpCounter* cnt = nullptr) {
+    C.resize(A.rows, B.cols);
+    return mul_approx_view<T>(view(A), view(B), view(C), opt, cnt);
+}
+
+#endif // ALG_APPROX_H
@@ -0,0 +1,223 @@
+//
+// Асинхронное умножение и конвейер подготовки панелей
+// mul_pipelined: B делится на блоки по NC столбцов (блок - k x NC, упакованный
+// панелями по NR, как в alg_semiring.h). Пока потоки считают блок b из одного буфера,
+// вспомогательный поток упаковывает блок b + 1 во второй. На критическом пути остаётся
+// только упаковка первого блока. A читается на месте: строки и так идут подряд.
+// MulEngine: очередь произведений с future; произведения выполняются по одному
+// (каждое на всех num_threads потоках), вызывающий поток свободен до get().
+//
+
+#ifndef ALG_ASYNC_H
+#define ALG_ASYNC_H
+
+#include "structures.h"
+#include "epilogue.h"
+#include "workspace.h"
+#include "semiring.h"
+#include "alg_semiring.h"
+#include "thread_pool.h"
+#include "trace.h"
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+///--------------------------
+///  Конвейер панелей
+///--------------------------
+static constexpr size_t PIPELINE_BLOCK_BYTES = 512 * 1024;  // упакованный блок B ~ L2
+
+// Два буфера: блок b лежит в слоте b % 2. Вспомогательный поток не уходит
+// больше чем на один блок вперёд, вычисление не начинает блок, пока он не упакован.
+class PanelPipeline {
+public:
+    // Блок b упакован, его можно считать
+    void wait_packed(int b) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [&] { return packed_ > b; });
+    }
+
+    void set_packed(int b) { publish(packed_, b + 1); }
+
+    // Слот под блок b свободен: блок b - 2 посчитан
+    void wait_free(int b) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [&] { return consumed_ >= b - 1; });
+    }
+
+    void set_consumed(int b) { publish(consumed_, b + 1); }
+
+private:
+    void publish(int& counter, int value) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            counter = value;
+        }
+        cv_.notify_all();
+    }
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    int packed_ = 0, consumed_ = 0;
+};
+
+// Столбцов B в блоке: кратно nr, блок k x NC около PIPELINE_BLOCK_BYTES
+inline int pipeline_block_cols(int k, int n, int nr, size_t elem_bytes) {
+    size_t per_col = std::max<size_t>(1, (size_t)k * elem_bytes);
+    int nc = (int)std::min<size_t>((size_t)n, PIPELINE_BLOCK_BYTES / per_col);
+    nc = std::max(nr, nc / nr * nr);
+    return nc;
+}
+
+// C(i, j) = ep(i, j, ⊕_p A(i, p) ⊗ B(p, j)) - то же, что mul_semiring_view,
+// но упаковка B перекрывается с вычислением
+template <class S, class T = typename S::value_type, class U = T, class Ep = EpIdentity>
+void mul_pipelined_view(MatrixView<const T> A, MatrixView<const T> B, MatrixView<U> C,
+                        const Ep& ep = Ep{},
+                        OpCounter* cnt = nullptr,
+                        int num_threads = 0,
+                        Workspace* ws = nullptr) {
+    static_assert(std::is_same_v<T, typename S::value_type>, "semiring value type mismatch");
+    assert(A.cols == B.rows);
+    assert(A.rows == C.rows and B.cols == C.cols);
+
+    using Ops = SemiKernelOps<S>;
+    constexpr int NV = Ops::W == 1 ? 4 : 2;
+    constexpr int NR = NV * Ops::W;
+    const int m = A.rows, k = A.cols, n = B.cols;
+    if (m == 0 or n == 0) return;
+
+    const int nc = pipeline_block_cols(k, n, NR, sizeof(T));
+    const int blocks = (n + nc - 1) / nc;
+    const int block_panels = nc / NR;
+
+    if (ws == nullptr) ws = &thread_workspace();
+    Workspace::Scope scope(*ws);
+    T* slots[2];
+    slots[0] = ws->alloc<T>((size_t)block_panels * k * NR);
+    slots[1] = blocks > 1 ? ws->alloc<T>((size_t)block_panels * k * NR) : nullptr;
+
+    // Панели [lo, hi) блока b -> slot; панель jp: B(p, j0 + t) -> dst[(jp * k + p) * NR + t]
+    auto pack_panels = [&](int b, T* slot, int lo, int hi) {
+        MATMUL_TRACE_SCOPE(PACK);
+        for (int jp = lo; jp < hi; jp++) {
+            T* dst = slot + (size_t)jp * k * NR;
+            int j0 = b * nc + jp * NR, w = std::max(0, std::min(NR, n - j0));
+            for (int p = 0; p < k; p++) {
+                for (int t = 0; t < w; t++) dst[(size_t)p * NR + t] = B(p, j0 + t);
+                for (int t = w; t < NR; t++) dst[(size_t)p * NR + t] = S::zero();
+            }
+        }
+    };
+    auto panels_of = [&](int b) { return (std::min(n, (b + 1) * nc) - b * nc + NR - 1) / NR; };
+
+    PanelPipeline pipe;
+
+    // Первый блок упаковывают все потоки: его ждать всё равно придётся
+    parallel_for(0, panels_of(0), [&](int lo, int hi) { pack_panels(0, slots[0], lo, hi); },
+                 num_threads, 4);
+    pipe.set_packed(0);
+
+    std::thread helper;
+    if (blocks > 1) {
+        helper = std::thread([&] {
+            for (int b = 1; b < blocks; b++) {
+                pipe.wait_free(b);
+                pack_panels(b, slots[b % 2], 0, panels_of(b));
+                pipe.set_packed(b);
+            }
+        });
+    }
+
+    const int row_blocks = (m + SEMI_MR - 1) / SEMI_MR;
+    for (int b = 0; b < blocks; b++) {
+        pipe.wait_packed(b);
+        const T* slot = slots[b % 2];
+        const int panels = panels_of(b);
+        parallel_for(0, row_blocks, [&](int lo, int hi) {
+            for (int jp = 0; jp < panels; jp++)
+                semiring_panel_rows<S, NV>(A, slot + (size_t)jp * k * NR, b * nc + jp * NR, lo, hi, C, ep);
+        }, num_threads, 8);
+        pipe.set_consumed(b);
+    }
+
+    if (helper.joinable()) helper.join();
+
+    if (cnt) {
+        cnt->mul += (uint64_t)m * n * k;
+        cnt->add += (uint64_t)m * n * k;
+    }
+}
+
+template <class T>
+void mul_pipelined(const Matrix<T>& A, const Matrix<T>& B, Matrix<T>& C,
+                   OpCounter* cnt = nullptr, int num_threads = 0) {
+    assert(A.cols == B.rows);
+    C.resize(A.rows, B.cols);
+    mul_pipelined_view<PlusTimes<T>, T>(view(A), view(B), view(C), EpIdentity{}, cnt, num_threads);
+}
+
+///--------------------------
+///  Асинхронный API
+///--------------------------
+class MulEngine {
+public:
+    // num_threads - потоков на одно произведение (0 - все ядра)
+    // Деструктор дожидается всех поставленных произведений
+    explicit MulEngine(int num_threads = 0) : num_threads_(num_threads), queue_(1) {}
+
+    MulEngine(const MulEngine&) = delete;
+    MulEngine& operator=(const MulEngine&) = delete;
+
+    // C = A * B; A, B и C должны жить и не меняться до готовности future.
+    // C получает размер сразу, содержимое - к моменту готовности.
+    template <class T>
+    std::future<void> submit(const Matrix<T>& A, const Matrix<T>& B, Matrix<T>& C) {
+        assert(A.cols == B.rows);
+        C.resize(A.rows, B.cols);
+        int nt = num_threads_;
+        return queue_.submit([&A, &B, &C, nt] {
+            mul_pipelined_view<PlusTimes<T>, T>(view(A), view(B), view(C), EpIdentity{}, nullptr, nt);
+        });
+    }
+
+    // Вариант без требований к времени жизни: операнды разделяются, результат - в future
+    template <class T>
+    std::future<Matrix<T>> submit(std::shared_ptr<const Matrix<T>> A, std::shared_ptr<const Matrix<T>> B) {
+        assert(A and B and A->cols == B->rows);
+        int nt = num_threads_;
+        return queue_.submit([A = std::move(A), B = std::move(B), nt] {
+            Matrix<T> C;
+            mul_pipelined(*A, *B, C, nullptr, nt);
+            return C;
+        });
+    }
+
+    // Произвольная работа в той же очереди (например, цепочка из нескольких произведений)
+    template <class F>
+    auto enqueue(F&& f) { return queue_.submit(std::forward<F>(f)); }
+
+private:
+    int num_threads_;
+    ThreadPool queue_;  // один поток: произведения идут по порядку, без переподписки ядер
+};
+
+// Общая очередь процесса
+inline MulEngine& global_mul_engine() {
+    static MulEngine engine;
+    return engine;
+}
+
+template <class T>
+std::future<void> mul_async(const Matrix<T>& A, const Matrix<T>& B, Matrix<T>& C) {
+    return global_mul_engine().submit(A, B, C);
+}
+
+template <class T>
+std::future<Matrix<T>> mul_async(std::shared_ptr<const Matrix<T>> A, std::shared_ptr<const Matrix<T>> B) {
+    return global_mul_engine().submit(std::move(A), std::move(B));
+}
+
+#endif // ALG_ASYNC_H
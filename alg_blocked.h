@@ -7,10 +7,14 @@
 #define ALG_BLOCKED_H
 
 #include "structures.h"
+#include "fixed_matrix.h"
 #include "alg_naive.h"
 #include "alg_winograd_4x4.h"
 #include "alg_alpha_evolve_4x4_complex.h"
 #include "alg_strassen_4x4.h"
+#include "epilogue.h"
+#include "workspace.h"
+#include "trace.h"
 
 // Вспомогательная функция: умножение 4x4 блоков naive
 template <class T>
@@ -20,7 +24,8 @@ void kernel_naive_4x4(MatrixView<const T> A, MatrixView<const T> B,
     assert(B.rows == 4 && B.cols == 4);
     assert(C.rows == 4 && C.cols == 4);
 
-    mul_naive_view(A, B, C, cnt);
+    // Развёрнутое ядро прямо на view: блок целиком в регистрах
+    mul_fixed_view<T, 4, 4, 4>(A, B, C, cnt);
 }
 
 // Вспомогательная функция: умножение 4x4 блоков Winograd
@@ -32,19 +37,8 @@ void kernel_winograd_4x4(MatrixView<const T> A, MatrixView<const T> B,
     assert(C.rows == 4 && C.cols == 4);
 
 
-    // Пока используем временные матрицы
-    Matrix<T> Am(4,4), Bm(4,4), Cm(4,4);
-    for(int i=0; i<4; i++)
-        for(int j=0; j<4; j++) {
-            Am(i,j) = A(i,j);
-            Bm(i,j) = B(i,j);
-        }
-
-    mul_winograd_4x4(Am, Bm, Cm, cnt);
-
-    for(int i=0; i<4; i++)
-        for(int j=0; j<4; j++)
-            C(i,j) = Cm(i,j);
+    // Ядро читает блоки прямо из view, без временных матриц
+    winograd_4x4_core<T>(A, B, C, cnt);
 }
 
 // Вспомогательная функция: умножение 4x4 блоков AlphaEvolve
@@ -56,19 +50,8 @@ void kernel_alphaevolve_4x4(MatrixView<const T> A, MatrixView<const T> B,
     assert(C.rows == 4 && C.cols == 4);
 
 
-    // Пока используем временные матрицы
-    Matrix<T> Am(4,4), Bm(4,4), Cm(4,4);
-    for(int i=0; i<4; i++)
-        for(int j=0; j<4; j++) {
-            Am(i,j) = A(i,j);
-            Bm(i,j) = B(i,j);
-        }
-
-    alphaevolve_4x4_complex(Am, Bm, Cm, cnt);
-
-    for(int i=0; i<4; i++)
-        for(int j=0; j<4; j++)
-            C(i,j) = Cm(i,j);
+    // Ядро читает блоки прямо из view, без временных матриц
+    alphaevolve_4x4_core(A, B, C, cnt);
 }
 
 // Вспомогательная функция: умножение 4x4 блоков Strassen
@@ -90,24 +73,29 @@ enum class BlockKernel {
     STRASSEN
 };
 
-// Blocked multiply: делит матрицу на блоки 4x4 и умножает их выбранным ядром
+// Рабочая область, нужная mul_blocked_view: один временный блок BS x BS
 template <class T>
-void mul_blocked(const Matrix<T>& A, const Matrix<T>& B, Matrix<T>& C,
-                 BlockKernel kernel = BlockKernel::NAIVE,
-                 OpCounter* cnt = nullptr) {
-
-    assert(A.cols == B.rows);
+size_t mul_blocked_workspace_bytes(int /*m*/, int /*k*/, int /*n*/) {
+    return Workspace::aligned_size(4 * 4 * sizeof(T));
+}
 
-    int m = A.rows;  // строки A
-    int k = A.cols;  // столбцы A = строки B
-    int n = B.cols;  // столбцы B
+// Blocked multiply на view: делит матрицу на блоки 4x4 и умножает их выбранным ядром.
+// Каждый тайл C накапливается в локальном буфере и записывается один раз через эпилог
+// ep(i, j, x) - координаты относительно C, результат приводится к типу U.
+// Временные буферы берутся из ws (по умолчанию - арена текущего потока).
+template <class T, class U, class Ep = EpIdentity>
+void mul_blocked_view(MatrixView<const T> A_view, MatrixView<const T> B_view, MatrixView<U> C_view,
+                      BlockKernel kernel = BlockKernel::NAIVE,
+                      const Ep& ep = Ep{},
+                      OpCounter* cnt = nullptr,
+                      Workspace* ws = nullptr) {
 
-    C.resize(m, n);
+    assert(A_view.cols == B_view.rows);
+    assert(A_view.rows == C_view.rows and B_view.cols == C_view.cols);
 
-    // Обнуляем результат
-    for(int i=0; i<m; i++)
-        for(int j=0; j<n; j++)
-            C(i,j) = T{};
+    int m = A_view.rows;  // строки A
+    int k = A_view.cols;  // столбцы A = строки B
+    int n = B_view.cols;  // столбцы B
 
     // Размер блока
     const int BS = 4;
@@ -117,10 +105,10 @@ void mul_blocked(const Matrix<T>& A, const Matrix<T>& B, Matrix<T>& C,
     int num_blocks_k = (k + BS - 1) / BS;  // количество блоков по столбцам A / строкам B
     int num_blocks_n = (n + BS - 1) / BS;  // количество блоков по столбцам B/C
 
-    // Создаем views для работы с подматрицами
-    auto A_view = view(A);
-    auto B_view = view(B);
-    auto C_view = view(C);
+    // Временный блок для результата умножения блоков - один на весь вызов
+    if (ws == nullptr) ws = &thread_workspace();
+    Workspace::Scope scope(*ws);
+    T* temp_data = ws->alloc<T>(BS * BS);
 
     // Блочное умножение: C = A * B
     // C[bi, bj] = sum_bp (A[bi, bp] * B[bp, bj])
@@ -132,66 +120,105 @@ void mul_blocked(const Matrix<T>& A, const Matrix<T>& B, Matrix<T>& C,
             int c_rows = std::min(BS, m - c_row_start);
             int c_cols = std::min(BS, n - c_col_start);
 
-            // Итерация по промежуточным блокам
-            for (int bp = 0; bp < num_blocks_k; bp++) {
-                // Размеры блока A[bi, bp]
-                int a_row_start = bi * BS;
-                int a_col_start = bp * BS;
-                int a_rows = std::min(BS, m - a_row_start);
-                int a_cols = std::min(BS, k - a_col_start);
-
-                // Размеры блока B[bp, bj]
-                int b_row_start = bp * BS;
-                int b_col_start = bj * BS;
-                int b_rows = std::min(BS, k - b_row_start);
-                int b_cols = std::min(BS, n - b_col_start);
-
-                // Извлекаем subviews
-                auto A_block = subview(A_view, a_row_start, a_col_start, a_rows, a_cols);
-                auto B_block = subview(B_view, b_row_start, b_col_start, b_rows, b_cols);
-                auto C_block = subview(C_view, c_row_start, c_col_start, c_rows, c_cols);
-
-                // Временная матрица для результата умножения блоков
-                Matrix<T> temp_result(c_rows, c_cols);
-                for(int ti=0; ti<c_rows; ti++)
-                    for(int tj=0; tj<c_cols; tj++)
-                        temp_result(ti, tj) = T{};
-
-                auto temp_view = view(temp_result);
-
-                // Выбираем ядро и умножаем блоки
-                if (a_rows == BS && a_cols == BS && b_rows == BS && b_cols == BS && c_rows == BS && c_cols == BS) {
-                    // Полные блоки 4x4 - используем выбранное ядро
-                    switch(kernel) {
-                        case BlockKernel::NAIVE:
-                            kernel_naive_4x4(A_block, B_block, temp_view, cnt);
-                            break;
-                        case BlockKernel::WINOGRAD:
-                            kernel_winograd_4x4(A_block, B_block, temp_view, cnt);
-                            break;
-                        case BlockKernel::ALPHAEVOLVE:
-                            kernel_alphaevolve_4x4(A_block, B_block, temp_view, cnt);
-                            break;
-                        case BlockKernel::STRASSEN:
-                            kernel_strassen_4x4(A_block, B_block, temp_view, cnt);
-                            break;
+            // Аккумулятор тайла C[bi, bj] - живёт на стеке, пока тайл в кэше
+            T acc_data[BS * BS];
+            MatrixView<T> acc(acc_data, c_rows, c_cols, BS);
+            for(int ti=0; ti<c_rows; ti++)
+                for(int tj=0; tj<c_cols; tj++)
+                    acc(ti, tj) = T{};
+
+            {
+                // Весь проход по bp - одно событие трассировки на тайл: тайл у края C - граничный
+                MATMUL_TRACE_SCOPE_PHASE(c_rows == BS and c_cols == BS ? TracePhase::KERNEL : TracePhase::BOUNDARY);
+
+                // Итерация по промежуточным блокам
+                for (int bp = 0; bp < num_blocks_k; bp++) {
+                    // Размеры блока A[bi, bp]
+                    int a_row_start = bi * BS;
+                    int a_col_start = bp * BS;
+                    int a_rows = std::min(BS, m - a_row_start);
+                    int a_cols = std::min(BS, k - a_col_start);
+
+                    // Размеры блока B[bp, bj]
+                    int b_row_start = bp * BS;
+                    int b_col_start = bj * BS;
+                    int b_rows = std::min(BS, k - b_row_start);
+                    int b_cols = std::min(BS, n - b_col_start);
+
+                    // Извлекаем subviews
+                    auto A_block = subview(A_view, a_row_start, a_col_start, a_rows, a_cols);
+                    auto B_block = subview(B_view, b_row_start, b_col_start, b_rows, b_cols);
+
+                    // Временный блок для результата умножения блоков
+                    MatrixView<T> temp_view(temp_data, c_rows, c_cols, BS);
+                    for(int ti=0; ti<c_rows; ti++)
+                        for(int tj=0; tj<c_cols; tj++)
+                            temp_view(ti, tj) = T{};
+
+                    // Выбираем ядро и умножаем блоки
+                    if (a_rows == BS && a_cols == BS && b_rows == BS && b_cols == BS && c_rows == BS && c_cols == BS) {
+                        // Полные блоки 4x4 - используем выбранное ядро
+                        switch(kernel) {
+                            case BlockKernel::NAIVE:
+                                kernel_naive_4x4(A_block, B_block, temp_view, cnt);
+                                break;
+                            case BlockKernel::WINOGRAD:
+                                kernel_winograd_4x4(A_block, B_block, temp_view, cnt);
+                                break;
+                            case BlockKernel::ALPHAEVOLVE:
+                                kernel_alphaevolve_4x4(A_block, B_block, temp_view, cnt);
+                                break;
+                            case BlockKernel::STRASSEN:
+                                kernel_strassen_4x4(A_block, B_block, temp_view, cnt);
+                                break;
+                        }
+                    } else {
+                        // Граничные блоки - используем naive
+                        mul_naive_view(A_block, B_block, temp_view, cnt);
                     }
-                } else {
-                    // Граничные блоки - используем naive
-                    mul_naive_view(A_block, B_block, temp_view, cnt);
-                }
 
-                // Добавляем результат к блоку C[bi, bj]
-                for(int ti=0; ti<c_rows; ti++) {
-                    for(int tj=0; tj<c_cols; tj++) {
-                        C_block(ti, tj) = add(C_block(ti, tj), temp_result(ti, tj), cnt);
+                    // Добавляем результат к аккумулятору тайла
+                    for(int ti=0; ti<c_rows; ti++) {
+                        for(int tj=0; tj<c_cols; tj++) {
+                            acc(ti, tj) = add(acc(ti, tj), temp_view(ti, tj), cnt);
+                        }
                     }
                 }
             }
+
+            // Тайл готов: единственная запись в C, сразу с эпилогом
+            MATMUL_TRACE_SCOPE(WRITE_BACK);
+            auto C_block = subview(C_view, c_row_start, c_col_start, c_rows, c_cols);
+            for(int ti=0; ti<c_rows; ti++) {
+                for(int tj=0; tj<c_cols; tj++) {
+                    C_block(ti, tj) = static_cast<U>(ep(c_row_start + ti, c_col_start + tj, acc(ti, tj)));
+                }
+            }
         }
     }
 }
 
+// Blocked multiply с эпилогом: C(i, j) = ep(i, j, (A*B)(i, j)), C может иметь другой тип
+template <class T, class U, class Ep>
+void mul_blocked_ep(const Matrix<T>& A, const Matrix<T>& B, Matrix<U>& C,
+                    const Ep& ep,
+                    BlockKernel kernel = BlockKernel::NAIVE,
+                    OpCounter* cnt = nullptr,
+                    Workspace* ws = nullptr) {
+    assert(A.cols == B.rows);
+    C.resize(A.rows, B.cols);
+    mul_blocked_view(view(A), view(B), view(C), kernel, ep, cnt, ws);
+}
+
+// Blocked multiply: делит матрицу на блоки 4x4 и умножает их выбранным ядром
+template <class T>
+void mul_blocked(const Matrix<T>& A, const Matrix<T>& B, Matrix<T>& C,
+                 BlockKernel kernel = BlockKernel::NAIVE,
+                 OpCounter* cnt = nullptr,
+                 Workspace* ws = nullptr) {
+    mul_blocked_ep(A, B, C, EpIdentity{}, kernel, cnt, ws);
+}
+
 // Wrapper функции для удобного вызова
 template <class T>
 void mul_blocked_naive_kernel(const Matrix<T>& A, const Matrix<T>& B, Matrix<T>& C,
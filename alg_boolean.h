@@ -0,0 +1,214 @@
+//
+// Булево умножение (OR, AND) на упакованных матрицах BitMatrix
+// C(i, :) = OR по p : A(i, p) = 1 от B(p, :) - строка C собирается
+// пословными OR строк B, по 64 столбца за операцию (и 256 / 512 с SIMD).
+// mul_bool_m4rm - "метод четырёх русских": k режется на группы по 8 бит,
+// для каждой группы строится таблица всех 256 OR-комбинаций её строк B,
+// после чего каждая строка C обновляется одним OR на группу вместо восьми.
+// За проход строятся 8 таблиц (64 бита k - одно слово A), и строки C проходятся
+// один раз на слово. Очень широкие B режутся на полосы по M4RM_STRIP слов, чтобы таблицы сидели в L2.
+//
+
+#ifndef ALG_BOOLEAN_H
+#define ALG_BOOLEAN_H
+
+#include "bit_matrix.h"
+#include "parallel.h"
+#include "workspace.h"
+#include <cstdint>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+static constexpr int M4RM_GROUP = 8;          // бит k на таблицу (256 строк)
+static constexpr int M4RM_TABLES = 64 / M4RM_GROUP;  // таблиц на проход: одно слово A
+static constexpr int M4RM_STRIP = 64;         // слов столбцов на полосу: 8 таблиц 256 x 64 x 8 = 1 MB
+
+// dst |= src, n слов
+inline void bit_or_row(uint64_t* dst, const uint64_t* src, int n) {
+    int w = 0;
+#if defined(__AVX2__)
+    for (; w + 4 <= n; w += 4) {
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dst + w));
+        __m256i s = _mm256_loadu_si256((const __m256i*)(src + w));
+        _mm256_storeu_si256((__m256i*)(dst + w), _mm256_or_si256(d, s));
+    }
+#elif defined(__ARM_NEON)
+    for (; w + 2 <= n; w += 2) vst1q_u64(dst + w, vorrq_u64(vld1q_u64(dst + w), vld1q_u64(src + w)));
+#endif
+    for (; w < n; w++) dst[w] |= src[w];
+}
+
+///--------------------------
+///  Построчное умножение
+///--------------------------
+// Для каждого установленного бита p строки A(i, :) - OR строки B(p, :) в C(i, :)
+inline void mul_bool_rows(const BitMatrix& A, const BitMatrix& B, BitMatrix& C,
+                          OpCounter* cnt = nullptr, int num_threads = 0) {
+    assert(A.cols == B.rows);
+    C.resize(A.rows, B.cols);
+
+    parallel_for(0, A.rows, [&](int lo, int hi) {
+        for (int i = lo; i < hi; i++) {
+            const uint64_t* a = A.row(i);
+            uint64_t* c = C.row(i);
+            for (int w = 0; w < A.words; w++) {
+                uint64_t x = a[w];
+                while (x) {
+                    int p = w * 64 + __builtin_ctzll(x);
+                    bit_or_row(c, B.row(p), B.words);
+                    x &= x - 1;
+                }
+            }
+        }
+    }, num_threads, 16);
+
+    if (cnt) cnt->add += (uint64_t)A.count() * B.words;
+}
+
+///--------------------------
+///  Четыре русских (M4RM)
+///--------------------------
+// table[mask] = table[mask без младшего бита] | B(p0 + младший бит, полоса)
+inline void m4rm_build_table(const BitMatrix& B, int p0, int w0, int sw, uint64_t* table) {
+    for (int t = 0; t < sw; t++) table[t] = 0;
+    for (int mask = 1; mask < 256; mask++) {
+        uint64_t* dst = table + (size_t)mask * sw;
+        const uint64_t* prev = table + (size_t)(mask & (mask - 1)) * sw;
+        int p = p0 + __builtin_ctz(mask);
+        if (p < B.rows) {
+            const uint64_t* src = B.row(p) + w0;
+            for (int t = 0; t < sw; t++) dst[t] = prev[t] | src[t];
+        } else {
+            for (int t = 0; t < sw; t++) dst[t] = prev[t];
+        }
+    }
+}
+
+inline void mul_bool_m4rm(const BitMatrix& A, const BitMatrix& B, BitMatrix& C,
+                          OpCounter* cnt = nullptr, int num_threads = 0) {
+    assert(A.cols == B.rows);
+    C.resize(A.rows, B.cols);
+
+    const int m = A.rows, k = A.cols, nw = B.words;
+    const int groups = (k + M4RM_GROUP - 1) / M4RM_GROUP;
+
+    Workspace& ws = thread_workspace();
+    Workspace::Scope scope(ws);
+    uint64_t* tables = ws.alloc<uint64_t>((size_t)M4RM_TABLES * 256 * std::min(nw, M4RM_STRIP));
+
+    for (int w0 = 0; w0 < nw; w0 += M4RM_STRIP) {
+        const int sw = std::min(M4RM_STRIP, nw - w0);
+        // Проход - одно слово A (M4RM_TABLES групп): таблицы общие, строки C делятся между потоками
+        for (int g0 = 0; g0 < groups; g0 += M4RM_TABLES) {
+            const int nt = std::min(M4RM_TABLES, groups - g0);
+            parallel_for(0, nt, [&](int lo, int hi) {
+                for (int t = lo; t < hi; t++)
+                    m4rm_build_table(B, (g0 + t) * M4RM_GROUP, w0, sw, tables + (size_t)t * 256 * sw);
+            }, num_threads);
+
+            const int aw = g0 * M4RM_GROUP / 64;
+            parallel_for(0, m, [&](int lo, int hi) {
+                for (int i = lo; i < hi; i++) {
+                    uint64_t x = A.row(i)[aw];
+                    if (!x) continue;
+                    uint64_t* c = C.row(i) + w0;
+                    for (int t = 0; t < nt; t++) {
+                        unsigned byte = (unsigned)(x >> (t * M4RM_GROUP)) & 0xFFu;
+                        if (byte) bit_or_row(c, tables + ((size_t)t * 256 + byte) * sw, sw);
+                    }
+                }
+            }, num_threads, 64);
+        }
+    }
+
+    if (cnt) cnt->add += (uint64_t)groups * 255 * nw + (uint64_t)m * groups * nw;
+}
+
+// Выбор по числу OR строк B: построчно - по одному на единицу A,
+// M4RM - по одному на группу строки A плюс 255 на построение таблицы группы
+inline void mul_bool(const BitMatrix& A, const BitMatrix& B, BitMatrix& C,
+                     OpCounter* cnt = nullptr, int num_threads = 0) {
+    size_t groups = (size_t)(A.cols + M4RM_GROUP - 1) / M4RM_GROUP;
+    if (A.count() > (size_t)(A.rows + 255) * groups) mul_bool_m4rm(A, B, C, cnt, num_threads);
+    else mul_bool_rows(A, B, C, cnt, num_threads);
+}
+
+///--------------------------
+///  Число свидетелей
+///--------------------------
+// C(i, j) = |{p : A(i, p) and B(p, j)}| - число путей длины 2;
+// скалярные произведения AND + popcount строк A и строк B^T
+template <class T>
+void mul_bool_popcount(const BitMatrix& A, const BitMatrix& B, Matrix<T>& C,
+                       OpCounter* cnt = nullptr, int num_threads = 0) {
+    assert(A.cols == B.rows);
+    C.resize(A.rows, B.cols);
+    BitMatrix Bt = bit_transpose(B);
+
+    parallel_for(0, A.rows, [&](int lo, int hi) {
+        for (int i = lo; i < hi; i++) {
+            const uint64_t* a = A.row(i);
+            for (int j = 0; j < Bt.rows; j++) {
+                const uint64_t* b = Bt.row(j);
+                int s = 0;
+                for (int w = 0; w < A.words; w++) s += __builtin_popcountll(a[w] & b[w]);
+                C(i, j) = T(s);
+            }
+        }
+    }, num_threads, 16);
+
+    if (cnt) {
+        cnt->mul += (uint64_t)A.rows * B.cols * A.words;
+        cnt->add += (uint64_t)A.rows * B.cols * A.words;
+    }
+}
+
+///--------------------------
+///  Транзитивное замыкание
+///--------------------------
+enum class ClosureMethod {
+    SQUARING,   // R <- R | R R, пока меняется: O(log n) булевых произведений
+    WARSHALL,   // для каждого p: строки с битом p получают OR строки p - O(n^3 / 64)
+};
+
+// Достижимость по путям длины >= 1 (reflexive - длины >= 0)
+inline BitMatrix transitive_closure(const BitMatrix& A,
+                                    ClosureMethod method = ClosureMethod::SQUARING,
+                                    bool reflexive = false,
+                                    OpCounter* cnt = nullptr,
+                                    int num_threads = 0) {
+    assert(A.rows == A.cols);
+    const int n = A.rows;
+    BitMatrix R = A;
+    if (reflexive)
+        for (int i = 0; i < n; i++) R.set(i, i);
+
+    if (method == ClosureMethod::SQUARING) {
+        // После t шагов в R все пути длины до 2^t
+        BitMatrix P;
+        for (int len = 1; len < n; len *= 2) {
+            mul_bool(R, R, P, cnt, num_threads);
+            for (size_t w = 0; w < P.data.size(); w++) P.data[w] |= R.data[w];
+            if (P == R) break;
+            std::swap(R, P);
+        }
+    } else {
+        for (int p = 0; p < n; p++) {
+            const uint64_t* rp = R.row(p);
+            const uint64_t bit = 1ull << (p & 63);
+            parallel_for(0, n, [&](int lo, int hi) {
+                for (int i = lo; i < hi; i++)
+                    if (i != p and (R.row(i)[p >> 6] & bit)) bit_or_row(R.row(i), rp, R.words);
+            }, num_threads, 256);
+            if (cnt) cnt->add += (uint64_t)n * R.words;
+        }
+    }
+    return R;
+}
+
+#endif // ALG_BOOLEAN_H
@@ -0,0 +1,87 @@
+//
+// Кэш-независимое (cache-oblivious) рекурсивное умножение на Morton-хранении
+// Задача m x k x n (в тайлах) делится пополам по наибольшему из измерений, пока не
+// останется один тайл; рабочий набор на каждом уровне уменьшается, поэтому в какой-то
+// момент он ложится в любой уровень кэша без настройки размера блока под машину.
+// Деление по наибольшему измерению держит подзадачи близкими к кубу и для тонких форм.
+//
+
+#ifndef ALG_CACHE_OBLIVIOUS_H
+#define ALG_CACHE_OBLIVIOUS_H
+
+#include "structures.h"
+#include "morton_matrix.h"
+
+// C += A * B для непрерывных тайлов TS x TS; строка C копится в acc
+template <class T, int TS>
+inline void tile_mul_add(const T* A, const T* B, T* C) {
+    for (int i = 0; i < TS; i++) {
+        T acc[TS];
+        for (int j = 0; j < TS; j++) acc[j] = C[i * TS + j];
+        for (int p = 0; p < TS; p++) {
+            const T a = A[i * TS + p];
+            const T* b = B + p * TS;
+            for (int j = 0; j < TS; j++) acc[j] += a * b[j];
+        }
+        for (int j = 0; j < TS; j++) C[i * TS + j] = acc[j];
+    }
+}
+
+// Рекурсия по тайлам C[i0, i0 + gm) x [j0, j0 + gn) += A[.., k0 .. k0 + gk) * B;
+// gm, gn, gk - степени двойки, так что половины выровнены по квадрантам хранения.
+// Части целиком за границей матрицы (mt, nt, kt тайлов) пропускаются.
+template <class T, int TS>
+void co_mul_rec(const MortonMatrix<T, TS>& A, const MortonMatrix<T, TS>& B, MortonMatrix<T, TS>& C,
+                int i0, int j0, int k0, int gm, int gn, int gk, int mt, int nt, int kt) {
+    if (i0 >= mt or j0 >= nt or k0 >= kt) return;
+
+    if (gm == 1 and gn == 1 and gk == 1) {
+        tile_mul_add<T, TS>(A.tile(i0, k0), B.tile(k0, j0), C.tile(i0, j0));
+        return;
+    }
+
+    if (gm >= gn and gm >= gk) {
+        co_mul_rec(A, B, C, i0,          j0, k0, gm / 2, gn, gk, mt, nt, kt);
+        co_mul_rec(A, B, C, i0 + gm / 2, j0, k0, gm / 2, gn, gk, mt, nt, kt);
+    } else if (gn >= gk) {
+        co_mul_rec(A, B, C, i0, j0,          k0, gm, gn / 2, gk, mt, nt, kt);
+        co_mul_rec(A, B, C, i0, j0 + gn / 2, k0, gm, gn / 2, gk, mt, nt, kt);
+    } else {
+        // Обе половины k копятся в один и тот же блок C
+        co_mul_rec(A, B, C, i0, j0, k0,          gm, gn, gk / 2, mt, nt, kt);
+        co_mul_rec(A, B, C, i0, j0, k0 + gk / 2, gm, gn, gk / 2, mt, nt, kt);
+    }
+}
+
+// C = A * B на Morton-матрицах
+template <class T, int TS>
+void mul_morton(const MortonMatrix<T, TS>& A, const MortonMatrix<T, TS>& B, MortonMatrix<T, TS>& C,
+                OpCounter* cnt = nullptr) {
+    assert(A.cols == B.rows);
+
+    C.resize(A.rows, B.cols);
+    int mt = A.tile_rows(), kt = A.tile_cols(), nt = B.tile_cols();
+    co_mul_rec(A, B, C, 0, 0, 0, next_pow2(mt), next_pow2(nt), next_pow2(kt), mt, nt, kt);
+
+    if (cnt) {
+        // Логические операции: умножения нулевого паддинга не считаются
+        uint64_t ops = (uint64_t)A.rows * B.cols * A.cols;
+        cnt->mul += ops;
+        cnt->add += ops;
+    }
+}
+
+// Обёртка над row-major: конвертация туда, рекурсивное умножение, конвертация обратно
+template <class T, int TS = 16>
+void mul_cache_oblivious(const Matrix<T>& A, const Matrix<T>& B, Matrix<T>& C,
+                         OpCounter* cnt = nullptr) {
+    assert(A.cols == B.rows);
+
+    MortonMatrix<T, TS> Am, Bm, Cm;
+    to_morton(A, Am);
+    to_morton(B, Bm);
+    mul_morton(Am, Bm, Cm, cnt);
+    from_morton(Cm, C);
+}
+
+#endif // ALG_CACHE_OBLIVIOUS_H
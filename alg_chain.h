@@ -0,0 +1,269 @@
+//
+// Цепочка произведений A1 * A2 * ... * Ak с оптимальной расстановкой скобок
+// Динамика O(k^3) по измеренной модели стоимости mul_blocked, планы кэшируются по форме цепочки
+//
+
+#ifndef ALG_CHAIN_H
+#define ALG_CHAIN_H
+
+#include "structures.h"
+#include "alg_blocked.h"
+#include "generators.h"
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <vector>
+
+///--------------------------
+///     Модель стоимости
+///--------------------------
+// Время mul_blocked(m, k, n) ~ a * (полные 4x4 блоки) + b * (умножения в граничных блоках)
+//                             + c * (элементы C: обнуление и запись)
+// Коэффициенты измеряются один раз на тип элемента и ядро.
+struct BlockedCostModel {
+    double per_block = 0.0;     // нс на произведение полных 4x4 блоков
+    double per_edge_mul = 0.0;  // нс на умножение в граничном (naive) блоке
+    double per_c_elem = 0.0;    // нс на элемент результата
+
+    double estimate_ns(int m, int k, int n) const {
+        const int BS = 4;
+        double full = (double)(m / BS) * (k / BS) * (n / BS);
+        double edge = (double)m * k * n - full * BS * BS * BS;
+        return per_block * full + per_edge_mul * edge + per_c_elem * (double)m * n;
+    }
+};
+
+// Минимальное из нескольких измерений времени mul_blocked, нс
+template <class T>
+double time_blocked_ns(int m, int k, int n, BlockKernel kernel, int repeats = 3) {
+    auto A = gen_random<T>(m, k, 1, -1.0, 1.0, 1);
+    auto B = gen_random<T>(k, n, 2, -1.0, 1.0, 1);
+    Matrix<T> C;
+    double best = std::numeric_limits<double>::max();
+    for (int r = 0; r < repeats; r++) {
+        auto t0 = std::chrono::steady_clock::now();
+        mul_blocked(A, B, C, kernel);
+        auto t1 = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::nano>(t1 - t0).count());
+    }
+    return best;
+}
+
+template <class T>
+BlockedCostModel calibrate_blocked_cost(BlockKernel kernel) {
+    // Две формы без граничных блоков дают a и c, третья - с краями - даёт b
+    const int m1 = 64, k1 = 64, n1 = 64;
+    const int m3 = 128, k3 = 4, n3 = 128;
+    const int m2 = 63, k2 = 63, n2 = 63;
+
+    double t1 = time_blocked_ns<T>(m1, k1, n1, kernel);
+    double t3 = time_blocked_ns<T>(m3, k3, n3, kernel);
+    double t2 = time_blocked_ns<T>(m2, k2, n2, kernel);
+
+    // a*f1 + c*e1 = t1, a*f3 + c*e3 = t3
+    double f1 = (m1 / 4) * (k1 / 4) * (n1 / 4), e1 = (double)m1 * n1;
+    double f3 = (m3 / 4) * (k3 / 4) * (n3 / 4), e3 = (double)m3 * n3;
+    double det = f1 * e3 - f3 * e1;
+
+    BlockedCostModel model;
+    model.per_block = std::max(1e-3, (t1 * e3 - t3 * e1) / det);
+    model.per_c_elem = std::max(1e-3, (f1 * t3 - f3 * t1) / det);
+
+    BlockedCostModel no_edge = model;
+    double edge_muls = (double)m2 * k2 * n2 - (double)(m2 / 4) * (k2 / 4) * (n2 / 4) * 64;
+    double rest = t2 - no_edge.estimate_ns(m2, k2, n2);
+    model.per_edge_mul = std::max(model.per_block / 64.0, rest / edge_muls);
+    return model;
+}
+
+// Откалиброванная модель для (T, kernel), измеряется при первом обращении
+template <class T>
+const BlockedCostModel& blocked_cost_model(BlockKernel kernel) {
+    static std::mutex mtx;
+    static std::map<BlockKernel, BlockedCostModel> models;
+
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = models.find(kernel);
+    if (it == models.end()) {
+        it = models.emplace(kernel, calibrate_blocked_cost<T>(kernel)).first;
+    }
+    return it->second;
+}
+
+///--------------------------
+///          План
+///--------------------------
+// Операнд шага: входная матрица или буфер рабочей области
+struct ChainOperand {
+    int input = -1;    // номер входной матрицы, -1 если буфер
+    int buffer = -1;   // номер буфера, -1 если вход
+    int rows = 0, cols = 0;
+};
+
+struct ChainStep {
+    ChainOperand lhs, rhs;
+    int dst_buffer = -1;  // -1 - последний шаг, пишет в результат
+    int m = 0, k = 0, n = 0;
+};
+
+struct ChainPlan {
+    std::vector<ChainStep> steps;       // в порядке выполнения
+    int num_buffers = 0;                // для линейных цепочек не больше двух (ping-pong)
+    std::vector<size_t> buffer_elems;   // ёмкость каждого буфера в элементах
+    double estimated_ns = 0.0;
+};
+
+// dims: k+1 размеров, матрица i имеет форму dims[i] x dims[i+1]
+inline ChainPlan build_chain_plan(const std::vector<int>& dims, const BlockedCostModel& model) {
+    int k = (int)dims.size() - 1;
+    assert(k >= 1);
+
+    // cost[i][j] - лучшее время для A_i..A_j, split[i][j] - где ставить скобку
+    std::vector<std::vector<double>> cost(k, std::vector<double>(k, 0.0));
+    std::vector<std::vector<int>> split(k, std::vector<int>(k, -1));
+
+    for (int len = 2; len <= k; len++) {
+        for (int i = 0; i + len - 1 < k; i++) {
+            int j = i + len - 1;
+            cost[i][j] = std::numeric_limits<double>::max();
+            for (int s = i; s < j; s++) {
+                double c = cost[i][s] + cost[s + 1][j]
+                         + model.estimate_ns(dims[i], dims[s + 1], dims[j + 1]);
+                if (c < cost[i][j]) {
+                    cost[i][j] = c;
+                    split[i][j] = s;
+                }
+            }
+        }
+    }
+
+    ChainPlan plan;
+    plan.estimated_ns = cost[0][k - 1];
+
+    // Обход дерева в порядке post-order; буферы переиспользуются, как только освободились
+    std::vector<bool> busy;
+    auto take_buffer = [&](int avoid1, int avoid2) {
+        for (int b = 0; b < (int)busy.size(); b++) {
+            if (!busy[b] and b != avoid1 and b != avoid2) {
+                busy[b] = true;
+                return b;
+            }
+        }
+        busy.push_back(true);
+        return (int)busy.size() - 1;
+    };
+
+    auto emit = [&](auto&& self, int i, int j, bool root) -> ChainOperand {
+        if (i == j) return ChainOperand{i, -1, dims[i], dims[i + 1]};
+
+        int s = split[i][j];
+        ChainOperand l = self(self, i, s, false);
+        ChainOperand r = self(self, s + 1, j, false);
+
+        ChainStep step;
+        step.lhs = l;
+        step.rhs = r;
+        step.m = dims[i];
+        step.k = dims[s + 1];
+        step.n = dims[j + 1];
+
+        // Операнды освобождаются после шага, но писать в них же нельзя
+        step.dst_buffer = root ? -1 : take_buffer(l.buffer, r.buffer);
+        if (l.buffer >= 0) busy[l.buffer] = false;
+        if (r.buffer >= 0) busy[r.buffer] = false;
+        if (step.dst_buffer >= 0) {
+            if ((int)plan.buffer_elems.size() <= step.dst_buffer) plan.buffer_elems.resize(step.dst_buffer + 1, 0);
+            size_t elems = (size_t)step.m * step.n;
+            plan.buffer_elems[step.dst_buffer] = std::max(plan.buffer_elems[step.dst_buffer], elems);
+        }
+        plan.steps.push_back(step);
+
+        return ChainOperand{-1, step.dst_buffer, step.m, step.n};
+    };
+    emit(emit, 0, k - 1, true);
+
+    plan.num_buffers = (int)busy.size();
+    return plan;
+}
+
+// Кэш планов по (тип элемента, ядро, форма цепочки)
+template <class T>
+const ChainPlan& cached_chain_plan(const std::vector<int>& dims, BlockKernel kernel) {
+    static std::mutex mtx;
+    static std::map<BlockKernel, std::map<std::vector<int>, ChainPlan>> plans;
+
+    std::lock_guard<std::mutex> lock(mtx);
+    auto& by_shape = plans[kernel];
+    auto it = by_shape.find(dims);
+    if (it == by_shape.end()) {
+        it = by_shape.emplace(dims, build_chain_plan(dims, blocked_cost_model<T>(kernel))).first;
+    }
+    return it->second;
+}
+
+///--------------------------
+///        Вычисление
+///--------------------------
+// Рабочая область mul_chain: буферы промежуточных результатов плюс нужды mul_blocked_view
+template <class T>
+size_t mul_chain_workspace_bytes(const std::vector<int>& dims,
+                                 BlockKernel kernel = BlockKernel::NAIVE) {
+    if (dims.size() < 3) return 0;
+    const ChainPlan& plan = cached_chain_plan<T>(dims, kernel);
+    size_t bytes = 0;
+    bytes += Workspace::aligned_size(plan.num_buffers * sizeof(T*));
+    for (size_t elems : plan.buffer_elems) bytes += Workspace::aligned_size(elems * sizeof(T));
+    return bytes + mul_blocked_workspace_bytes<T>(0, 0, 0);
+}
+
+// Промежуточные результаты берутся из арены ws и живут только на время вызова
+template <class T>
+void mul_chain(const std::vector<const Matrix<T>*>& mats, Matrix<T>& C,
+               BlockKernel kernel = BlockKernel::NAIVE,
+               OpCounter* cnt = nullptr,
+               Workspace* ws = nullptr) {
+    assert(!mats.empty());
+
+    // Форма цепочки; вектор переиспользуется, чтобы повторный вызов не выделял память
+    static thread_local std::vector<int> dims;
+    dims.clear();
+    dims.push_back(mats[0]->rows);
+    for (size_t i = 0; i < mats.size(); i++) {
+        assert(mats[i]->rows == dims.back());
+        assert(mats[i] != &C);
+        dims.push_back(mats[i]->cols);
+    }
+
+    if (mats.size() == 1) {
+        C = *mats[0];
+        return;
+    }
+
+    const ChainPlan& plan = cached_chain_plan<T>(dims, kernel);
+
+    if (ws == nullptr) ws = &thread_workspace();
+    Workspace::Scope scope(*ws);
+
+    T** buffers = ws->alloc<T*>(plan.num_buffers);
+    for (int b = 0; b < plan.num_buffers; b++) buffers[b] = ws->alloc<T>(plan.buffer_elems[b]);
+
+    auto operand = [&](const ChainOperand& op) -> MatrixView<const T> {
+        if (op.input >= 0) return view(*mats[op.input]);
+        return MatrixView<const T>(buffers[op.buffer], op.rows, op.cols, op.cols);
+    };
+
+    for (const auto& step : plan.steps) {
+        MatrixView<T> dst;
+        if (step.dst_buffer >= 0) {
+            dst = MatrixView<T>(buffers[step.dst_buffer], step.m, step.n, step.n);
+        } else {
+            C.resize(step.m, step.n);
+            dst = view(C);
+        }
+        mul_blocked_view(operand(step.lhs), operand(step.rhs), dst, kernel, EpIdentity{}, cnt, ws);
+    }
+}
+
+#endif // ALG_CHAIN_H
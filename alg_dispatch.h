@@ -0,0 +1,84 @@
+//
+// Обёртки над Matrix для ядер с выбором ISA во время выполнения (dispatch.h)
+// Требуют компоновки с библиотекой matmul_kernels.
+//
+
+#ifndef ALG_DISPATCH_H
+#define ALG_DISPATCH_H
+
+#include "structures.h"
+#include "dispatch.h"
+
+// C = A * B лучшим вариантом (+, *)-ядра для этого процессора
+inline void mul_dispatch(const Matrix<double>& A, const Matrix<double>& B, Matrix<double>& C,
+                         OpCounter* cnt = nullptr, int num_threads = 0) {
+    assert(A.cols == B.rows);
+    C.resize(A.rows, B.cols);
+    kernels().gemm_f64(A.data(), A.stride(), B.data(), B.stride(), C.data(), C.stride(),
+                       A.rows, A.cols, B.cols, num_threads);
+    if (cnt) {
+        cnt->mul += (uint64_t)A.rows * A.cols * B.cols;
+        cnt->add += (uint64_t)A.rows * A.cols * B.cols;
+    }
+}
+
+inline void mul_dispatch(const Matrix<float>& A, const Matrix<float>& B, Matrix<float>& C,
+                         OpCounter* cnt = nullptr, int num_threads = 0) {
+    assert(A.cols == B.rows);
+    C.resize(A.rows, B.cols);
+    kernels().gemm_f32(A.data(), A.stride(), B.data(), B.stride(), C.data(), C.stride(),
+                       A.rows, A.cols, B.cols, num_threads);
+    if (cnt) {
+        cnt->mul += (uint64_t)A.rows * A.cols * B.cols;
+        cnt->add += (uint64_t)A.rows * A.cols * B.cols;
+    }
+}
+
+// (min, +) и (max, +)
+inline void mul_min_plus_dispatch(const Matrix<double>& A, const Matrix<double>& B, Matrix<double>& C,
+                                  int num_threads = 0) {
+    assert(A.cols == B.rows);
+    C.resize(A.rows, B.cols);
+    kernels().min_plus_f64(A.data(), A.stride(), B.data(), B.stride(), C.data(), C.stride(),
+                           A.rows, A.cols, B.cols, num_threads);
+}
+
+inline void mul_min_plus_dispatch(const Matrix<float>& A, const Matrix<float>& B, Matrix<float>& C,
+                                  int num_threads = 0) {
+    assert(A.cols == B.rows);
+    C.resize(A.rows, B.cols);
+    kernels().min_plus_f32(A.data(), A.stride(), B.data(), B.stride(), C.data(), C.stride(),
+                           A.rows, A.cols, B.cols, num_threads);
+}
+
+inline void mul_max_plus_dispatch(const Matrix<double>& A, const Matrix<double>& B, Matrix<double>& C,
+                                  int num_threads = 0) {
+    assert(A.cols == B.rows);
+    C.resize(A.rows, B.cols);
+    kernels().max_plus_f64(A.data(), A.stride(), B.data(), B.stride(), C.data(), C.stride(),
+                           A.rows, A.cols, B.cols, num_threads);
+}
+
+inline void mul_max_plus_dispatch(const Matrix<float>& A, const Matrix<float>& B, Matrix<float>& C,
+                                  int num_threads = 0) {
+    assert(A.cols == B.rows);
+    C.resize(A.rows, B.cols);
+    kernels().max_plus_f32(A.data(), A.stride(), B.data(), B.stride(), C.data(), C.stride(),
+                           A.rows, A.cols, B.cols, num_threads);
+}
+
+// Квантованное int8-умножение (VNNI на AVX-512, pmaddubsw на AVX2)
+inline void mul_int8_dispatch(const Matrix<float>& A, const Matrix<float>& B, Matrix<float>& C,
+                              int num_threads = 0) {
+    assert(A.cols == B.rows);
+    C.resize(A.rows, B.cols);
+    kernels().gemm_int8_f32(A.data(), A.stride(), B.data(), B.stride(), C.data(), C.stride(),
+                            A.rows, A.cols, B.cols, num_threads);
+}
+
+inline void transpose_dispatch(const Matrix<double>& A, Matrix<double>& At, int num_threads = 0) {
+    At.resize(A.cols, A.rows);
+    kernels().transpose_f64(A.data(), A.stride(), At.data(), At.stride(), A.rows, A.cols, num_threads);
+}
+
+#endif // ALG_DISPATCH_H
@@ -0,0 +1,153 @@
+//
+// Общий GEMM: C = alpha * op(A) * op(B) + beta * C
+// op - транспонирование или его отсутствие; операнды читаются через "аксессоры".
+// Операнды-view считаются упакованным ядром (+, *) из alg_semiring.h: alpha и beta
+// применяются в эпилоге при записи C, транспонированный операнд копируется в арену.
+// Прочие аксессоры - простыми циклами по элементам.
+//
+
+#ifndef ALG_GEMM_H
+#define ALG_GEMM_H
+
+#include "structures.h"
+#include "alg_semiring.h"
+#include "alg_transpose.h"
+#include "epilogue.h"
+#include "semiring.h"
+#include "workspace.h"
+
+// Аксессор для MatrixView с транспонированием на этапе компиляции.
+// Любой тип с rows(), cols() и operator()(i, j) годится как операнд gemm_acc.
+template <class T, bool Tr>
+struct OpView {
+    using value_type = T;
+    static constexpr bool transposed = Tr;
+
+    MatrixView<const T> v;
+
+    int rows() const { return Tr ? v.cols : v.rows; }
+    int cols() const { return Tr ? v.rows : v.cols; }
+
+    T operator()(int i, int j) const { return Tr ? v(j, i) : v(i, j); }
+};
+
+template <class E>
+struct is_transposed_access {
+    static constexpr bool value = false;
+};
+
+template <class T>
+struct is_transposed_access<OpView<T, true>> {
+    static constexpr bool value = true;
+};
+
+// Операнд хранится в памяти (OpView) - годится для упакованного ядра
+template <class E>
+struct is_view_access {
+    static constexpr bool value = false;
+};
+
+template <class T, bool Tr>
+struct is_view_access<OpView<T, Tr>> {
+    static constexpr bool value = true;
+};
+
+// op(X) как обычный view: транспонированный операнд копируется в арену
+template <class T, bool Tr>
+MatrixView<const T> plain_view(const OpView<T, Tr>& X, Workspace& ws, int num_threads) {
+    if constexpr (!Tr) {
+        return X.v;
+    } else {
+        MatrixView<T> t(ws.alloc<T>((size_t)X.rows() * X.cols()), X.rows(), X.cols(), X.cols());
+        transpose_view(X.v, t, num_threads);
+        return MatrixView<const T>(t);
+    }
+}
+
+// Пиковый объём арены gemm_acc для операндов-view: транспонированные копии + панели B
+template <class T>
+size_t gemm_workspace_bytes(int m, int k, int n, bool ta, bool tb) {
+    size_t bytes = mul_semiring_workspace_bytes<PlusTimes<T>>(k, n);
+    if (ta) bytes += Workspace::aligned_size((size_t)m * k * sizeof(T));
+    if (tb) bytes += Workspace::aligned_size((size_t)k * n * sizeof(T));
+    return bytes;
+}
+
+// Масштабирование C на beta; при beta == 0 C просто обнуляется (без NaN из мусора)
+template <class T>
+void scale_view(MatrixView<T> C, const T& beta, OpCounter* cnt = nullptr) {
+    if (beta == T{1}) return;
+    for (int i = 0; i < C.rows; ++i)
+        for (int j = 0; j < C.cols; ++j)
+            C(i, j) = (beta == T{}) ? T{} : mul(beta, C(i, j), cnt);
+}
+
+// C = alpha * A * B + beta * C для произвольных аксессоров A и B.
+// num_threads - только для операндов-view (0 - все ядра)
+template <class T, class EA, class EB>
+void gemm_acc(const T& alpha, const EA& A, const EB& B, const T& beta,
+              MatrixView<T> C, OpCounter* cnt = nullptr, int num_threads = 1) {
+    assert(A.cols() == B.rows());
+    assert(A.rows() == C.rows and B.cols() == C.cols);
+
+    const int m = A.rows(), k = A.cols(), n = B.cols();
+
+    if constexpr (is_view_access<EA>::value and is_view_access<EB>::value) {
+        Workspace& ws = thread_workspace();
+        Workspace::Scope scope(ws);
+        MatrixView<const T> a = plain_view(A, ws, num_threads);
+        MatrixView<const T> b = plain_view(B, ws, num_threads);
+        mul_semiring_view<PlusTimes<T>, T>(a, b, C, EpAxpby<T>{alpha, beta, C.ptr, C.stride},
+                                           cnt, num_threads, &ws);
+        if (cnt) {
+            // Эпилог: alpha * x и, если beta != 0, beta * C + ...
+            uint64_t mn = (uint64_t)m * n;
+            cnt->mul += beta == T{} ? mn : 2 * mn;
+            cnt->add += beta == T{} ? 0 : mn;
+        }
+    } else if constexpr (is_transposed_access<EB>::value) {
+        // B хранится транспонированной: строка A и "столбец" B оба непрерывны,
+        // поэтому считаем скалярные произведения
+        for (int i = 0; i < m; ++i) {
+            for (int j = 0; j < n; ++j) {
+                T sum = T{};
+                for (int p = 0; p < k; ++p)
+                    sum = add(sum, mul(A(i, p), B(p, j), cnt), cnt);
+                T prev = (beta == T{}) ? T{} : mul(beta, C(i, j), cnt);
+                C(i, j) = add(prev, mul(alpha, sum, cnt), cnt);
+            }
+        }
+    } else {
+        // Порядок i-k-j: B и C читаются по строкам
+        scale_view(C, beta, cnt);
+        for (int i = 0; i < m; ++i) {
+            for (int p = 0; p < k; ++p) {
+                T a = mul(alpha, A(i, p), cnt);
+                for (int j = 0; j < n; ++j)
+                    C(i, j) = add(C(i, j), mul(a, B(p, j), cnt), cnt);
+            }
+        }
+    }
+}
+
+// Тип транспонирования операнда
+enum class Trans {
+    NO,
+    YES
+};
+
+// BLAS-подобная обёртка над view
+template <class T>
+void mul_gemm_view(Trans ta, Trans tb, const T& alpha,
+                   MatrixView<const T> A, MatrixView<const T> B,
+                   const T& beta, MatrixView<T> C, OpCounter* cnt = nullptr, int num_threads = 1) {
+    if (ta == Trans::NO) {
+        if (tb == Trans::NO) gemm_acc(alpha, OpView<T, false>{A}, OpView<T, false>{B}, beta, C, cnt, num_threads);
+        else                 gemm_acc(alpha, OpView<T, false>{A}, OpView<T, true>{B}, beta, C, cnt, num_threads);
+    } else {
+        if (tb == Trans::NO) gemm_acc(alpha, OpView<T, true>{A}, OpView<T, false>{B}, beta, C, cnt, num_threads);
+        else                 gemm_acc(alpha, OpView<T, true>{A}, OpView<T, true>{B}, beta, C, cnt, num_threads);
+    }
+}
+
+#endif // ALG_GEMM_H
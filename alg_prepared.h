@@ -0,0 +1,364 @@
+//
+// Подготовленный операнд B для многократного умножения на одну и ту же матрицу
+// prepare_b один раз упаковывает B в панели по NR столбцов (k строк по NR подряд,
+// хвост добит нулями) и считает столбцовые множители Винограда eta_j.
+// Дальше mul_prepared читает B только последовательно. Handle неизменяем,
+// поэтому один и тот же shared_ptr можно использовать из разных потоков.
+// PreparedCache - LRU с ограничением по памяти для неявной подготовки (mul_cached): ищет
+// по адресу и форме B, а при попадании сверяет отпечаток содержимого, так что изменённая
+// на месте или заново выделенная по тому же адресу B готовится заново, а не берётся старая.
+//
+
+#ifndef ALG_PREPARED_H
+#define ALG_PREPARED_H
+
+#include "structures.h"
+#include "epilogue.h"
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Как использовать подготовленный B
+enum class PreparedMode {
+    PACKED,     // обычное произведение на упакованных панелях
+    WINOGRAD    // скалярное произведение Винограда: k/2 умножений на элемент + поправки xi_i, eta_j
+};
+
+template <class T>
+struct PreparedB {
+    static constexpr int NR = 8;  // ширина панели
+    static constexpr int MR = 4;  // строк A за один проход микроядра
+
+    int rows = 0, cols = 0;       // k x n исходной B
+    int panels = 0;
+    std::vector<T> packed;        // panels * rows * NR
+    std::vector<T> eta;           // eta_j = sum_p B(2p, j) * B(2p+1, j), добит до panels * NR
+
+    const T* panel(int p) const { return packed.data() + (size_t)p * rows * NR; }
+
+    size_t bytes() const { return (packed.size() + eta.size()) * sizeof(T); }
+};
+
+// Упаковка B и множители Винограда
+template <class T>
+std::shared_ptr<const PreparedB<T>> prepare_b(MatrixView<const T> B, OpCounter* cnt = nullptr) {
+    constexpr int NR = PreparedB<T>::NR;
+    auto pb = std::make_shared<PreparedB<T>>();
+    pb->rows = B.rows;
+    pb->cols = B.cols;
+    pb->panels = (B.cols + NR - 1) / NR;
+    pb->packed.assign((size_t)pb->panels * B.rows * NR, T{});
+    pb->eta.assign((size_t)pb->panels * NR, T{});
+
+    for (int p = 0; p < pb->panels; p++) {
+        int j0 = p * NR;
+        int w = std::min(NR, B.cols - j0);
+        T* dst = pb->packed.data() + (size_t)p * B.rows * NR;
+        for (int kk = 0; kk < B.rows; kk++)
+            for (int j = 0; j < w; j++)
+                dst[kk * NR + j] = B(kk, j0 + j);
+    }
+
+    int kh = B.rows / 2;
+    for (int j = 0; j < B.cols; j++) {
+        T e = T{};
+        for (int q = 0; q < kh; q++) e = add(e, mul(B(2 * q, j), B(2 * q + 1, j), cnt), cnt);
+        pb->eta[j] = e;
+    }
+    return pb;
+}
+
+template <class T>
+std::shared_ptr<const PreparedB<T>> prepare_b(const Matrix<T>& B, OpCounter* cnt = nullptr) {
+    return prepare_b(view(B), cnt);
+}
+
+///--------------------------
+///  Микроядра
+///--------------------------
+// R строк A (R <= MR) на одну панель: acc[R][NR] в регистрах
+template <class T, int R, class U, class Ep>
+inline void prepared_kernel_packed(MatrixView<const T> A, int i0, const T* panel, int k,
+                                   MatrixView<U> C, int j0, int w, const Ep& ep) {
+    constexpr int NR = PreparedB<T>::NR;
+    T acc[R][NR];
+    for (int r = 0; r < R; r++)
+        for (int j = 0; j < NR; j++) acc[r][j] = T{};
+
+    for (int kk = 0; kk < k; kk++) {
+        const T* b = panel + kk * NR;
+        for (int r = 0; r < R; r++) {
+            const T a = A.ptr[(size_t)(i0 + r) * A.stride + kk];
+            for (int j = 0; j < NR; j++) acc[r][j] += a * b[j];
+        }
+    }
+
+    for (int r = 0; r < R; r++)
+        for (int j = 0; j < w; j++)
+            C(i0 + r, j0 + j) = static_cast<U>(ep(i0 + r, j0 + j, acc[r][j]));
+}
+
+// Виноград: C(i, j) = sum_p (a_2p + b_2p+1,j)(a_2p+1 + b_2p,j) - xi_i - eta_j (+ a_k-1 b_k-1,j при нечётном k)
+template <class T, int R, class U, class Ep>
+inline void prepared_kernel_winograd(MatrixView<const T> A, int i0, const T* xi, const T* panel,
+                                     const T* eta, int k, MatrixView<U> C, int j0, int w, const Ep& ep) {
+    constexpr int NR = PreparedB<T>::NR;
+    T acc[R][NR];
+    for (int r = 0; r < R; r++)
+        for (int j = 0; j < NR; j++) acc[r][j] = T{};
+
+    int kh = k / 2;
+    for (int q = 0; q < kh; q++) {
+        const T* b0 = panel + (2 * q) * NR;
+        const T* b1 = b0 + NR;
+        for (int r = 0; r < R; r++) {
+            const T* a = A.ptr + (size_t)(i0 + r) * A.stride + 2 * q;
+            const T a0 = a[0], a1 = a[1];
+            for (int j = 0; j < NR; j++) acc[r][j] += (a0 + b1[j]) * (a1 + b0[j]);
+        }
+    }
+    if (k % 2) {
+        const T* b = panel + (k - 1) * NR;
+        for (int r = 0; r < R; r++) {
+            const T a = A.ptr[(size_t)(i0 + r) * A.stride + k - 1];
+            for (int j = 0; j < NR; j++) acc[r][j] += a * b[j];
+        }
+    }
+
+    for (int r = 0; r < R; r++)
+        for (int j = 0; j < w; j++)
+            C(i0 + r, j0 + j) = static_cast<U>(ep(i0 + r, j0 + j, acc[r][j] - xi[r] - eta[j]));
+}
+
+///--------------------------
+///  Умножение
+///--------------------------
+// C = ep(A * B) с заранее подготовленным B
+template <class T, class U, class Ep = EpIdentity>
+void mul_prepared_view(MatrixView<const T> A, const PreparedB<T>& B, MatrixView<U> C,
+                       PreparedMode mode = PreparedMode::PACKED,
+                       const Ep& ep = Ep{},
+                       OpCounter* cnt = nullptr) {
+    constexpr int NR = PreparedB<T>::NR;
+    constexpr int MR = PreparedB<T>::MR;
+    assert(A.cols == B.rows);
+    assert(A.rows == C.rows and B.cols == C.cols);
+
+    int m = A.rows, k = A.cols, n = B.cols;
+    int m4 = m / MR * MR;
+
+    if (mode == PreparedMode::PACKED) {
+        for (int p = 0; p < B.panels; p++) {
+            int j0 = p * NR;
+            int w = std::min(NR, n - j0);
+            const T* panel = B.panel(p);
+            int i = 0;
+            for (; i < m4; i += MR) prepared_kernel_packed<T, MR>(A, i, panel, k, C, j0, w, ep);
+            for (; i < m; i++) prepared_kernel_packed<T, 1>(A, i, panel, k, C, j0, w, ep);
+        }
+        if (cnt) {
+            cnt->mul += (uint64_t)m * k * n;
+            cnt->add += (uint64_t)m * k * n;
+        }
+        return;
+    }
+
+    // xi_i = sum_p A(i, 2p) * A(i, 2p+1) - считается на каждый вызов, eta_j - уже в B
+    int kh = k / 2;
+    for (int i0 = 0; i0 < m; i0 += MR) {
+        int rr = std::min(MR, m - i0);
+        T xi[MR];
+        for (int r = 0; r < rr; r++) {
+            const T* a = A.ptr + (size_t)(i0 + r) * A.stride;
+            T s = T{};
+            for (int q = 0; q < kh; q++) s += a[2 * q] * a[2 * q + 1];
+            xi[r] = s;
+        }
+        for (int p = 0; p < B.panels; p++) {
+            int j0 = p * NR;
+            int w = std::min(NR, n - j0);
+            if (rr == MR)
+                prepared_kernel_winograd<T, MR>(A, i0, xi, B.panel(p), B.eta.data() + j0, k, C, j0, w, ep);
+            else
+                for (int r = 0; r < rr; r++)
+                    prepared_kernel_winograd<T, 1>(A, i0 + r, xi + r, B.panel(p), B.eta.data() + j0, k, C, j0, w, ep);
+        }
+    }
+    if (cnt) {
+        uint64_t odd = k % 2;
+        cnt->mul += (uint64_t)m * kh + (uint64_t)m * n * (kh + odd);
+        cnt->add += (uint64_t)m * kh + (uint64_t)m * n * (3 * kh + odd + 2);
+    }
+}
+
+template <class T>
+void mul_prepared(const Matrix<T>& A, const PreparedB<T>& B, Matrix<T>& C,
+                  PreparedMode mode = PreparedMode::PACKED,
+                  OpCounter* cnt = nullptr) {
+    C.resize(A.rows, B.cols);
+    mul_prepared_view<T, T>(view(A), B, view(C), mode, EpIdentity{}, cnt);
+}
+
+///--------------------------
+///  LRU-кэш подготовленных операндов
+///--------------------------
+// 64-битный отпечаток содержимого B (по байтам строк, без хвоста stride). Один проход
+// чтением - на порядок дешевле упаковки и несравнимо дешевле самого умножения
+template <class T>
+uint64_t prepared_fingerprint(MatrixView<const T> B) {
+    uint64_t h = 0x9E3779B97F4A7C15ull ^ ((uint64_t)B.rows << 32) ^ (uint64_t)B.cols;
+    auto mix = [&](uint64_t w) {
+        h ^= w;
+        h *= 0xFF51AFD7ED558CCDull;
+        h ^= h >> 29;
+    };
+    const size_t row_bytes = (size_t)B.cols * sizeof(T);
+    for (int i = 0; i < B.rows; i++) {
+        const char* p = reinterpret_cast<const char*>(B.ptr + (size_t)i * B.stride);
+        size_t b = 0;
+        for (; b + 8 <= row_bytes; b += 8) {
+            uint64_t w;
+            std::memcpy(&w, p + b, 8);
+            mix(w);
+        }
+        if (b < row_bytes) {
+            uint64_t w = 0;
+            std::memcpy(&w, p + b, row_bytes - b);
+            mix(w);
+        }
+    }
+    return h;
+}
+
+// Ключ - адрес и форма B; при попадании содержимое сверяется по отпечатку, и устаревшая
+// упаковка (B изменили на месте или по адресу теперь другая матрица) готовится заново.
+// invalidate(ptr) только освобождает память заранее - для корректности он не нужен.
+template <class T>
+class PreparedCache {
+public:
+    explicit PreparedCache(size_t max_bytes = (size_t)256 << 20) : max_bytes_(max_bytes) {}
+
+    std::shared_ptr<const PreparedB<T>> get(MatrixView<const T> B) {
+        Key key{B.ptr, B.rows, B.cols, B.stride};
+        uint64_t fingerprint = prepared_fingerprint(B);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = index_.find(key);
+            if (it != index_.end() and it->second->fingerprint == fingerprint) {
+                lru_.splice(lru_.begin(), lru_, it->second);
+                hits_++;
+                return it->second->value;
+            }
+            if (it != index_.end()) {
+                stale_++;
+                erase(it->second);
+            }
+            misses_++;
+        }
+
+        // Упаковка вне блокировки: попадания в кэш из других потоков не ждут
+        auto pb = prepare_b(B);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(key);
+        if (it != index_.end()) {
+            if (it->second->fingerprint == fingerprint) return it->second->value;  // подготовил другой поток
+            erase(it->second);
+        }
+
+        lru_.push_front({key, fingerprint, pb});
+        index_[key] = lru_.begin();
+        bytes_ += pb->bytes();
+        // Вытесняем самые старые; handle у вызывающих остаются живы через shared_ptr
+        while (bytes_ > max_bytes_ and lru_.size() > 1) erase(std::prev(lru_.end()));
+        return pb;
+    }
+
+    std::shared_ptr<const PreparedB<T>> get(const Matrix<T>& B) { return get(view(B)); }
+
+    // Забыть все упаковки матриц с этим адресом (освободить память, не дожидаясь вытеснения)
+    void invalidate(const T* ptr) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto it = lru_.begin(); it != lru_.end();) {
+            auto next = std::next(it);
+            if (it->key.ptr == ptr) erase(it);
+            it = next;
+        }
+    }
+
+    void invalidate(const Matrix<T>& B) { invalidate(B.data()); }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        lru_.clear();
+        index_.clear();
+        bytes_ = 0;
+    }
+
+    size_t size() const { std::lock_guard<std::mutex> lock(mutex_); return lru_.size(); }
+    size_t bytes() const { std::lock_guard<std::mutex> lock(mutex_); return bytes_; }
+    uint64_t hits() const { std::lock_guard<std::mutex> lock(mutex_); return hits_; }
+    uint64_t misses() const { std::lock_guard<std::mutex> lock(mutex_); return misses_; }
+    uint64_t stale() const { std::lock_guard<std::mutex> lock(mutex_); return stale_; }  // найдено, но B изменилась
+
+private:
+    struct Key {
+        const T* ptr;
+        int rows, cols, stride;
+        bool operator==(const Key& o) const {
+            return ptr == o.ptr and rows == o.rows and cols == o.cols and stride == o.stride;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& k) const {
+            size_t h = std::hash<const void*>()(k.ptr);
+            h ^= ((size_t)k.rows * 0x9E3779B97F4A7C15ull) + (h << 6) + (h >> 2);
+            h ^= ((size_t)k.cols * 0xBF58476D1CE4E5B9ull) + (h << 6) + (h >> 2);
+            h ^= (size_t)k.stride + (h << 6) + (h >> 2);
+            return h;
+        }
+    };
+
+    struct Entry {
+        Key key;
+        uint64_t fingerprint;
+        std::shared_ptr<const PreparedB<T>> value;
+    };
+
+    void erase(typename std::list<Entry>::iterator it) {
+        bytes_ -= it->value->bytes();
+        index_.erase(it->key);
+        lru_.erase(it);
+    }
+
+    size_t max_bytes_;
+    size_t bytes_ = 0;
+    uint64_t hits_ = 0, misses_ = 0, stale_ = 0;
+    std::list<Entry> lru_;
+    std::unordered_map<Key, typename std::list<Entry>::iterator, KeyHash> index_;
+    mutable std::mutex mutex_;
+};
+
+// Кэш процесса для неявной подготовки (по одному на тип элементов)
+template <class T>
+PreparedCache<T>& prepared_cache() {
+    static PreparedCache<T> cache;
+    return cache;
+}
+
+// C = A * B, где B берётся из кэша подготовленных операндов (или готовится при первом вызове
+// и после любого изменения B). Без отпечатка - явный prepare_b + mul_prepared
+template <class T>
+void mul_cached(const Matrix<T>& A, const Matrix<T>& B, Matrix<T>& C,
+                PreparedMode mode = PreparedMode::PACKED,
+                OpCounter* cnt = nullptr) {
+    auto pb = prepared_cache<T>().get(B);
+    mul_prepared(A, *pb, C, mode, cnt);
+}
+
+#endif // ALG_PREPARED_H
@@ -0,0 +1,246 @@
+//
+// Квантованное умножение: int8 x int8 с накоплением в int32
+// A квантуется по строкам, B - по столбцам (симметрично, [-127, 127]):
+//   A(i, p) ~ sa_i * qa(i, p),  B(p, j) ~ sb_j * qb(p, j)
+//   C(i, j) ~ sa_i * sb_j * sum_p qa(i, p) qb(p, j)
+// B хранится транспонированной, строки добиты нулями до кратного QUANT_ALIGN -
+// тогда C(i, j) - скалярное произведение двух непрерывных int8-строк.
+// Деквантование выполняется в эпилоге, туда же можно добавить bias / ReLU.
+// Ядро выбирается при компиляции: AVX-512 VNNI, AVX2 (pmaddubsw), NEON dotprod, NEON, скаляр.
+//
+
+#ifndef ALG_QUANT_H
+#define ALG_QUANT_H
+
+#include "structures.h"
+#include "epilogue.h"
+#include "parallel.h"
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#if defined(__AVX512VNNI__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+static constexpr int QUANT_ALIGN = 64;  // байт (= элементов int8) в одном регистре AVX-512
+
+// Квантованные строки: rows x cols, шаг stride >= cols (кратен QUANT_ALIGN), масштаб на строку
+struct QuantMatrix8 {
+    int rows = 0, cols = 0, stride = 0;
+    std::vector<int8_t> q;
+    std::vector<float> scale;
+
+    const int8_t* row(int i) const { return q.data() + (size_t)i * stride; }
+};
+
+///--------------------------
+///  Квантование
+///--------------------------
+template <class T>
+inline int8_t quantize_value(T x, double inv_scale) {
+    long v = std::lround((double)x * inv_scale);
+    return (int8_t)std::max(-127L, std::min(127L, v));
+}
+
+// A по строкам: scale_i = max_p |A(i, p)| / 127
+template <class T>
+QuantMatrix8 quantize_rows(MatrixView<const T> A) {
+    QuantMatrix8 Q;
+    Q.rows = A.rows;
+    Q.cols = A.cols;
+    Q.stride = (A.cols + QUANT_ALIGN - 1) / QUANT_ALIGN * QUANT_ALIGN;
+    Q.q.assign((size_t)Q.rows * Q.stride, 0);
+    Q.scale.assign(Q.rows, 1.0f);
+
+    for (int i = 0; i < A.rows; i++) {
+        double amax = 0.0;
+        for (int p = 0; p < A.cols; p++) amax = std::max(amax, std::abs((double)A(i, p)));
+        if (amax == 0.0) continue;
+        double s = amax / 127.0;
+        Q.scale[i] = (float)s;
+        int8_t* dst = Q.q.data() + (size_t)i * Q.stride;
+        for (int p = 0; p < A.cols; p++) dst[p] = quantize_value(A(i, p), 1.0 / s);
+    }
+    return Q;
+}
+
+template <class T>
+QuantMatrix8 quantize_rows(const Matrix<T>& A) { return quantize_rows<T>(view(A)); }
+
+// B по столбцам: результат - B^T (строка j = столбец j), scale_j = max_p |B(p, j)| / 127
+template <class T>
+QuantMatrix8 quantize_cols(MatrixView<const T> B) {
+    QuantMatrix8 Q;
+    Q.rows = B.cols;
+    Q.cols = B.rows;
+    Q.stride = (B.rows + QUANT_ALIGN - 1) / QUANT_ALIGN * QUANT_ALIGN;
+    Q.q.assign((size_t)Q.rows * Q.stride, 0);
+    Q.scale.assign(Q.rows, 1.0f);
+
+    std::vector<double> amax(B.cols, 0.0);
+    for (int p = 0; p < B.rows; p++)
+        for (int j = 0; j < B.cols; j++) amax[j] = std::max(amax[j], std::abs((double)B(p, j)));
+
+    for (int j = 0; j < B.cols; j++)
+        if (amax[j] > 0.0) Q.scale[j] = (float)(amax[j] / 127.0);
+
+    for (int p = 0; p < B.rows; p++)
+        for (int j = 0; j < B.cols; j++)
+            if (amax[j] > 0.0) Q.q[(size_t)j * Q.stride + p] = quantize_value(B(p, j), 127.0 / amax[j]);
+    return Q;
+}
+
+template <class T>
+QuantMatrix8 quantize_cols(const Matrix<T>& B) { return quantize_cols<T>(view(B)); }
+
+///--------------------------
+///  Скалярные произведения int8
+///--------------------------
+// Одна строка a против четырёх строк b: out[t] = sum_p a[p] * b_t[p], len кратно QUANT_ALIGN.
+// Значения в [-127, 127], поэтому |a| и sign(b, a) не переполняются.
+#if defined(__AVX512VNNI__) && defined(__AVX512BW__)
+inline const char* quant_kernel_name() { return "avx512_vnni"; }
+
+inline void dot4_s8(const int8_t* a, const int8_t* const b[4], int len, int32_t out[4]) {
+    __m512i acc[4] = { _mm512_setzero_si512(), _mm512_setzero_si512(),
+                       _mm512_setzero_si512(), _mm512_setzero_si512() };
+    const __m512i zero = _mm512_setzero_si512();
+    for (int p = 0; p < len; p += 64) {
+        __m512i va = _mm512_loadu_si512((const void*)(a + p));
+        // vpdpbusd умножает unsigned x signed: |a| и знак a переносится на b
+        __mmask64 neg = _mm512_movepi8_mask(va);
+        __m512i ua = _mm512_abs_epi8(va);
+        for (int t = 0; t < 4; t++) {
+            __m512i vb = _mm512_loadu_si512((const void*)(b[t] + p));
+            vb = _mm512_mask_sub_epi8(vb, neg, zero, vb);
+            acc[t] = _mm512_dpbusd_epi32(acc[t], ua, vb);
+        }
+    }
+    // Через память, а не _mm512_reduce_add_epi32: GCC 12 предупреждает о его неопределённом операнде
+    alignas(64) int32_t lanes[16];
+    for (int t = 0; t < 4; t++) {
+        _mm512_store_si512((void*)lanes, acc[t]);
+        int32_t s = 0;
+        for (int l = 0; l < 16; l++) s += lanes[l];
+        out[t] = s;
+    }
+}
+#elif defined(__AVX2__)
+inline const char* quant_kernel_name() { return "avx2_maddubs"; }
+
+inline void dot4_s8(const int8_t* a, const int8_t* const b[4], int len, int32_t out[4]) {
+    __m256i acc[4] = { _mm256_setzero_si256(), _mm256_setzero_si256(),
+                       _mm256_setzero_si256(), _mm256_setzero_si256() };
+    const __m256i ones = _mm256_set1_epi16(1);
+    for (int p = 0; p < len; p += 32) {
+        __m256i va = _mm256_loadu_si256((const __m256i*)(a + p));
+        __m256i ua = _mm256_abs_epi8(va);
+        for (int t = 0; t < 4; t++) {
+            __m256i vb = _mm256_loadu_si256((const __m256i*)(b[t] + p));
+            // pmaddubsw: пары |a| * sign(b, a) -> int16 (127 * 127 * 2 < 32767), затем -> int32
+            __m256i prod = _mm256_maddubs_epi16(ua, _mm256_sign_epi8(vb, va));
+            acc[t] = _mm256_add_epi32(acc[t], _mm256_madd_epi16(prod, ones));
+        }
+    }
+    for (int t = 0; t < 4; t++) {
+        __m128i s = _mm_add_epi32(_mm256_castsi256_si128(acc[t]), _mm256_extracti128_si256(acc[t], 1));
+        s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+        s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+        out[t] = _mm_cvtsi128_si32(s);
+    }
+}
+#elif defined(__ARM_NEON) && defined(__ARM_FEATURE_DOTPROD)
+inline const char* quant_kernel_name() { return "neon_dotprod"; }
+
+inline void dot4_s8(const int8_t* a, const int8_t* const b[4], int len, int32_t out[4]) {
+    int32x4_t acc[4] = { vdupq_n_s32(0), vdupq_n_s32(0), vdupq_n_s32(0), vdupq_n_s32(0) };
+    for (int p = 0; p < len; p += 16) {
+        int8x16_t va = vld1q_s8(a + p);
+        for (int t = 0; t < 4; t++) acc[t] = vdotq_s32(acc[t], va, vld1q_s8(b[t] + p));
+    }
+    for (int t = 0; t < 4; t++) out[t] = vaddvq_s32(acc[t]);
+}
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+inline const char* quant_kernel_name() { return "neon"; }
+
+inline void dot4_s8(const int8_t* a, const int8_t* const b[4], int len, int32_t out[4]) {
+    int32x4_t acc[4] = { vdupq_n_s32(0), vdupq_n_s32(0), vdupq_n_s32(0), vdupq_n_s32(0) };
+    for (int p = 0; p < len; p += 16) {
+        int8x16_t va = vld1q_s8(a + p);
+        for (int t = 0; t < 4; t++) {
+            int8x16_t vb = vld1q_s8(b[t] + p);
+            int16x8_t lo = vmull_s8(vget_low_s8(va), vget_low_s8(vb));
+            int16x8_t hi = vmull_high_s8(va, vb);
+            acc[t] = vpadalq_s16(acc[t], lo);
+            acc[t] = vpadalq_s16(acc[t], hi);
+        }
+    }
+    for (int t = 0; t < 4; t++) out[t] = vaddvq_s32(acc[t]);
+}
+#else
+inline const char* quant_kernel_name() { return "scalar"; }
+
+inline void dot4_s8(const int8_t* a, const int8_t* const b[4], int len, int32_t out[4]) {
+    for (int t = 0; t < 4; t++) {
+        int32_t s = 0;
+        for (int p = 0; p < len; p++) s += (int32_t)a[p] * (int32_t)b[t][p];
+        out[t] = s;
+    }
+}
+#endif
+
+///--------------------------
+///  Умножение
+///--------------------------
+// C(i, j) = ep(i, j, sa_i * sb_j * acc(i, j)); QBt - результат quantize_cols(B)
+template <class U, class Ep = EpIdentity>
+void mul_quant_view(const QuantMatrix8& QA, const QuantMatrix8& QBt, MatrixView<U> C,
+                    const Ep& ep = Ep{},
+                    OpCounter* cnt = nullptr,
+                    int num_threads = 0) {
+    assert(QA.cols == QBt.cols and QA.stride == QBt.stride);
+    assert(C.rows == QA.rows and C.cols == QBt.rows);
+
+    const int m = QA.rows, n = QBt.rows, len = QA.stride;
+
+    parallel_for(0, m, [&](int lo, int hi) {
+        for (int i = lo; i < hi; i++) {
+            const int8_t* a = QA.row(i);
+            const float sa = QA.scale[i];
+            for (int j0 = 0; j0 < n; j0 += 4) {
+                // Хвост по столбцам: недостающие строки B заменяем последней реальной
+                const int8_t* b[4];
+                for (int t = 0; t < 4; t++) b[t] = QBt.row(std::min(j0 + t, n - 1));
+                int32_t acc[4];
+                dot4_s8(a, b, len, acc);
+                for (int t = 0; t < 4 and j0 + t < n; t++) {
+                    int j = j0 + t;
+                    float x = sa * QBt.scale[j] * (float)acc[t];
+                    C(i, j) = static_cast<U>(ep(i, j, x));
+                }
+            }
+        }
+    }, num_threads, 16);
+
+    if (cnt) {
+        cnt->mul += (uint64_t)m * n * QA.cols;
+        cnt->add += (uint64_t)m * n * QA.cols;
+    }
+}
+
+// Квантование A и B и умножение; результат в исходном типе
+template <class T>
+void mul_int8(const Matrix<T>& A, const Matrix<T>& B, Matrix<T>& C,
+              OpCounter* cnt = nullptr, int num_threads = 0) {
+    assert(A.cols == B.rows);
+    C.resize(A.rows, B.cols);
+    QuantMatrix8 QA = quantize_rows(A);
+    QuantMatrix8 QBt = quantize_cols(B);
+    mul_quant_view(QA, QBt, view(C), EpCast<T>{}, cnt, num_threads);
+}
+
+#endif // ALG_QUANT_H
@@ -0,0 +1,320 @@
+//
+// Блочное умножение над полукольцом: C(i, j) = ⊕_p A(i, p) ⊗ B(p, j)
+// Strassen-подобные схемы здесь неприменимы (нет вычитания), но блокировка
+// и SIMD работают: B упаковывается в панели по NR столбцов (хвост добит S::zero()),
+// микроядро держит блок MR x NR в регистрах и проходит всю глубину k,
+// читая панель B подряд. Для стандартных полуколец (min, +), (max, +), (max, *),
+// (+, *) на float / double ⊕ и ⊗ - векторные инструкции (AVX / SSE2 / NEON),
+// для остальных - то же ядро со скалярными S::add / S::mul.
+// APSP: кратчайшие пути повторным возведением в квадрат в (min, +).
+//
+
+#ifndef ALG_SEMIRING_H
+#define ALG_SEMIRING_H
+
+#include "structures.h"
+#include "semiring.h"
+#include "epilogue.h"
+#include "parallel.h"
+#include "workspace.h"
+#include "trace.h"
+#include <type_traits>
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+///--------------------------
+///  Векторные операции
+///--------------------------
+// W = 1 - скалярный вариант для типов без SIMD
+template <class T>
+struct SemiVec {
+    using V = T;
+    static constexpr int W = 1;
+    static V load(const T* p) { return *p; }
+    static void store(T* p, V x) { *p = x; }
+    static V set1(T x) { return x; }
+    static V plus(V a, V b) { return a + b; }
+    static V times(V a, V b) { return a * b; }
+    static V min(V a, V b) { return std::min(a, b); }
+    static V max(V a, V b) { return std::max(a, b); }
+};
+
+#if defined(__AVX__)
+template <>
+struct SemiVec<double> {
+    using V = __m256d;
+    static constexpr int W = 4;
+    static V load(const double* p) { return _mm256_loadu_pd(p); }
+    static void store(double* p, V x) { _mm256_storeu_pd(p, x); }
+    static V set1(double x) { return _mm256_set1_pd(x); }
+    static V plus(V a, V b) { return _mm256_add_pd(a, b); }
+    static V times(V a, V b) { return _mm256_mul_pd(a, b); }
+    static V min(V a, V b) { return _mm256_min_pd(a, b); }
+    static V max(V a, V b) { return _mm256_max_pd(a, b); }
+};
+
+template <>
+struct SemiVec<float> {
+    using V = __m256;
+    static constexpr int W = 8;
+    static V load(const float* p) { return _mm256_loadu_ps(p); }
+    static void store(float* p, V x) { _mm256_storeu_ps(p, x); }
+    static V set1(float x) { return _mm256_set1_ps(x); }
+    static V plus(V a, V b) { return _mm256_add_ps(a, b); }
+    static V times(V a, V b) { return _mm256_mul_ps(a, b); }
+    static V min(V a, V b) { return _mm256_min_ps(a, b); }
+    static V max(V a, V b) { return _mm256_max_ps(a, b); }
+};
+#elif defined(__SSE2__)
+template <>
+struct SemiVec<double> {
+    using V = __m128d;
+    static constexpr int W = 2;
+    static V load(const double* p) { return _mm_loadu_pd(p); }
+    static void store(double* p, V x) { _mm_storeu_pd(p, x); }
+    static V set1(double x) { return _mm_set1_pd(x); }
+    static V plus(V a, V b) { return _mm_add_pd(a, b); }
+    static V times(V a, V b) { return _mm_mul_pd(a, b); }
+    static V min(V a, V b) { return _mm_min_pd(a, b); }
+    static V max(V a, V b) { return _mm_max_pd(a, b); }
+};
+
+template <>
+struct SemiVec<float> {
+    using V = __m128;
+    static constexpr int W = 4;
+    static V load(const float* p) { return _mm_loadu_ps(p); }
+    static void store(float* p, V x) { _mm_storeu_ps(p, x); }
+    static V set1(float x) { return _mm_set1_ps(x); }
+    static V plus(V a, V b) { return _mm_add_ps(a, b); }
+    static V times(V a, V b) { return _mm_mul_ps(a, b); }
+    static V min(V a, V b) { return _mm_min_ps(a, b); }
+    static V max(V a, V b) { return _mm_max_ps(a, b); }
+};
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+template <>
+struct SemiVec<double> {
+    using V = float64x2_t;
+    static constexpr int W = 2;
+    static V load(const double* p) { return vld1q_f64(p); }
+    static void store(double* p, V x) { vst1q_f64(p, x); }
+    static V set1(double x) { return vdupq_n_f64(x); }
+    static V plus(V a, V b) { return vaddq_f64(a, b); }
+    static V times(V a, V b) { return vmulq_f64(a, b); }
+    static V min(V a, V b) { return vminq_f64(a, b); }
+    static V max(V a, V b) { return vmaxq_f64(a, b); }
+};
+
+template <>
+struct SemiVec<float> {
+    using V = float32x4_t;
+    static constexpr int W = 4;
+    static V load(const float* p) { return vld1q_f32(p); }
+    static void store(float* p, V x) { vst1q_f32(p, x); }
+    static V set1(float x) { return vdupq_n_f32(x); }
+    static V plus(V a, V b) { return vaddq_f32(a, b); }
+    static V times(V a, V b) { return vmulq_f32(a, b); }
+    static V min(V a, V b) { return vminq_f32(a, b); }
+    static V max(V a, V b) { return vmaxq_f32(a, b); }
+};
+#endif
+
+template <SemiOp Op, class VO>
+typename VO::V semi_vop(typename VO::V a, typename VO::V b) {
+    if constexpr (Op == SemiOp::PLUS) return VO::plus(a, b);
+    else if constexpr (Op == SemiOp::TIMES) return VO::times(a, b);
+    else if constexpr (Op == SemiOp::MIN) return VO::min(a, b);
+    else return VO::max(a, b);
+}
+
+// ⊕ / ⊗ для ядра: по add_op / mul_op, если полукольцо их объявляет и для T есть SIMD,
+// иначе S::add / S::mul (у них, например, насыщение целых в MinPlus / MaxPlus)
+template <class S, class = void>
+struct SemiKernelOps {
+    using T = typename S::value_type;
+    using V = T;
+    static constexpr int W = 1;
+    static V load(const T* p) { return *p; }
+    static void store(T* p, V x) { *p = x; }
+    static V set1(T x) { return x; }
+    static V add(V a, V b) { return S::add(a, b); }
+    static V mul(V a, V b) { return S::mul(a, b); }
+};
+
+template <class S>
+struct SemiKernelOps<S, std::void_t<decltype(S::add_op), decltype(S::mul_op)>> {
+    using T = typename S::value_type;
+    using VO = SemiVec<T>;
+    using V = typename VO::V;
+    static constexpr int W = VO::W;
+    static V load(const T* p) { return VO::load(p); }
+    static void store(T* p, V x) { VO::store(p, x); }
+    static V set1(T x) { return VO::set1(x); }
+    static V add(V a, V b) {
+        if constexpr (W == 1) return S::add(a, b);
+        else return semi_vop<S::add_op, VO>(a, b);
+    }
+    static V mul(V a, V b) {
+        if constexpr (W == 1) return S::mul(a, b);
+        else return semi_vop<S::mul_op, VO>(a, b);
+    }
+};
+
+///--------------------------
+///  Умножение
+///--------------------------
+static constexpr int SEMI_MR = 4;  // строк C в микроядре
+
+// Микроядро: строки a[0..MR), панель bp (k x NR подряд) -> блок MR x NR в out
+template <class S, int NV>
+void semiring_kernel(const typename S::value_type* const a[SEMI_MR],
+                     const typename S::value_type* bp, int k,
+                     typename S::value_type* out) {
+    using Ops = SemiKernelOps<S>;
+    using V = typename Ops::V;
+    constexpr int W = Ops::W, NR = NV * W;
+
+    V acc[SEMI_MR][NV];
+    for (int r = 0; r < SEMI_MR; r++)
+        for (int v = 0; v < NV; v++) acc[r][v] = Ops::set1(S::zero());
+
+    for (int p = 0; p < k; p++) {
+        V b[NV];
+        for (int v = 0; v < NV; v++) b[v] = Ops::load(bp + (size_t)p * NR + v * W);
+        for (int r = 0; r < SEMI_MR; r++) {
+            V x = Ops::set1(a[r][p]);
+            for (int v = 0; v < NV; v++) acc[r][v] = Ops::add(acc[r][v], Ops::mul(x, b[v]));
+        }
+    }
+
+    for (int r = 0; r < SEMI_MR; r++)
+        for (int v = 0; v < NV; v++) Ops::store(out + r * NR + v * W, acc[r][v]);
+}
+
+static constexpr int SEMI_WB_BLOCKS = 16;  // блоков строк, которые ядро считает до записи в C
+
+// Блоки строк [lo, hi) против одной упакованной панели bp (столбцы C с j0): ядро считает
+// до SEMI_WB_BLOCKS блоков в буфер, затем они разом пишутся в C через эпилог. Трассировка -
+// по событию KERNEL и WRITE_BACK на такую порцию, а не на каждый блок MR x NR
+template <class S, int NV, class T, class U, class Ep>
+void semiring_panel_rows(MatrixView<const T> A, const T* bp, int j0, int lo, int hi,
+                         MatrixView<U> C, const Ep& ep) {
+    constexpr int NR = NV * SemiKernelOps<S>::W;
+    const int m = A.rows, k = A.cols, w = std::min(NR, C.cols - j0);
+    T out[SEMI_WB_BLOCKS][SEMI_MR * NR];
+    for (int c0 = lo; c0 < hi; c0 += SEMI_WB_BLOCKS) {
+        const int c1 = std::min(hi, c0 + SEMI_WB_BLOCKS);
+        {
+            MATMUL_TRACE_SCOPE(KERNEL);
+            for (int bi = c0; bi < c1; bi++) {
+                int i0 = bi * SEMI_MR, h = std::min(SEMI_MR, m - i0);
+                // Хвост по строкам: недостающие строки A заменяем последней реальной
+                const T* a[SEMI_MR];
+                for (int r = 0; r < SEMI_MR; r++) a[r] = A.ptr + (size_t)(i0 + std::min(r, h - 1)) * A.stride;
+                semiring_kernel<S, NV>(a, bp, k, out[bi - c0]);
+            }
+        }
+        MATMUL_TRACE_SCOPE(WRITE_BACK);
+        for (int bi = c0; bi < c1; bi++) {
+            int i0 = bi * SEMI_MR, h = std::min(SEMI_MR, m - i0);
+            for (int r = 0; r < h; r++)
+                for (int t = 0; t < w; t++)
+                    C(i0 + r, j0 + t) = static_cast<U>(ep(i0 + r, j0 + t, out[bi - c0][r * NR + t]));
+        }
+    }
+}
+
+// Байт арены под упакованные панели B (k x n) в mul_semiring_view
+template <class S>
+size_t mul_semiring_workspace_bytes(int k, int n) {
+    constexpr int NR = (SemiKernelOps<S>::W == 1 ? 4 : 2) * SemiKernelOps<S>::W;
+    return Workspace::aligned_size((size_t)(n + NR - 1) / NR * NR * k * sizeof(typename S::value_type));
+}
+
+// C(i, j) = ep(i, j, ⊕_p A(i, p) ⊗ B(p, j)); строки C делятся между потоками
+template <class S, class T = typename S::value_type, class U = T, class Ep = EpIdentity>
+void mul_semiring_view(MatrixView<const T> A, MatrixView<const T> B, MatrixView<U> C,
+                       const Ep& ep = Ep{},
+                       OpCounter* cnt = nullptr,
+                       int num_threads = 0,
+                       Workspace* ws = nullptr) {
+    static_assert(std::is_same_v<T, typename S::value_type>, "semiring value type mismatch");
+    assert(A.cols == B.rows);
+    assert(A.rows == C.rows and B.cols == C.cols);
+
+    using Ops = SemiKernelOps<S>;
+    constexpr int NV = Ops::W == 1 ? 4 : 2;
+    constexpr int NR = NV * Ops::W;
+    const int m = A.rows, k = A.cols, n = B.cols;
+    const int panels = (n + NR - 1) / NR;
+    if (m == 0 or n == 0) return;
+
+    if (ws == nullptr) ws = &thread_workspace();
+    Workspace::Scope scope(*ws);
+    T* packed = ws->alloc<T>((size_t)panels * k * NR);
+
+    // Панель jp: B(p, jp * NR + t) -> packed[(jp * k + p) * NR + t], за границей - zero()
+    parallel_for(0, panels, [&](int lo, int hi) {
+        MATMUL_TRACE_SCOPE(PACK);
+        for (int jp = lo; jp < hi; jp++) {
+            T* dst = packed + (size_t)jp * k * NR;
+            int j0 = jp * NR, w = std::min(NR, n - j0);
+            for (int p = 0; p < k; p++) {
+                for (int t = 0; t < w; t++) dst[(size_t)p * NR + t] = B(p, j0 + t);
+                for (int t = w; t < NR; t++) dst[(size_t)p * NR + t] = S::zero();
+            }
+        }
+    }, num_threads, 4);
+
+    const int row_blocks = (m + SEMI_MR - 1) / SEMI_MR;
+    parallel_for(0, row_blocks, [&](int lo, int hi) {
+        // Панель B остаётся в кэше, пока по ней проходят все блоки строк полосы
+        for (int jp = 0; jp < panels; jp++)
+            semiring_panel_rows<S, NV>(A, packed + (size_t)jp * k * NR, jp * NR, lo, hi, C, ep);
+    }, num_threads, 8);
+
+    if (cnt) {
+        cnt->mul += (uint64_t)m * n * k;
+        cnt->add += (uint64_t)m * n * k;
+    }
+}
+
+template <class S, class T = typename S::value_type>
+void mul_semiring(const Matrix<T>& A, const Matrix<T>& B, Matrix<T>& C,
+                  OpCounter* cnt = nullptr, int num_threads = 0) {
+    assert(A.cols == B.rows);
+    C.resize(A.rows, B.cols);
+    mul_semiring_view<S, T>(view(A), view(B), view(C), EpIdentity{}, cnt, num_threads);
+}
+
+///--------------------------
+///  Кратчайшие пути (APSP)
+///--------------------------
+// W(i, j) - вес ребра i -> j, semiring_inf<T>() - ребра нет. D = (W с нулевой диагональю)^(n-1)
+// в (min, +); возведение в квадрат даёт ceil(log2(n - 1)) умножений и останавливается,
+// как только матрица перестала меняться. При отрицательном цикле на диагонали будет D(i, i) < 0.
+template <class T>
+Matrix<T> apsp_min_plus(const Matrix<T>& W, OpCounter* cnt = nullptr, int num_threads = 0) {
+    assert(W.rows == W.cols);
+    const int n = W.rows;
+    Matrix<T> D = W, P(n, n);
+    for (int i = 0; i < n; i++) D(i, i) = std::min(D(i, i), T{});
+
+    for (int len = 1; len < n - 1; len *= 2) {
+        mul_semiring_view<MinPlus<T>, T>(view(D), view(D), view(P), EpIdentity{}, cnt, num_threads);
+        bool changed = false;
+        for (int i = 0; i < n and !changed; i++)
+            for (int j = 0; j < n; j++)
+                if (P(i, j) != D(i, j)) { changed = true; break; }
+        std::swap(D, P);
+        if (!changed) break;
+    }
+    return D;
+}
+
+#endif // ALG_SEMIRING_H
@@ -0,0 +1,323 @@
+//
+// Умножение для вырожденных форм: GEMV, вектор на матрицу, rank-k (малое k),
+// tall-skinny (узкая B), short-wide (мало строк A) и малая C с огромным k
+// mul_blocked на таких формах почти целиком уходит в граничные блоки mul_naive_view.
+// Здесь у каждой формы свой обход: тайл R x w (R <= 4 строк A, w <= SHAPE_NC столбцов)
+// держит аккумулятор в регистрах и проходит своё k, строка B читается прямо из B
+// (без упаковки) и используется для всех R строк. Малая C с большим k делит k между потоками
+// и складывает частичные суммы. mul_shaped_view выбирает путь по (m, k, n).
+//
+
+#ifndef ALG_SHAPES_H
+#define ALG_SHAPES_H
+
+#include "structures.h"
+#include "epilogue.h"
+#include "workspace.h"
+#include "parallel.h"
+#include "semiring.h"
+#include "alg_semiring.h"
+#include "trace.h"
+#include <algorithm>
+
+static constexpr int SHAPE_MR = 4;           // строк A в тайле
+static constexpr int SHAPE_NC = 64;          // столбцов C в тайле
+static constexpr int SHAPE_THIN = 32;        // "узкое" измерение: меньше этого
+static constexpr int SHAPE_RANK_K = 16;      // k не больше этого - rank-k обновление
+static constexpr int SHAPE_KSPLIT_K = 4096;  // малая C при k не меньше этого - деление по k
+static constexpr int SHAPE_KSPLIT_CHUNK = 1024;  // минимальная доля k на поток
+
+enum class ShapeClass {
+    GEMV,          // n == 1
+    VECMAT,        // m == 1
+    RANK_K,        // k <= SHAPE_RANK_K
+    TALL_SKINNY,   // n < SHAPE_THIN
+    SHORT_WIDE,    // m < SHAPE_THIN
+    KSPLIT,        // m, n < SHAPE_THIN, k >= SHAPE_KSPLIT_K
+    GENERAL        // упакованное ядро alg_semiring.h
+};
+
+inline const char* shape_class_name(ShapeClass s) {
+    switch (s) {
+        case ShapeClass::GEMV: return "gemv";
+        case ShapeClass::VECMAT: return "vecmat";
+        case ShapeClass::RANK_K: return "rank_k";
+        case ShapeClass::TALL_SKINNY: return "tall_skinny";
+        case ShapeClass::SHORT_WIDE: return "short_wide";
+        case ShapeClass::KSPLIT: return "ksplit";
+        case ShapeClass::GENERAL: return "general";
+    }
+    return "unknown";
+}
+
+inline ShapeClass classify_shape(int m, int k, int n) {
+    if (m < SHAPE_THIN and n < SHAPE_THIN and k >= SHAPE_KSPLIT_K) return ShapeClass::KSPLIT;
+    if (n == 1) return ShapeClass::GEMV;
+    if (m == 1) return ShapeClass::VECMAT;
+    if (k <= SHAPE_RANK_K) return ShapeClass::RANK_K;
+    if (n < SHAPE_THIN) return ShapeClass::TALL_SKINNY;
+    if (m < SHAPE_THIN) return ShapeClass::SHORT_WIDE;
+    return ShapeClass::GENERAL;
+}
+
+///--------------------------
+///  Ядра
+///--------------------------
+// out[r * SHAPE_NC + t] = sum_{p0 <= p < p1} A(i0 + r, p) * B(p, j0 + t), r < R, t < w.
+// Полные группы по NR столбцов - аккумуляторы в регистрах (SemiVec, B читается без упаковки),
+// остаток столбцов - скалярно.
+template <class T, int R>
+void shape_tile(MatrixView<const T> A, MatrixView<const T> B, int i0, int j0, int w,
+                int p0, int p1, T* out) {
+    using Ops = SemiKernelOps<PlusTimes<T>>;
+    using V = typename Ops::V;
+    constexpr int W = Ops::W, NV = W == 1 ? 4 : 2, NR = NV * W;
+
+    const T* a[R];
+    for (int r = 0; r < R; r++) a[r] = A.ptr + (size_t)(i0 + r) * A.stride;
+
+    int t0 = 0;
+    for (; t0 + NR <= w; t0 += NR) {
+        V acc[R][NV];
+        for (int r = 0; r < R; r++)
+            for (int v = 0; v < NV; v++) acc[r][v] = Ops::set1(T{});
+        const T* bp = B.ptr + (size_t)p0 * B.stride + j0 + t0;
+        for (int p = p0; p < p1; p++, bp += B.stride) {
+            V b[NV];
+            for (int v = 0; v < NV; v++) b[v] = Ops::load(bp + v * W);
+            for (int r = 0; r < R; r++) {
+                V x = Ops::set1(a[r][p]);
+                for (int v = 0; v < NV; v++) acc[r][v] = Ops::add(acc[r][v], Ops::mul(x, b[v]));
+            }
+        }
+        for (int r = 0; r < R; r++)
+            for (int v = 0; v < NV; v++) Ops::store(out + r * SHAPE_NC + t0 + v * W, acc[r][v]);
+    }
+
+    if (t0 == w) return;
+    const int rest = w - t0;
+    T acc[R][NR];
+    for (int r = 0; r < R; r++)
+        for (int t = 0; t < rest; t++) acc[r][t] = T{};
+    for (int p = p0; p < p1; p++) {
+        const T* b = B.ptr + (size_t)p * B.stride + j0 + t0;
+        for (int r = 0; r < R; r++) {
+            const T x = a[r][p];
+            for (int t = 0; t < rest; t++) acc[r][t] += x * b[t];
+        }
+    }
+    for (int r = 0; r < R; r++)
+        for (int t = 0; t < rest; t++) out[r * SHAPE_NC + t0 + t] = acc[r][t];
+}
+
+// h строк (h <= SHAPE_MR): число строк - параметр шаблона, чтобы аккумуляторы остались в регистрах
+template <class T>
+void shape_tile_rows(MatrixView<const T> A, MatrixView<const T> B, int i0, int h, int j0, int w,
+                     int p0, int p1, T* out) {
+    switch (h) {
+        case 1: shape_tile<T, 1>(A, B, i0, j0, w, p0, p1, out); break;
+        case 2: shape_tile<T, 2>(A, B, i0, j0, w, p0, p1, out); break;
+        case 3: shape_tile<T, 3>(A, B, i0, j0, w, p0, p1, out); break;
+        default: shape_tile<T, SHAPE_MR>(A, B, i0, j0, w, p0, p1, out); break;
+    }
+}
+
+template <class T, class U, class Ep>
+void shape_store(const T* out, MatrixView<U> C, int i0, int h, int j0, int w, const Ep& ep) {
+    for (int r = 0; r < h; r++)
+        for (int t = 0; t < w; t++)
+            C(i0 + r, j0 + t) = static_cast<U>(ep(i0 + r, j0 + t, out[r * SHAPE_NC + t]));
+}
+
+// Тайлы по строкам: каждый поток - полоса блоков строк, внутри - все столбцы.
+// Для n < SHAPE_THIN и малого k вся B (k x n) остаётся в кэше, A читается один раз.
+template <class T, class U, class Ep>
+void shape_by_rows(MatrixView<const T> A, MatrixView<const T> B, MatrixView<U> C, const Ep& ep,
+                   int num_threads) {
+    const int m = A.rows, k = A.cols, n = B.cols;
+    const int row_blocks = (m + SHAPE_MR - 1) / SHAPE_MR;
+    parallel_for(0, row_blocks, [&](int lo, int hi) {
+        // Запись тайла в C слита с его счётом, поэтому вся полоса - одно событие KERNEL
+        MATMUL_TRACE_SCOPE(KERNEL);
+        T out[SHAPE_MR * SHAPE_NC];
+        for (int bi = lo; bi < hi; bi++) {
+            int i0 = bi * SHAPE_MR, h = std::min(SHAPE_MR, m - i0);
+            for (int j0 = 0; j0 < n; j0 += SHAPE_NC) {
+                int w = std::min(SHAPE_NC, n - j0);
+                shape_tile_rows(A, B, i0, h, j0, w, 0, k, out);
+                shape_store(out, C, i0, h, j0, w, ep);
+            }
+        }
+    }, num_threads, 16);
+}
+
+// Тайлы по столбцам: каждый поток - полоса столбцов, внутри - все (немногие) строки.
+// Строка B читается один раз на блок строк A, а A (m < SHAPE_THIN строк) - в кэше.
+template <class T, class U, class Ep>
+void shape_by_cols(MatrixView<const T> A, MatrixView<const T> B, MatrixView<U> C, const Ep& ep,
+                   int num_threads) {
+    const int m = A.rows, k = A.cols, n = B.cols;
+    const int col_blocks = (n + SHAPE_NC - 1) / SHAPE_NC;
+    parallel_for(0, col_blocks, [&](int lo, int hi) {
+        MATMUL_TRACE_SCOPE(KERNEL);  // как в shape_by_rows: запись в C внутри
+        T out[SHAPE_MR * SHAPE_NC];
+        for (int bj = lo; bj < hi; bj++) {
+            int j0 = bj * SHAPE_NC, w = std::min(SHAPE_NC, n - j0);
+            for (int i0 = 0; i0 < m; i0 += SHAPE_MR) {
+                int h = std::min(SHAPE_MR, m - i0);
+                shape_tile_rows(A, B, i0, h, j0, w, 0, k, out);
+                shape_store(out, C, i0, h, j0, w, ep);
+            }
+        }
+    }, num_threads, 4);
+}
+
+// y = A x: x - столбец B (с шагом B.stride), копируется подряд; по 4 строки A за проход,
+// у каждой строки 4 независимые частичные суммы
+template <class T, class U, class Ep>
+void shape_gemv(MatrixView<const T> A, MatrixView<const T> B, MatrixView<U> C, const Ep& ep,
+                int num_threads, Workspace* ws) {
+    const int m = A.rows, k = A.cols;
+    if (ws == nullptr) ws = &thread_workspace();
+    Workspace::Scope scope(*ws);
+    const T* x = B.ptr;
+    if (B.stride != 1 and k > 1) {
+        MATMUL_TRACE_SCOPE(PACK);
+        T* xc = ws->alloc<T>(k);
+        for (int p = 0; p < k; p++) xc[p] = B(p, 0);
+        x = xc;
+    }
+
+    const int row_blocks = (m + SHAPE_MR - 1) / SHAPE_MR;
+    parallel_for(0, row_blocks, [&](int lo, int hi) {
+        MATMUL_TRACE_SCOPE(KERNEL);
+        for (int bi = lo; bi < hi; bi++) {
+            int i0 = bi * SHAPE_MR, h = std::min(SHAPE_MR, m - i0);
+            T s[SHAPE_MR][4];
+            const T* a[SHAPE_MR];
+            for (int r = 0; r < SHAPE_MR; r++) {
+                a[r] = A.ptr + (size_t)(i0 + std::min(r, h - 1)) * A.stride;
+                for (int q = 0; q < 4; q++) s[r][q] = T{};
+            }
+            int p = 0;
+            for (; p + 4 <= k; p += 4)
+                for (int r = 0; r < SHAPE_MR; r++)
+                    for (int q = 0; q < 4; q++) s[r][q] += a[r][p + q] * x[p + q];
+            for (; p < k; p++)
+                for (int r = 0; r < SHAPE_MR; r++) s[r][0] += a[r][p] * x[p];
+            for (int r = 0; r < h; r++)
+                C(i0 + r, 0) = static_cast<U>(ep(i0 + r, 0, (s[r][0] + s[r][1]) + (s[r][2] + s[r][3])));
+        }
+    }, num_threads, 64);
+}
+
+// Малая C, огромное k: поток t считает частичную C по своей доле k в отдельный буфер,
+// затем буферы складываются по порядку (результат не зависит от расписания потоков)
+template <class T, class U, class Ep>
+void shape_ksplit(MatrixView<const T> A, MatrixView<const T> B, MatrixView<U> C, const Ep& ep,
+                  int num_threads, Workspace* ws) {
+    const int m = A.rows, k = A.cols, n = B.cols;
+    if (num_threads <= 0) num_threads = default_num_threads();
+    const int parts = std::max(1, std::min(num_threads, k / SHAPE_KSPLIT_CHUNK));
+    const size_t tile = (size_t)SHAPE_MR * SHAPE_NC;
+    const int row_blocks = (m + SHAPE_MR - 1) / SHAPE_MR;
+    const int col_blocks = (n + SHAPE_NC - 1) / SHAPE_NC;
+    const size_t part_size = (size_t)row_blocks * col_blocks * tile;
+
+    if (ws == nullptr) ws = &thread_workspace();
+    Workspace::Scope scope(*ws);
+    T* partial = ws->alloc<T>(part_size * parts);
+
+    parallel_for(0, parts, [&](int lo, int hi) {
+        MATMUL_TRACE_SCOPE(KERNEL);
+        for (int part = lo; part < hi; part++) {
+            int p0 = (int)((int64_t)k * part / parts), p1 = (int)((int64_t)k * (part + 1) / parts);
+            T* dst = partial + part * part_size;
+            for (int bi = 0; bi < row_blocks; bi++)
+                for (int bj = 0; bj < col_blocks; bj++) {
+                    int i0 = bi * SHAPE_MR, h = std::min(SHAPE_MR, m - i0);
+                    int j0 = bj * SHAPE_NC, w = std::min(SHAPE_NC, n - j0);
+                    shape_tile_rows(A, B, i0, h, j0, w, p0, p1, dst + (size_t)(bi * col_blocks + bj) * tile);
+                }
+        }
+    }, parts);
+
+    MATMUL_TRACE_SCOPE(WRITE_BACK);
+    for (int bi = 0; bi < row_blocks; bi++)
+        for (int bj = 0; bj < col_blocks; bj++) {
+            int i0 = bi * SHAPE_MR, h = std::min(SHAPE_MR, m - i0);
+            int j0 = bj * SHAPE_NC, w = std::min(SHAPE_NC, n - j0);
+            size_t off = (size_t)(bi * col_blocks + bj) * tile;
+            T* sum = partial + off;
+            for (int part = 1; part < parts; part++) {
+                const T* add_from = partial + part * part_size + off;
+                for (int r = 0; r < h; r++)
+                    for (int t = 0; t < w; t++) sum[r * SHAPE_NC + t] += add_from[r * SHAPE_NC + t];
+            }
+            shape_store(sum, C, i0, h, j0, w, ep);
+        }
+}
+
+///--------------------------
+///  Выбор пути
+///--------------------------
+// C(i, j) = ep(i, j, (A * B)(i, j)) путём для формы (m, k, n); возвращает выбранный путь
+template <class T, class U = T, class Ep = EpIdentity>
+ShapeClass mul_shaped_view(MatrixView<const T> A, MatrixView<const T> B, MatrixView<U> C,
+                           const Ep& ep = Ep{},
+                           OpCounter* cnt = nullptr,
+                           int num_threads = 0,
+                           Workspace* ws = nullptr) {
+    assert(A.cols == B.rows);
+    assert(A.rows == C.rows and B.cols == C.cols);
+    const int m = A.rows, k = A.cols, n = B.cols;
+    ShapeClass shape = classify_shape(m, k, n);
+    if (m == 0 or n == 0) return shape;
+
+    switch (shape) {
+        case ShapeClass::GEMV: shape_gemv(A, B, C, ep, num_threads, ws); break;
+        case ShapeClass::VECMAT:
+        case ShapeClass::SHORT_WIDE: shape_by_cols(A, B, C, ep, num_threads); break;
+        case ShapeClass::RANK_K:
+        case ShapeClass::TALL_SKINNY: shape_by_rows(A, B, C, ep, num_threads); break;
+        case ShapeClass::KSPLIT: shape_ksplit(A, B, C, ep, num_threads, ws); break;
+        case ShapeClass::GENERAL:
+            mul_semiring_view<PlusTimes<T>, T>(A, B, C, ep, nullptr, num_threads, ws);
+            break;
+    }
+
+    if (cnt) {
+        cnt->mul += (uint64_t)m * n * k;
+        cnt->add += (uint64_t)m * n * k;
+    }
+    return shape;
+}
+
+template <class T>
+ShapeClass mul_shaped(const Matrix<T>& A, const Matrix<T>& B, Matrix<T>& C,
+                      OpCounter* cnt = nullptr, int num_threads = 0) {
+    assert(A.cols == B.rows);
+    C.resize(A.rows, B.cols);
+    return mul_shaped_view<T>(view(A), view(B), view(C), EpIdentity{}, cnt, num_threads);
+}
+
+// Эпилог обновления: alpha * x + beta * C(i, j) - C читается до того, как тайл её перезапишет
+template <class T>
+struct EpUpdate {
+    MatrixView<const T> C;
+    T alpha, beta;
+    template <class V>
+    V operator()(int i, int j, const V& x) const { return alpha * x + beta * C(i, j); }
+};
+
+// Rank-k обновление C = alpha * A * B + beta * C (A - m x k, B - k x n, обычно k мало)
+template <class T>
+ShapeClass rank_k_update(const Matrix<T>& A, const Matrix<T>& B, Matrix<T>& C,
+                         const T& alpha = T{1}, const T& beta = T{1},
+                         OpCounter* cnt = nullptr, int num_threads = 0) {
+    assert(A.cols == B.rows);
+    assert(C.rows == A.rows and C.cols == B.cols);
+    return mul_shaped_view<T>(view(A), view(B), view(C), EpUpdate<T>{view(C), alpha, beta}, cnt, num_threads);
+}
+
+#endif // ALG_SHAPES_H
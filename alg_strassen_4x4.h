@@ -7,6 +7,7 @@
 #define ALG_STRASSEN_4X4_H
 
 #include "structures.h"
+#include "fixed_matrix.h"
 
 // Вспомогательные функции для операций с 2×2 блоками
 
@@ -70,10 +71,10 @@ void mul_strassen_4x4(const Matrix<T>& A, const Matrix<T>& B, Matrix<T>& C,
     auto C21 = subview(C_view, 2, 0, 2, 2);
     auto C22 = subview(C_view, 2, 2, 2, 2);
 
-    // Временные матрицы для промежуточных результатов
-    Matrix<T> S1(2,2), S2(2,2), S3(2,2), S4(2,2), S5(2,2), S6(2,2), S7(2,2);
-    Matrix<T> P1(2,2), P2(2,2), P3(2,2), P4(2,2), P5(2,2), P6(2,2), P7(2,2);
-    Matrix<T> T1(2,2), T2(2,2);
+    // Временные 2x2 блоки для промежуточных результатов - на стеке
+    FixedMatrix<T,2,2> S1, S2, S3, S4, S5, S6, S7;
+    FixedMatrix<T,2,2> P1, P2, P3, P4, P5, P6, P7;
+    FixedMatrix<T,2,2> T1, T2;
 
     // Вычисляем 7 произведений Strassen
     // P1 = A11 * (B12 - B22)
@@ -149,10 +150,10 @@ void mul_strassen_4x4_view(MatrixView<const T> A, MatrixView<const T> B,
     auto C21 = subview(C, 2, 0, 2, 2);
     auto C22 = subview(C, 2, 2, 2, 2);
 
-    // Временные матрицы
-    Matrix<T> S1(2,2), S2(2,2), S3(2,2), S4(2,2), S5(2,2), S6(2,2), S7(2,2);
-    Matrix<T> P1(2,2), P2(2,2), P3(2,2), P4(2,2), P5(2,2), P6(2,2), P7(2,2);
-    Matrix<T> T1(2,2), T2(2,2);
+    // Временные 2x2 блоки - на стеке
+    FixedMatrix<T,2,2> S1, S2, S3, S4, S5, S6, S7;
+    FixedMatrix<T,2,2> P1, P2, P3, P4, P5, P6, P7;
+    FixedMatrix<T,2,2> T1, T2;
 
     // 7 произведений Strassen
     sub_2x2(B12, B22, view(S1), cnt);
@@ -0,0 +1,239 @@
+//
+// Гибридный Штрассен-Виноград: параллельные подпроизведения наверху, упакованное ядро внизу
+// Верхние parallel_levels уровней рекурсии отдают 7 (или 49) подпроизведений пулу потоков;
+// ниже рекурсия последовательная, а при min(m, k, n) <= cutoff работает базовое ядро:
+// для float / double - упакованное SIMD-ядро из matmul_kernels (dispatch.h, лучший для CPU
+// вариант, один поток), для прочих типов B-блок транспонируется в арену и обе матрицы
+// читаются построчно. Требует компоновки с библиотекой matmul_kernels.
+// Нечётные размеры - динамический peeling: последняя строка/столбец досчитываются отдельно.
+//
+
+#ifndef ALG_STRASSEN_HYBRID_H
+#define ALG_STRASSEN_HYBRID_H
+
+#include "structures.h"
+#include "alg_transpose.h"
+#include "dispatch.h"
+#include "thread_pool.h"
+#include "workspace.h"
+
+struct StrassenHybridOptions {
+    int parallel_levels = 2;      // 0 - последовательно, 1 - 7 задач, 2 - 49 задач
+    int cutoff = 128;             // при min(m, k, n) <= cutoff - базовое ядро
+    ThreadPool* pool = nullptr;   // nullptr - global_thread_pool()
+};
+
+///--------------------------
+///  Базовое ядро
+///--------------------------
+template <class T>
+void sw_leaf(MatrixView<const T> A, MatrixView<const T> B, MatrixView<T> C, OpCounter* cnt) {
+    if constexpr (std::is_same_v<T, double> or std::is_same_v<T, float>) {
+        // Лист уже выполняется в задаче пула - ядро однопоточное
+        if constexpr (std::is_same_v<T, double>)
+            kernels().gemm_f64(A.ptr, A.stride, B.ptr, B.stride, C.ptr, C.stride, A.rows, A.cols, B.cols, 1);
+        else
+            kernels().gemm_f32(A.ptr, A.stride, B.ptr, B.stride, C.ptr, C.stride, A.rows, A.cols, B.cols, 1);
+        if (cnt) {
+            cnt->mul += (uint64_t)A.rows * B.cols * A.cols;
+            cnt->add += (uint64_t)A.rows * B.cols * A.cols;
+        }
+    } else {
+        Workspace& ws = thread_workspace();
+        Workspace::Scope scope(ws);
+        MatrixView<T> Bt(ws.alloc<T>((size_t)B.rows * B.cols), B.cols, B.rows, B.rows);
+        transpose_view(B, Bt, 1);
+        mul_naive_bt_view<T>(A, Bt, C, cnt);
+    }
+}
+
+///--------------------------
+///  Рабочая область
+///--------------------------
+// Сколько байт арены нужно одному потоку на последовательном пути.
+// Потоки пула, выполняющие подзадачи, используют свои арены того же порядка.
+template <class T>
+size_t strassen_hybrid_workspace_bytes(int m, int k, int n, const StrassenHybridOptions& opt = {}) {
+    if (std::min({m, k, n}) <= std::max(opt.cutoff, 1)) {
+        // Ядро matmul_kernels пакует B в собственной арене
+        if constexpr (std::is_same_v<T, double> or std::is_same_v<T, float>) return 0;
+        else return Workspace::aligned_size((size_t)k * n * sizeof(T));
+    }
+    size_t mh = m / 2, kh = k / 2, nh = n / 2;
+    size_t level = 4 * Workspace::aligned_size(mh * kh * sizeof(T))
+                 + 4 * Workspace::aligned_size(kh * nh * sizeof(T))
+                 + 7 * Workspace::aligned_size(mh * nh * sizeof(T));
+    return level + strassen_hybrid_workspace_bytes<T>((int)mh, (int)kh, (int)nh, opt);
+}
+
+///--------------------------
+///  Рекурсия
+///--------------------------
+// Вызывает f(lo, hi) для полос [0, total): в пуле, если parallel, иначе одним куском
+template <class F>
+void sw_bands(bool parallel, ThreadPool& pool, int total, F&& f) {
+    if (!parallel) {
+        f(0, total);
+        return;
+    }
+    int nb = std::max(1, std::min(pool.size() + 1, total));
+    TaskGroup group(pool);
+    for (int b = 0; b < nb; b++) {
+        int lo = (int)((long long)total * b / nb);
+        int hi = (int)((long long)total * (b + 1) / nb);
+        group.run([&f, lo, hi] { f(lo, hi); });
+    }
+    group.wait();
+}
+
+template <class T>
+void sw_rec(MatrixView<const T> A, MatrixView<const T> B, MatrixView<T> C,
+            int par, const StrassenHybridOptions& opt, OpCounter* cnt);
+
+// Чётные m, k, n: один уровень Винограда (7 умножений, 15 сложений)
+template <class T>
+void sw_even(MatrixView<const T> A, MatrixView<const T> B, MatrixView<T> C,
+             int par, const StrassenHybridOptions& opt, OpCounter* cnt) {
+    int mh = A.rows / 2, kh = A.cols / 2, nh = B.cols / 2;
+    ThreadPool& pool = opt.pool ? *opt.pool : global_thread_pool();
+
+    auto A11 = subview(A, 0, 0, mh, kh),  A12 = subview(A, 0, kh, mh, kh);
+    auto A21 = subview(A, mh, 0, mh, kh), A22 = subview(A, mh, kh, mh, kh);
+    auto B11 = subview(B, 0, 0, kh, nh),  B12 = subview(B, 0, nh, kh, nh);
+    auto B21 = subview(B, kh, 0, kh, nh), B22 = subview(B, kh, nh, kh, nh);
+
+    Workspace& ws = thread_workspace();
+    Workspace::Scope scope(ws);
+    auto buf = [&](int r, int c) { return MatrixView<T>(ws.alloc<T>((size_t)r * c), r, c, c); };
+
+    MatrixView<T> S[4], Tm[4], P[7];
+    for (auto& s : S) s = buf(mh, kh);
+    for (auto& t : Tm) t = buf(kh, nh);
+    for (auto& p : P) p = buf(mh, nh);
+
+    // Фаза 1: суммы операндов
+    // S1 = A21 + A22, S2 = S1 - A11, S3 = A11 - A21, S4 = A12 - S2
+    // T1 = B12 - B11, T2 = B22 - T1, T3 = B22 - B12, T4 = T2 - B21
+    sw_bands(par > 0, pool, mh, [&](int lo, int hi) {
+        for (int i = lo; i < hi; i++)
+            for (int j = 0; j < kh; j++) {
+                T s1 = A21(i, j) + A22(i, j);
+                T s2 = s1 - A11(i, j);
+                S[0](i, j) = s1;
+                S[1](i, j) = s2;
+                S[2](i, j) = A11(i, j) - A21(i, j);
+                S[3](i, j) = A12(i, j) - s2;
+            }
+    });
+    sw_bands(par > 0, pool, kh, [&](int lo, int hi) {
+        for (int i = lo; i < hi; i++)
+            for (int j = 0; j < nh; j++) {
+                T t1 = B12(i, j) - B11(i, j);
+                T t2 = B22(i, j) - t1;
+                Tm[0](i, j) = t1;
+                Tm[1](i, j) = t2;
+                Tm[2](i, j) = B22(i, j) - B12(i, j);
+                Tm[3](i, j) = t2 - B21(i, j);
+            }
+    });
+    if (cnt) cnt->add += 4ull * mh * kh + 4ull * kh * nh;
+
+    // Фаза 2: семь независимых произведений
+    MatrixView<const T> lhs[7] = { A11, A12, S[3], A22, S[0], S[1], S[2] };
+    MatrixView<const T> rhs[7] = { B11, B21, B22, Tm[3], Tm[0], Tm[1], Tm[2] };
+
+    if (par > 0) {
+        // У каждой задачи свой счётчик - OpCounter не потокобезопасен
+        OpCounter local[7];
+        TaskGroup group(pool);
+        for (int q = 0; q < 7; q++) {
+            group.run([&, q] { sw_rec<T>(lhs[q], rhs[q], P[q], par - 1, opt, cnt ? &local[q] : nullptr); });
+        }
+        group.wait();
+        if (cnt) {
+            for (auto& l : local) {
+                cnt->add += l.add;
+                cnt->mul += l.mul;
+            }
+        }
+    } else {
+        for (int q = 0; q < 7; q++) sw_rec<T>(lhs[q], rhs[q], P[q], 0, opt, cnt);
+    }
+
+    // Фаза 3: сборка квадрантов C
+    // U2 = P1 + P6, U3 = U2 + P7
+    // C11 = P1 + P2, C12 = U2 + P5 + P3, C21 = U3 - P4, C22 = U3 + P5
+    sw_bands(par > 0, pool, mh, [&](int lo, int hi) {
+        for (int i = lo; i < hi; i++)
+            for (int j = 0; j < nh; j++) {
+                T p1 = P[0](i, j), p5 = P[4](i, j);
+                T u2 = p1 + P[5](i, j);
+                T u3 = u2 + P[6](i, j);
+                C(i, j) = p1 + P[1](i, j);
+                C(i, nh + j) = u2 + p5 + P[2](i, j);
+                C(mh + i, j) = u3 - P[3](i, j);
+                C(mh + i, nh + j) = u3 + p5;
+            }
+    });
+    if (cnt) cnt->add += 7ull * mh * nh;
+}
+
+template <class T>
+void sw_rec(MatrixView<const T> A, MatrixView<const T> B, MatrixView<T> C,
+            int par, const StrassenHybridOptions& opt, OpCounter* cnt) {
+    int m = A.rows, k = A.cols, n = B.cols;
+
+    if (std::min({m, k, n}) <= std::max(opt.cutoff, 1)) {
+        sw_leaf(A, B, C, cnt);
+        return;
+    }
+
+    int m2 = m & ~1, k2 = k & ~1, n2 = n & ~1;
+    sw_even<T>(subview(A, 0, 0, m2, k2), subview(B, 0, 0, k2, n2), subview(C, 0, 0, m2, n2), par, opt, cnt);
+
+    // Peeling: вклад последнего столбца A / строки B при нечётном k
+    if (k2 != k) {
+        for (int i = 0; i < m2; i++) {
+            T a = A(i, k - 1);
+            for (int j = 0; j < n2; j++) C(i, j) = add(C(i, j), mul(a, B(k - 1, j), cnt), cnt);
+        }
+    }
+    // Последний столбец C при нечётном n (включая угол)
+    if (n2 != n) {
+        for (int i = 0; i < m; i++) {
+            T sum = T{};
+            for (int p = 0; p < k; p++) sum = add(sum, mul(A(i, p), B(p, n - 1), cnt), cnt);
+            C(i, n - 1) = sum;
+        }
+    }
+    // Последняя строка C при нечётном m
+    if (m2 != m) {
+        for (int j = 0; j < n2; j++) C(m - 1, j) = T{};
+        for (int p = 0; p < k; p++) {
+            T a = A(m - 1, p);
+            for (int j = 0; j < n2; j++) C(m - 1, j) = add(C(m - 1, j), mul(a, B(p, j), cnt), cnt);
+        }
+    }
+}
+
+///--------------------------
+///  Интерфейс
+///--------------------------
+template <class T>
+void mul_strassen_hybrid_view(MatrixView<const T> A, MatrixView<const T> B, MatrixView<T> C,
+                              const StrassenHybridOptions& opt = {},
+                              OpCounter* cnt = nullptr) {
+    assert(A.cols == B.rows);
+    assert(A.rows == C.rows and B.cols == C.cols);
+    sw_rec<T>(A, B, C, std::max(opt.parallel_levels, 0), opt, cnt);
+}
+
+template <class T>
+void mul_strassen_hybrid(const Matrix<T>& A, const Matrix<T>& B, Matrix<T>& C,
+                         const StrassenHybridOptions& opt = {},
+                         OpCounter* cnt = nullptr) {
+    C.resize(A.rows, B.cols);
+    mul_strassen_hybrid_view<T>(view(A), view(B), view(C), opt, cnt);
+}
+
+#endif // ALG_STRASSEN_HYBRID_H
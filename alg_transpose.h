@@ -0,0 +1,323 @@
+//
+// Транспонирование матриц и naive-умножение на заранее транспонированную B
+// Рекурсия делит большую сторону пополам до блока TRANSPOSE_BLOCK - так блок
+// источника и блок приёмника одновременно помещаются в кэш на любом уровне.
+// Внутри блока - транспонирование в регистрах (SSE2 / AVX / NEON) с скалярным хвостом.
+//
+
+#ifndef ALG_TRANSPOSE_H
+#define ALG_TRANSPOSE_H
+
+#include "structures.h"
+#include "parallel.h"
+#include "workspace.h"
+#include <type_traits>
+#include <utility>
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+static constexpr int TRANSPOSE_BLOCK = 32;
+
+///--------------------------
+///  Микро-транспонирование W x W в регистрах
+///--------------------------
+// W = 1 - скалярный вариант для типов без SIMD-ядра (int, complex, ...)
+template <class T>
+struct MicroTranspose {
+    static constexpr int W = 1;
+    static void run(const T* a, int lda, T* b, int ldb) {
+        (void)lda;
+        (void)ldb;
+        b[0] = a[0];
+    }
+};
+
+#if defined(__AVX__)
+template <>
+struct MicroTranspose<double> {
+    static constexpr int W = 4;
+    static void run(const double* a, int lda, double* b, int ldb) {
+        __m256d r0 = _mm256_loadu_pd(a);
+        __m256d r1 = _mm256_loadu_pd(a + lda);
+        __m256d r2 = _mm256_loadu_pd(a + 2 * lda);
+        __m256d r3 = _mm256_loadu_pd(a + 3 * lda);
+        __m256d t0 = _mm256_unpacklo_pd(r0, r1);
+        __m256d t1 = _mm256_unpackhi_pd(r0, r1);
+        __m256d t2 = _mm256_unpacklo_pd(r2, r3);
+        __m256d t3 = _mm256_unpackhi_pd(r2, r3);
+        _mm256_storeu_pd(b,           _mm256_permute2f128_pd(t0, t2, 0x20));
+        _mm256_storeu_pd(b + ldb,     _mm256_permute2f128_pd(t1, t3, 0x20));
+        _mm256_storeu_pd(b + 2 * ldb, _mm256_permute2f128_pd(t0, t2, 0x31));
+        _mm256_storeu_pd(b + 3 * ldb, _mm256_permute2f128_pd(t1, t3, 0x31));
+    }
+};
+#elif defined(__SSE2__)
+template <>
+struct MicroTranspose<double> {
+    static constexpr int W = 2;
+    static void run(const double* a, int lda, double* b, int ldb) {
+        __m128d r0 = _mm_loadu_pd(a);
+        __m128d r1 = _mm_loadu_pd(a + lda);
+        _mm_storeu_pd(b,       _mm_unpacklo_pd(r0, r1));
+        _mm_storeu_pd(b + ldb, _mm_unpackhi_pd(r0, r1));
+    }
+};
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+template <>
+struct MicroTranspose<double> {
+    static constexpr int W = 2;
+    static void run(const double* a, int lda, double* b, int ldb) {
+        float64x2_t r0 = vld1q_f64(a);
+        float64x2_t r1 = vld1q_f64(a + lda);
+        vst1q_f64(b,       vzip1q_f64(r0, r1));
+        vst1q_f64(b + ldb, vzip2q_f64(r0, r1));
+    }
+};
+#endif
+
+#if defined(__SSE2__)
+template <>
+struct MicroTranspose<float> {
+    static constexpr int W = 4;
+    static void run(const float* a, int lda, float* b, int ldb) {
+        __m128 r0 = _mm_loadu_ps(a);
+        __m128 r1 = _mm_loadu_ps(a + lda);
+        __m128 r2 = _mm_loadu_ps(a + 2 * lda);
+        __m128 r3 = _mm_loadu_ps(a + 3 * lda);
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        _mm_storeu_ps(b, r0);
+        _mm_storeu_ps(b + ldb, r1);
+        _mm_storeu_ps(b + 2 * ldb, r2);
+        _mm_storeu_ps(b + 3 * ldb, r3);
+    }
+};
+#elif defined(__ARM_NEON)
+template <>
+struct MicroTranspose<float> {
+    static constexpr int W = 4;
+    static void run(const float* a, int lda, float* b, int ldb) {
+        float32x4x2_t t01 = vtrnq_f32(vld1q_f32(a), vld1q_f32(a + lda));
+        float32x4x2_t t23 = vtrnq_f32(vld1q_f32(a + 2 * lda), vld1q_f32(a + 3 * lda));
+        vst1q_f32(b,           vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0])));
+        vst1q_f32(b + ldb,     vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1])));
+        vst1q_f32(b + 2 * ldb, vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0])));
+        vst1q_f32(b + 3 * ldb, vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1])));
+    }
+};
+#endif
+
+///--------------------------
+///  Вне места: At = A^T
+///--------------------------
+// Блок до TRANSPOSE_BLOCK x TRANSPOSE_BLOCK: полные W x W - в регистрах, края - скалярно
+template <class T>
+void transpose_block(MatrixView<const T> A, MatrixView<T> At) {
+    constexpr int W = MicroTranspose<T>::W;
+    int r = A.rows, c = A.cols;
+    int rw = r / W * W, cw = c / W * W;
+
+    for (int i = 0; i < rw; i += W)
+        for (int j = 0; j < cw; j += W)
+            MicroTranspose<T>::run(A.ptr + (size_t)i * A.stride + j, A.stride,
+                                   At.ptr + (size_t)j * At.stride + i, At.stride);
+
+    for (int i = 0; i < r; i++)
+        for (int j = (i < rw ? cw : 0); j < c; j++)
+            At(j, i) = A(i, j);
+}
+
+// Делим большую сторону пополам, пока блок не станет достаточно мелким
+template <class T>
+void transpose_rec(MatrixView<const T> A, MatrixView<T> At) {
+    if (A.rows <= TRANSPOSE_BLOCK and A.cols <= TRANSPOSE_BLOCK) {
+        transpose_block(A, At);
+        return;
+    }
+    if (A.rows >= A.cols) {
+        int h = A.rows / 2;
+        transpose_rec<T>(subview(A, 0, 0, h, A.cols), subview(At, 0, 0, At.rows, h));
+        transpose_rec<T>(subview(A, h, 0, A.rows - h, A.cols), subview(At, 0, h, At.rows, A.rows - h));
+    } else {
+        int h = A.cols / 2;
+        transpose_rec<T>(subview(A, 0, 0, A.rows, h), subview(At, 0, 0, h, At.cols));
+        transpose_rec<T>(subview(A, 0, h, A.rows, A.cols - h), subview(At, h, 0, A.cols - h, At.cols));
+    }
+}
+
+// Потоки делят строки At (столбцы A), так что каждый пишет в свою непрерывную полосу
+template <class T>
+void transpose_view(MatrixView<const T> A, MatrixView<T> At, int num_threads = 0) {
+    assert(At.rows == A.cols and At.cols == A.rows);
+    assert(A.ptr != At.ptr);
+
+    parallel_for(0, A.cols, [&](int lo, int hi) {
+        transpose_rec<T>(subview(A, 0, lo, A.rows, hi - lo), subview(At, lo, 0, hi - lo, At.cols));
+    }, num_threads, 4 * TRANSPOSE_BLOCK);
+}
+
+template <class T>
+void transpose(const Matrix<T>& A, Matrix<T>& At, int num_threads = 0) {
+    assert(&A != &At);
+    At.resize(A.cols, A.rows);
+    transpose_view(view(A), view(At), num_threads);
+}
+
+///--------------------------
+///  На месте (квадратная матрица)
+///--------------------------
+// Блок X (r x c) и блок Y (c x r): X <- Y^T, Y <- X^T. Через стековый буфер,
+// чтобы переиспользовать регистровое ядро.
+template <class T>
+void swap_transpose_block(MatrixView<T> X, MatrixView<T> Y) {
+    T tmp[TRANSPOSE_BLOCK * TRANSPOSE_BLOCK];
+    MatrixView<T> Tv(tmp, X.cols, X.rows, X.rows);
+    transpose_block<T>(X, Tv);   // tmp = X^T (c x r)
+    transpose_block<T>(Y, X);    // X = Y^T
+    for (int i = 0; i < Y.rows; i++)
+        for (int j = 0; j < Y.cols; j++)
+            Y(i, j) = Tv(i, j);
+}
+
+template <class T>
+void swap_transpose_rec(MatrixView<T> X, MatrixView<T> Y) {
+    if (X.rows <= TRANSPOSE_BLOCK and X.cols <= TRANSPOSE_BLOCK) {
+        swap_transpose_block(X, Y);
+        return;
+    }
+    if (X.rows >= X.cols) {
+        int h = X.rows / 2;
+        swap_transpose_rec(subview(X, 0, 0, h, X.cols), subview(Y, 0, 0, Y.rows, h));
+        swap_transpose_rec(subview(X, h, 0, X.rows - h, X.cols), subview(Y, 0, h, Y.rows, X.rows - h));
+    } else {
+        int h = X.cols / 2;
+        swap_transpose_rec(subview(X, 0, 0, X.rows, h), subview(Y, 0, 0, h, Y.cols));
+        swap_transpose_rec(subview(X, 0, h, X.rows, X.cols - h), subview(Y, h, 0, X.cols - h, Y.cols));
+    }
+}
+
+// Диагональный квадрант: A00 и A11 - рекурсивно на месте, A01 <-> A10^T
+template <class T>
+void transpose_inplace_rec(MatrixView<T> A) {
+    int n = A.rows;
+    if (n <= TRANSPOSE_BLOCK) {
+        for (int i = 0; i < n; i++)
+            for (int j = i + 1; j < n; j++)
+                std::swap(A(i, j), A(j, i));
+        return;
+    }
+    int h = n / 2;
+    transpose_inplace_rec(subview(A, 0, 0, h, h));
+    transpose_inplace_rec(subview(A, h, h, n - h, n - h));
+    swap_transpose_rec(subview(A, 0, h, h, n - h), subview(A, h, 0, n - h, h));
+}
+
+// Параллельно по полосам строк: полоса p обменивается с симметричной полосой под
+// диагональю. Полосы берутся парами (p, last - p), чтобы уравнять треугольную нагрузку.
+template <class T>
+void transpose_inplace_view(MatrixView<T> A, int num_threads = 0) {
+    assert(A.rows == A.cols);
+    int n = A.rows;
+    constexpr int BAND = 4 * TRANSPOSE_BLOCK;
+    int bands = (n + BAND - 1) / BAND;
+
+    auto do_band = [&](int b) {
+        int r0 = b * BAND;
+        int h = std::min(BAND, n - r0);
+        transpose_inplace_rec(subview(A, r0, r0, h, h));
+        if (r0 + h < n)
+            swap_transpose_rec(subview(A, r0, r0 + h, h, n - r0 - h), subview(A, r0 + h, r0, n - r0 - h, h));
+    };
+
+    parallel_for(0, (bands + 1) / 2, [&](int lo, int hi) {
+        for (int p = lo; p < hi; p++) {
+            do_band(p);
+            if (bands - 1 - p != p) do_band(bands - 1 - p);
+        }
+    }, num_threads);
+}
+
+template <class T>
+void transpose_inplace(Matrix<T>& A, int num_threads = 0) {
+    transpose_inplace_view(view(A), num_threads);
+}
+
+///--------------------------
+///  Naive на транспонированной B
+///--------------------------
+// C = A * Bt^T: обе строки читаются последовательно (скалярное произведение строк).
+// Четыре независимые суммы по k разрывают цепочку зависимостей сложения.
+template <class T>
+void mul_naive_bt_view(MatrixView<const T> A,
+                       MatrixView<const T> Bt,
+                       MatrixView<T> C,
+                       OpCounter* cnt = nullptr) {
+
+    assert(A.cols == Bt.cols);
+    assert(A.rows == C.rows and Bt.rows == C.cols);
+
+    int K = A.cols;
+    int K4 = K / 4 * 4;
+    for (int i = 0; i < A.rows; ++i) {
+        const T* a = A.ptr + (size_t)i * A.stride;
+        for (int j = 0; j < Bt.rows; ++j) {
+            const T* b = Bt.ptr + (size_t)j * Bt.stride;
+            T s0{}, s1{}, s2{}, s3{};
+            int k = 0;
+            for (; k < K4; k += 4) {
+                s0 += a[k] * b[k];
+                s1 += a[k + 1] * b[k + 1];
+                s2 += a[k + 2] * b[k + 2];
+                s3 += a[k + 3] * b[k + 3];
+            }
+            for (; k < K; ++k) s0 += a[k] * b[k];
+            C(i, j) = (s0 + s1) + (s2 + s3);
+        }
+    }
+
+    if (cnt) {
+        cnt->mul += (uint64_t)A.rows * Bt.rows * K;
+        cnt->add += (uint64_t)A.rows * Bt.rows * K;
+    }
+}
+
+// B уже хранится транспонированной (например, переиспользуется между вызовами)
+template <class T>
+void mul_naive_bt(const Matrix<T>& A, const Matrix<T>& Bt, Matrix<T>& C, OpCounter* cnt = nullptr) {
+    C.resize(A.rows, Bt.rows);
+    mul_naive_bt_view(view(A), view(Bt), view(C), cnt);
+}
+
+template <class T>
+size_t mul_naive_transposed_workspace_bytes(int k, int n) {
+    return Workspace::aligned_size((size_t)k * n * sizeof(T));
+}
+
+// B транспонируется один раз во временный буфер из ws, дальше - mul_naive_bt_view
+template <class T>
+void mul_naive_transposed_view(MatrixView<const T> A,
+                               MatrixView<const T> B,
+                               MatrixView<T> C,
+                               OpCounter* cnt = nullptr,
+                               Workspace* ws = nullptr) {
+    assert(A.cols == B.rows);
+    if (ws == nullptr) ws = &thread_workspace();
+    Workspace::Scope scope(*ws);
+
+    MatrixView<T> Bt(ws->alloc<T>((size_t)B.cols * B.rows), B.cols, B.rows, B.rows);
+    transpose_view(B, Bt);
+    mul_naive_bt_view<T>(A, Bt, C, cnt);
+}
+
+template <class T>
+void mul_naive_transposed(const Matrix<T>& A, const Matrix<T>& B, Matrix<T>& C,
+                          OpCounter* cnt = nullptr, Workspace* ws = nullptr) {
+    C.resize(A.rows, B.cols);
+    mul_naive_transposed_view(view(A), view(B), view(C), cnt, ws);
+}
+
+#endif // ALG_TRANSPOSE_H
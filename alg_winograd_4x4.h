@@ -7,16 +7,12 @@
 
 #include "structures.h"
 
-template <class T>
-void mul_winograd_4x4(const Matrix<T>& A,
-                      const Matrix<T>& B,
-                      Matrix<T>& C,
-                      OpCounter* cnt=nullptr) {
-
-    assert(A.rows == 4 && A.cols == 4);
-    assert(B.rows == 4 && B.cols == 4);
-
-    C.resize(4,4);
+// Ядро на любых аксессорах 4x4 (Matrix, MatrixView, FixedMatrix) - без копирования
+template <class T, class AA, class BB, class CC>
+void winograd_4x4_core(const AA& A,
+                       const BB& B,
+                       CC&& C,
+                       OpCounter* cnt=nullptr) {
 
     T p[4], q[4];
 
@@ -51,4 +47,18 @@ void mul_winograd_4x4(const Matrix<T>& A,
     }
 }
 
+template <class T>
+void mul_winograd_4x4(const Matrix<T>& A,
+                      const Matrix<T>& B,
+                      Matrix<T>& C,
+                      OpCounter* cnt=nullptr) {
+
+    assert(A.rows == 4 && A.cols == 4);
+    assert(B.rows == 4 && B.cols == 4);
+
+    C.resize(4,4);
+
+    winograd_4x4_core<T>(A, B, C, cnt);
+}
+
 #endif //UNTITLED3_ALG_WINOGRAD_4X4_H
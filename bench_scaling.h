@@ -0,0 +1,230 @@
+//
+// Масштабирование по потокам для многопоточных движков (double)
+// Сильное: фиксированный n, потоки 1..p; ускорение T1 / Tp, эффективность T1 / (p * Tp).
+// Слабое: работа на поток постоянна, n_p = n_1 * p^(1/3); эффективность - отношение
+// производительности на поток к однопоточной (n_p округляется, поэтому через FLOP/s, а не время).
+// Дисбаланс - по времени занятости каждого потока (parallel_band_observer): max / среднее,
+// а загрузка - суммарная занятость / (p * время умножения).
+// С per_node каждый узел NUMA проходится отдельно: потоки и операнды - только на его ядрах.
+//
+
+#ifndef BENCH_SCALING_H
+#define BENCH_SCALING_H
+
+#include "bench_shapes.h"
+#include "numa.h"
+#include "parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+enum class ScalingMode { STRONG, WEAK };
+
+inline const char* scaling_mode_name(ScalingMode m) { return m == ScalingMode::STRONG ? "strong" : "weak"; }
+
+struct ScalingOptions {
+    std::vector<ScalingMode> modes = {ScalingMode::STRONG, ScalingMode::WEAK};
+    std::vector<int> threads;              // пусто - 1, 2, 4, ... и все ядра (узла)
+    std::vector<std::string> algorithms;   // пусто - все многопоточные движки shape_engines()
+    int strong_size = 1024;                // n для сильного масштабирования
+    int weak_size = 512;                   // n_1 для слабого
+    int samples = 3;                       // лучший из повторов
+    bool per_node = false;
+};
+
+struct ScalingResult {
+    ScalingMode mode = ScalingMode::STRONG;
+    std::string algorithm;
+    int node = -1;                 // системный номер узла; -1 - все ядра
+    int threads = 1;
+    int size = 0;
+    double time_ms = 0;
+    double gflops = 0;
+    double speedup = 1;            // сильное: T1 / Tp; слабое: GFLOP/s(p) / GFLOP/s(1)
+    double efficiency = 1;         // speedup / p
+    double busy_mean_ms = 0, busy_min_ms = 0, busy_max_ms = 0;  // по потокам 0..p-1
+    double imbalance = 1;          // busy_max / busy_mean
+    double utilization = 0;        // sum(busy) / (p * time)
+
+    static std::string csv_header() {
+        return "mode,algorithm,node,threads,size,time_ms,gflops,speedup,efficiency,"
+               "busy_mean_ms,busy_min_ms,busy_max_ms,imbalance,utilization";
+    }
+
+    std::string to_csv() const {
+        std::ostringstream oss;
+        oss << scaling_mode_name(mode) << "," << algorithm << "," << node << "," << threads << "," << size << ","
+            << std::fixed << std::setprecision(6) << time_ms << ","
+            << std::setprecision(3) << gflops << ","
+            << std::setprecision(4) << speedup << "," << efficiency << ","
+            << std::setprecision(6) << busy_mean_ms << "," << busy_min_ms << "," << busy_max_ms << ","
+            << std::setprecision(4) << imbalance << "," << utilization;
+        return oss.str();
+    }
+};
+
+///--------------------------
+///  Занятость потоков
+///--------------------------
+static constexpr int SCALING_MAX_THREADS = 1024;
+
+// Наносекунды работы полос потока t за текущее умножение
+inline std::atomic<int64_t>* scaling_busy_ns() {
+    static std::unique_ptr<std::atomic<int64_t>[]> busy(new std::atomic<int64_t>[SCALING_MAX_THREADS]());
+    return busy.get();
+}
+
+inline void scaling_observe_band(int t, int /*num_threads*/, double busy_ms) {
+    if (t < SCALING_MAX_THREADS)
+        scaling_busy_ns()[t].fetch_add((int64_t)(busy_ms * 1e6), std::memory_order_relaxed);
+}
+
+// Узел для scaling_place_on_node (индекс в NumaTopology)
+inline int& scaling_pin_node() {
+    static int node = 0;
+    return node;
+}
+
+// Поток t - на ядро t по кругу среди ядер выбранного узла
+inline void scaling_place_on_node(int t, int /*num_threads*/) {
+    const auto& cpus = numa_topology().node_cpus[scaling_pin_node()];
+    pin_current_thread_to_cpu(cpus[t % cpus.size()]);
+}
+
+inline std::vector<int> scaling_thread_counts(int max_threads) {
+    std::vector<int> out;
+    for (int p = 1; p < max_threads; p *= 2) out.push_back(p);
+    out.push_back(max_threads);
+    return out;
+}
+
+///--------------------------
+///  Запуск
+///--------------------------
+// Лучший из samples прогонов; занятость потоков - того же прогона.
+// Операнды - NumaMatrix: полосу строк t касается и заполняет поток t из threads,
+// как и в самом умножении, а не один вызывающий поток
+inline ScalingResult run_scaling_point(const ShapeEngine& engine, int size, int threads, int samples) {
+    threads = std::clamp(threads, 1, SCALING_MAX_THREADS);
+    NumaMatrix<double> A(size, size, NumaPolicy::FIRST_TOUCH, threads);
+    NumaMatrix<double> B(size, size, NumaPolicy::FIRST_TOUCH, threads);
+    NumaMatrix<double> C(size, size, NumaPolicy::FIRST_TOUCH, threads);
+    auto VA = view(A), VB = view(B);
+    parallel_for(0, size, [&](int lo, int hi) {
+        fill_random_tile(subview(VA, lo, 0, hi - lo, size), lo, 0, 42, -1.0, 1.0);
+        fill_random_tile(subview(VB, lo, 0, hi - lo, size), lo, 0, 43, -1.0, 1.0);
+    }, threads);
+
+    ScalingResult r;
+    r.algorithm = engine.name;
+    r.threads = threads;
+    r.size = size;
+    std::vector<double> best_busy;
+    for (int s = 0; s < std::max(1, samples); s++) {
+        for (int t = 0; t < threads; t++) scaling_busy_ns()[t].store(0, std::memory_order_relaxed);
+        auto t0 = std::chrono::steady_clock::now();
+        engine.run(view(A), view(B), view(C), threads);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        if (s == 0 or ms < r.time_ms) {
+            r.time_ms = ms;
+            best_busy.assign(threads, 0.0);
+            for (int t = 0; t < threads; t++)
+                best_busy[t] = scaling_busy_ns()[t].load(std::memory_order_relaxed) * 1e-6;
+        }
+    }
+
+    r.gflops = gemm_flops(size, size, size) / (r.time_ms * 1e6);
+    double sum = 0;
+    r.busy_min_ms = best_busy[0];
+    for (double b : best_busy) {
+        sum += b;
+        r.busy_min_ms = std::min(r.busy_min_ms, b);
+        r.busy_max_ms = std::max(r.busy_max_ms, b);
+    }
+    r.busy_mean_ms = sum / threads;
+    r.imbalance = r.busy_mean_ms > 0 ? r.busy_max_ms / r.busy_mean_ms : 1.0;
+    r.utilization = r.time_ms > 0 ? sum / (threads * r.time_ms) : 0.0;
+    return r;
+}
+
+// Все режимы, движки и число потоков на одном множестве ядер (node = -1 - вся машина)
+inline void run_scaling_set(const ScalingOptions& opt, const std::vector<ShapeEngine>& engines, int node,
+                            int max_threads, std::ostream& csv, std::vector<ScalingResult>* out) {
+    std::vector<int> counts = opt.threads.empty() ? scaling_thread_counts(max_threads) : opt.threads;
+    if (counts.front() != 1) counts.insert(counts.begin(), 1);  // база для ускорения
+
+    for (ScalingMode mode : opt.modes) {
+        for (const ShapeEngine& e : engines) {
+            std::cout << "  " << scaling_mode_name(mode) << " " << e.name;
+            if (node >= 0) std::cout << " (node " << node << ")";
+            std::cout << "\n";
+            double base_ms = 0, base_gflops = 0;
+            for (int p : counts) {
+                int size = mode == ScalingMode::STRONG ? opt.strong_size
+                                                       : (int)std::lround(opt.weak_size * std::cbrt((double)p));
+                ScalingResult r = run_scaling_point(e, size, p, opt.samples);
+                r.mode = mode;
+                r.node = node;
+                if (p == 1) {
+                    base_ms = r.time_ms;
+                    base_gflops = r.gflops;
+                }
+                r.speedup = mode == ScalingMode::STRONG ? base_ms / r.time_ms : r.gflops / base_gflops;
+                r.efficiency = r.speedup / p;
+
+                csv << r.to_csv() << "\n";
+                csv.flush();
+                std::cout << "    p=" << std::setw(3) << p << " n=" << std::setw(5) << size
+                          << std::fixed << std::setprecision(2) << std::setw(10) << r.time_ms << " ms "
+                          << std::setw(8) << r.gflops << " GFLOP/s  speedup " << std::setw(6) << r.speedup
+                          << "  eff " << std::setprecision(1) << std::setw(5) << 100 * r.efficiency << "%"
+                          << "  imbalance " << std::setprecision(2) << r.imbalance
+                          << "  util " << std::setprecision(1) << 100 * r.utilization << "%\n";
+                if (out) out->push_back(r);
+            }
+        }
+    }
+}
+
+inline void run_scaling_suite(const ScalingOptions& opt, std::ostream& csv,
+                              std::vector<ScalingResult>* out = nullptr) {
+    std::vector<ShapeEngine> engines;
+    for (auto& e : shape_engines())
+        if (e.threaded and (opt.algorithms.empty() or
+                            std::find(opt.algorithms.begin(), opt.algorithms.end(), e.name) != opt.algorithms.end()))
+            engines.push_back(e);
+
+    BandObserver prev_observer = parallel_band_observer();
+    ThreadPlacement prev_place = parallel_thread_placement();
+    parallel_band_observer() = &scaling_observe_band;
+    csv << ScalingResult::csv_header() << "\n";
+
+    if (!opt.per_node) {
+        run_scaling_set(opt, engines, -1, default_num_threads(), csv, out);
+    } else {
+        const NumaTopology& topo = numa_topology();
+        std::vector<int> all_cpus;
+        for (auto& cpus : topo.node_cpus) all_cpus.insert(all_cpus.end(), cpus.begin(), cpus.end());
+        for (int node = 0; node < topo.nodes(); node++) {
+            // Полосы parallel_for идут в новых потоках на ядрах узла (scaling_place_on_node);
+            // вызывающий поток тоже на узле - для однопоточных точек, которые он считает сам
+            scaling_pin_node() = node;
+            parallel_thread_placement() = &scaling_place_on_node;
+            pin_current_thread(topo.node_cpus[node]);
+            run_scaling_set(opt, engines, topo.node_ids[node], (int)topo.node_cpus[node].size(), csv, out);
+        }
+        pin_current_thread(all_cpus);
+    }
+
+    parallel_band_observer() = prev_observer;
+    parallel_thread_placement() = prev_place;
+}
+
+#endif // BENCH_SCALING_H
@@ -0,0 +1,252 @@
+//
+// Бенчмарк по формам: квадратные размеры с простыми и нечётными n, прямоугольные
+// сетки m x k x n и операнды-подматрицы с шагом и смещением (строки не выровнены).
+// Каждый результат кладётся на roofline (roofline.h): какая доля достижимой при его
+// интенсивности производительности и какая доля пика получена. Пропускная способность
+// измеряется на памяти, поэтому у малых форм, чьи операнды живут в кэше, доля от roofline
+// может превышать 1.
+// Только double: все сравниваемые движки (кроме naive / blocked) - SIMD-ядра для double.
+//
+
+#ifndef BENCH_SHAPES_H
+#define BENCH_SHAPES_H
+
+#include "benchmark.h"
+#include "roofline.h"
+#include "dispatch.h"
+#include "alg_naive.h"
+#include "alg_blocked.h"
+#include "alg_semiring.h"
+#include "alg_shapes.h"
+#include "alg_async.h"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct ShapeCase {
+    int m = 0, k = 0, n = 0;
+};
+
+enum class ShapeLayout {
+    CONTIGUOUS,   // плотная матрица, шаг = cols
+    STRIDED       // подматрица со смещением (1, 1) в буфере с шагом cols + SHAPE_BENCH_PAD
+};
+
+static constexpr int SHAPE_BENCH_PAD = 3;  // нечётный запас: строки не кратны строке кэша
+
+inline const char* shape_layout_name(ShapeLayout l) {
+    return l == ShapeLayout::CONTIGUOUS ? "contiguous" : "strided";
+}
+
+struct ShapeBenchOptions {
+    std::vector<ShapeCase> cases;
+    std::vector<ShapeLayout> layouts = {ShapeLayout::CONTIGUOUS, ShapeLayout::STRIDED};
+    std::vector<std::string> algorithms;   // пусто - все
+    int num_threads = 0;                   // для многопоточных движков (0 - все ядра)
+    int max_samples = 5;                   // повторов на точку
+    double min_time_ms = 50;               // повторять, пока суммарно меньше
+    double slow_max_work = 512.0 * 512 * 512;  // m * k * n, дальше naive / blocked пропускаются
+    bool verify = true;                    // Freivalds на первом прогоне
+};
+
+struct ShapeBenchResult {
+    std::string algorithm;
+    ShapeLayout layout = ShapeLayout::CONTIGUOUS;
+    int m = 0, k = 0, n = 0;
+    int threads = 1;
+    int samples = 0;
+    double best_ms = 0, median_ms = 0;
+    double gflops = 0;            // по лучшему времени
+    double intensity = 0;         // FLOP / байт обязательного трафика
+    double attainable_gflops = 0; // roofline при этой интенсивности
+    double roof_fraction = 0;     // gflops / attainable
+    double peak_fraction = 0;     // gflops / пик
+    bool verified = true;
+
+    static std::string csv_header() {
+        return "algorithm,layout,m,k,n,threads,samples,best_ms,median_ms,gflops,intensity,"
+               "attainable_gflops,roof_fraction,peak_fraction,verified";
+    }
+
+    std::string to_csv() const {
+        std::ostringstream oss;
+        oss << algorithm << "," << shape_layout_name(layout) << "," << m << "," << k << "," << n << ","
+            << threads << "," << samples << ","
+            << std::fixed << std::setprecision(6) << best_ms << "," << median_ms << ","
+            << std::setprecision(3) << gflops << "," << intensity << "," << attainable_gflops << ","
+            << std::setprecision(4) << roof_fraction << "," << peak_fraction << ","
+            << (verified ? 1 : 0);
+        return oss.str();
+    }
+};
+
+///--------------------------
+///  Наборы форм
+///--------------------------
+inline std::vector<int> parse_int_list(const std::string& text) {
+    std::vector<int> out;
+    std::stringstream ss(text);
+    std::string part;
+    while (std::getline(ss, part, ','))
+        if (!part.empty()) out.push_back(std::stoi(part));
+    return out;
+}
+
+// Степени двойки, соседи (2^p +- 1) и простые; full добавляет размеры до 8k+
+inline std::vector<int> shape_sweep_sizes(bool full) {
+    std::vector<int> s = {1, 2, 3, 5, 7, 16, 17, 31, 32, 33, 63, 64, 65, 97, 127, 128, 129,
+                          251, 256, 257, 509, 512, 513, 1021, 1024, 1031};
+    if (full) {
+        for (int x : {2039, 2048, 2053, 4093, 4096, 4099, 8191, 8192, 8209}) s.push_back(x);
+    }
+    return s;
+}
+
+inline std::vector<ShapeCase> square_cases(const std::vector<int>& sizes) {
+    std::vector<ShapeCase> out;
+    for (int s : sizes) out.push_back({s, s, s});
+    return out;
+}
+
+// Декартово произведение m x k x n
+inline std::vector<ShapeCase> grid_cases(const std::vector<int>& ms, const std::vector<int>& ks,
+                                         const std::vector<int>& ns) {
+    std::vector<ShapeCase> out;
+    for (int m : ms)
+        for (int k : ks)
+            for (int n : ns) out.push_back({m, k, n});
+    return out;
+}
+
+///--------------------------
+///  Движки
+///--------------------------
+struct ShapeEngine {
+    std::string name;
+    bool slow;           // O(n^3) без блокировки под кэш: ограничен slow_max_work
+    bool threaded;       // использует num_threads
+    std::function<void(MatrixView<const double>, MatrixView<const double>, MatrixView<double>, int)> run;
+};
+
+inline std::vector<ShapeEngine> shape_engines() {
+    using CV = MatrixView<const double>;
+    using V = MatrixView<double>;
+    return {
+        {"naive", true, false, [](CV A, CV B, V C, int) { mul_naive_view<double>(A, B, C); }},
+        {"blocked", true, false, [](CV A, CV B, V C, int) { mul_blocked_view<double, double>(A, B, C); }},
+        {"semiring", false, true, [](CV A, CV B, V C, int nt) {
+            mul_semiring_view<PlusTimes<double>, double>(A, B, C, EpIdentity{}, nullptr, nt);
+        }},
+        {"shaped", false, true, [](CV A, CV B, V C, int nt) {
+            mul_shaped_view<double>(A, B, C, EpIdentity{}, nullptr, nt);
+        }},
+        {"pipelined", false, true, [](CV A, CV B, V C, int nt) {
+            mul_pipelined_view<PlusTimes<double>, double>(A, B, C, EpIdentity{}, nullptr, nt);
+        }},
+        {"dispatch", false, true, [](CV A, CV B, V C, int nt) {
+            kernels().gemm_f64(A.ptr, A.stride, B.ptr, B.stride, C.ptr, C.stride, A.rows, A.cols, B.cols, nt);
+        }},
+    };
+}
+
+///--------------------------
+///  Запуск
+///--------------------------
+// Операнд в своём буфере; для STRIDED - подматрица со смещением на строку и столбец
+struct ShapeOperand {
+    Matrix<double> storage;
+    MatrixView<double> v;
+
+    ShapeOperand(int rows, int cols, ShapeLayout layout, uint64_t seed) {
+        if (layout == ShapeLayout::CONTIGUOUS) {
+            storage.resize(rows, cols);
+            v = view(storage);
+        } else {
+            storage.resize(rows + 1, cols + 1 + SHAPE_BENCH_PAD);
+            v = subview(view(storage), 1, 1, rows, cols);
+        }
+        fill_random_tile(v, 0, 0, seed, -1.0, 1.0);
+    }
+};
+
+inline ShapeBenchResult run_shape_point(const ShapeEngine& engine, const ShapeCase& sc, ShapeLayout layout,
+                                        const ShapeOperand& A, const ShapeOperand& B, ShapeOperand& C,
+                                        const ShapeBenchOptions& opt, const Roofline& roof) {
+    ShapeBenchResult r;
+    r.algorithm = engine.name;
+    r.layout = layout;
+    r.m = sc.m;
+    r.k = sc.k;
+    r.n = sc.n;
+    r.threads = engine.threaded ? roof.num_threads : 1;
+
+    std::vector<double> times;
+    double total = 0;
+    while ((int)times.size() < std::max(1, opt.max_samples) and (times.empty() or total < opt.min_time_ms)) {
+        auto t0 = std::chrono::steady_clock::now();
+        engine.run(A.v, B.v, C.v, opt.num_threads);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        if (times.empty() and opt.verify) {
+            r.verified = freivalds_check_view<double>(A.v, B.v, C.v).passed;
+        }
+        times.push_back(ms);
+        total += ms;
+    }
+    std::sort(times.begin(), times.end());
+    r.samples = (int)times.size();
+    r.best_ms = times.front();
+    r.median_ms = times[times.size() / 2];
+
+    double flops = gemm_flops(sc.m, sc.k, sc.n);
+    r.gflops = r.best_ms > 0 ? flops / (r.best_ms * 1e6) : 0.0;
+    r.intensity = flops / gemm_min_bytes(sc.m, sc.k, sc.n, sizeof(double));
+    r.attainable_gflops = roof.attainable_gflops(r.intensity);
+    r.roof_fraction = r.attainable_gflops > 0 ? r.gflops / r.attainable_gflops : 0.0;
+    r.peak_fraction = roof.peak_gflops > 0 ? r.gflops / roof.peak_gflops : 0.0;
+    return r;
+}
+
+// roof_single - roofline одного потока (для naive / blocked), roof_multi - на num_threads.
+// Результаты пишутся в csv по мере готовности; возвращает число точек, не прошедших проверку.
+inline int run_shape_suite(const ShapeBenchOptions& opt, const Roofline& roof_single, const Roofline& roof_multi,
+                           std::ostream& csv, std::vector<ShapeBenchResult>* out = nullptr) {
+    std::vector<ShapeEngine> engines;
+    for (auto& e : shape_engines())
+        if (opt.algorithms.empty() or
+            std::find(opt.algorithms.begin(), opt.algorithms.end(), e.name) != opt.algorithms.end())
+            engines.push_back(e);
+
+    csv << ShapeBenchResult::csv_header() << "\n";
+    int failed = 0;
+    for (const ShapeCase& sc : opt.cases) {
+        for (ShapeLayout layout : opt.layouts) {
+            ShapeOperand A(sc.m, sc.k, layout, 42), B(sc.k, sc.n, layout, 43), C(sc.m, sc.n, layout, 44);
+            std::cout << "  " << sc.m << "x" << sc.k << "x" << sc.n << " " << shape_layout_name(layout)
+                      << " (" << shape_class_name(classify_shape(sc.m, sc.k, sc.n)) << ")\n";
+
+            for (const ShapeEngine& e : engines) {
+                if (e.slow and (double)sc.m * sc.k * sc.n > opt.slow_max_work) continue;
+                ShapeBenchResult r = run_shape_point(e, sc, layout, A, B, C, opt,
+                                                     e.threaded ? roof_multi : roof_single);
+                failed += !r.verified;
+                csv << r.to_csv() << "\n";
+                csv.flush();
+                std::cout << "    " << std::left << std::setw(10) << e.name << std::right
+                          << std::fixed << std::setprecision(3) << std::setw(10) << r.best_ms << " ms "
+                          << std::setprecision(2) << std::setw(8) << r.gflops << " GFLOP/s, "
+                          << std::setprecision(1) << std::setw(5) << 100 * r.roof_fraction << "% of roof, "
+                          << std::setw(5) << 100 * r.peak_fraction << "% of peak"
+                          << (r.verified ? "" : " FAILED VERIFICATION") << "\n";
+                if (out) out->push_back(r);
+            }
+        }
+    }
+    return failed;
+}
+
+#endif // BENCH_SHAPES_H
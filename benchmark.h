@@ -8,13 +8,20 @@
 #include "structures.h"
 #include "generators.h"
 #include "rss.h"
+#include "trace.h"
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <map>
 #include <string>
+#include <tuple>
 #include <vector>
 #include <functional>
 #include <iostream>
 #include <iomanip>
 #include <fstream>
+#include <limits>
+#include <sstream>
 
 // Результат одного бенчмарка
 struct BenchmarkResult {
@@ -22,15 +29,20 @@ struct BenchmarkResult {
     std::string matrix_type;    // Тип матрицы (random/symmetric/sparse)
     std::string element_type;   // Тип элементов (double/complex)
     int size;                   // Размер матрицы (n для nxn)
-    double time_ms;             // Время выполнения в миллисекундах
+    double time_ms;             // Время выполнения в миллисекундах (среднее по повторам)
     uint64_t memory_bytes;      // Использованная память в байтах
     uint64_t mul_count;         // Количество умножений
     uint64_t add_count;         // Количество сложений
-    double correctness_error;   // Максимальная ошибка относительно naive
+    double correctness_error;   // Максимальная ошибка относительно naive (или невязка Freivalds)
+    bool verified = true;       // Проверка корректности пройдена
+    int samples = 1;            // Число повторов замера
+    double time_stddev_ms = 0;  // Выборочное стандартное отклонение времени (0 при одном повторе)
+    std::vector<TracePhaseStats> trace;  // Время по фазам (только со сборкой MATMUL_ENABLE_TRACE)
 
-    // CSV заголовок
+    // CSV заголовок; samples и time_stddev_ms - в конце, старые файлы без них читаются (load_csv)
     static std::string csv_header() {
-        return "algorithm,matrix_type,element_type,size,time_ms,memory_bytes,mul_count,add_count,correctness_error";
+        return "algorithm,matrix_type,element_type,size,time_ms,memory_bytes,mul_count,add_count,correctness_error,"
+               "samples,time_stddev_ms";
     }
 
     // Вывод в CSV формате
@@ -44,7 +56,9 @@ struct BenchmarkResult {
             << memory_bytes << ","
             << mul_count << ","
             << add_count << ","
-            << std::scientific << std::setprecision(10) << correctness_error;
+            << std::scientific << std::setprecision(10) << correctness_error << ","
+            << samples << ","
+            << std::fixed << std::setprecision(6) << time_stddev_ms;
         return oss.str();
     }
 
@@ -57,7 +71,8 @@ struct BenchmarkResult {
         std::cout << "Time: " << std::fixed << std::setprecision(3) << time_ms << " ms\n";
         std::cout << "Memory: " << memory_bytes << " bytes\n";
         std::cout << "Operations: " << mul_count << " mul, " << add_count << " add\n";
-        std::cout << "Error vs Naive: " << std::scientific << correctness_error << "\n";
+        std::cout << "Error vs Naive: " << std::scientific << correctness_error
+                  << (verified ? "" : " (FAILED)") << "\n";
         std::cout << "---\n";
     }
 };
@@ -95,6 +110,136 @@ inline double compute_max_diff<std::complex<double>>(
     return max_d;
 }
 
+// Режим проверки корректности
+enum class VerifyMode {
+    NONE,       // не проверять
+    FREIVALDS,  // вероятностная проверка за O(n^2)
+    FULL        // сравнение с эталоном naive, O(n^3)
+};
+
+struct VerifyOptions {
+    VerifyMode mode = VerifyMode::FULL;
+    int trials = 3;              // число случайных векторов Freivalds
+    double tol_factor = 16.0;    // запас к априорной оценке ошибки округления
+    uint64_t seed = 12345;
+};
+
+struct FreivaldsResult {
+    double residual = 0.0;  // max |A(Br) - Cr| по всем испытаниям
+    double ratio = 0.0;     // max невязка / допуск, <= 1 - проверка пройдена
+    bool passed = true;
+};
+
+// Freivalds: сравниваем A(Br) и Cr для случайных r. Каждое испытание O(n^2).
+// Допуск по компоненте i - оценка ошибки округления:
+//   tol_factor * eps * (k * (|A|(|B||r|))_i + n * (|C||r|)_i)
+// Множитель k покрывает накопление в произведении, tol_factor - быстрые алгоритмы
+// (Strassen/Winograd), у которых константа в оценке больше, чем у классического.
+template<class T>
+FreivaldsResult freivalds_check_view(MatrixView<const T> A, MatrixView<const T> B, MatrixView<const T> C,
+                                     int trials = 3, double tol_factor = 16.0, uint64_t seed = 12345) {
+    FreivaldsResult res;
+    if (A.cols != B.rows || C.rows != A.rows || C.cols != B.cols) {
+        res.residual = 1e100;
+        res.ratio = 1e100;
+        res.passed = false;
+        return res;
+    }
+
+    const int m = A.rows, k = A.cols, n = B.cols;
+    const double eps = std::numeric_limits<double>::epsilon();
+
+    std::vector<T> r(n), br(k), abr(m), cr(m);
+    std::vector<double> abs_r(n), abs_br(k), bound_abr(m), bound_cr(m);
+
+    for (int t = 0; t < trials; t++) {
+        for (int j = 0; j < n; j++) {
+            r[j] = rand_scalar_at<T>(seed + t, 0, j, -1.0, 1.0);
+            abs_r[j] = std::abs(r[j]);
+        }
+
+        // br = B r, abs_br = |B||r|
+        for (int p = 0; p < k; p++) {
+            T s = T{};
+            double sa = 0.0;
+            for (int j = 0; j < n; j++) {
+                s += B(p, j) * r[j];
+                sa += std::abs(B(p, j)) * abs_r[j];
+            }
+            br[p] = s;
+            abs_br[p] = sa;
+        }
+
+        // abr = A (B r), cr = C r и их оценки модулей
+        for (int i = 0; i < m; i++) {
+            T s = T{};
+            double sa = 0.0;
+            for (int p = 0; p < k; p++) {
+                s += A(i, p) * br[p];
+                sa += std::abs(A(i, p)) * abs_br[p];
+            }
+            abr[i] = s;
+            bound_abr[i] = sa;
+
+            T c = T{};
+            double ca = 0.0;
+            for (int j = 0; j < n; j++) {
+                c += C(i, j) * r[j];
+                ca += std::abs(C(i, j)) * abs_r[j];
+            }
+            cr[i] = c;
+            bound_cr[i] = ca;
+        }
+
+        for (int i = 0; i < m; i++) {
+            double d = std::abs(abr[i] - cr[i]);
+            double tol = tol_factor * eps * ((double)k * bound_abr[i] + (double)n * bound_cr[i]);
+            res.residual = std::max(res.residual, d);
+            // NaN в C не должен проходить проверку
+            double ratio = (d == d) ? (tol > 0.0 ? d / tol : (d > 0.0 ? 1e100 : 0.0)) : 1e100;
+            res.ratio = std::max(res.ratio, ratio);
+        }
+    }
+
+    res.passed = res.ratio <= 1.0;
+    return res;
+}
+
+template<class T>
+FreivaldsResult freivalds_check(const Matrix<T>& A, const Matrix<T>& B, const Matrix<T>& C,
+                                int trials = 3, double tol_factor = 16.0, uint64_t seed = 12345) {
+    return freivalds_check_view<T>(view(A), view(B), view(C), trials, tol_factor, seed);
+}
+
+///--------------------------
+///  Статистика повторов
+///--------------------------
+inline double sample_mean(const std::vector<double>& x) {
+    double s = 0;
+    for (double v : x) s += v;
+    return x.empty() ? 0.0 : s / x.size();
+}
+
+// Несмещённое стандартное отклонение; 0, если повторов меньше двух
+inline double sample_stddev(const std::vector<double>& x) {
+    if (x.size() < 2) return 0.0;
+    double m = sample_mean(x), s = 0;
+    for (double v : x) s += (v - m) * (v - m);
+    return std::sqrt(s / (x.size() - 1));
+}
+
+// Квантиль t-распределения Стьюдента для двустороннего 95% интервала
+inline double student_t95(double df) {
+    static const double table[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                   2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                   2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+    if (df < 1) return table[0];
+    if (df <= 30) return table[(int)df - 1];
+    // Разложение Корниша - Фишера около нормального квантиля
+    const double z = 1.959964;
+    return z + (z * z * z + z) / (4 * df) + (5 * std::pow(z, 5) + 16 * z * z * z + 3 * z) / (96 * df * df);
+}
+
 // Запуск одного бенчмарка
 template<class T>
 BenchmarkResult run_single_benchmark(
@@ -105,7 +250,9 @@ BenchmarkResult run_single_benchmark(
     const Matrix<T>& A,
     const Matrix<T>& B,
     std::function<void(const Matrix<T>&, const Matrix<T>&, Matrix<T>&, OpCounter*)> multiply_func,
-    const Matrix<T>* C_reference = nullptr  // Для проверки корректности
+    const Matrix<T>* C_reference = nullptr,  // Для проверки корректности
+    const VerifyOptions& verify = VerifyOptions{},
+    int samples = 1                          // Повторов замера (для доверительных интервалов)
 ) {
     BenchmarkResult result;
     result.algorithm = algo_name;
@@ -119,21 +266,37 @@ BenchmarkResult run_single_benchmark(
     // Измеряем память до и после
     uint64_t rss_before = current_rss_bytes();
 
-    // Измеряем время
-    auto t_start = std::chrono::steady_clock::now();
-    multiply_func(A, B, C, &cnt);
-    auto t_end = std::chrono::steady_clock::now();
-
-    uint64_t rss_after = current_rss_bytes();
+    // Измеряем время; память и счётчики операций - по первому повтору
+    trace_reset_summary();
+    std::vector<double> times;
+    uint64_t rss_after = 0;
+    for (int s = 0; s < std::max(1, samples); s++) {
+        OpCounter run_cnt;
+        auto t_start = std::chrono::steady_clock::now();
+        multiply_func(A, B, C, &run_cnt);
+        auto t_end = std::chrono::steady_clock::now();
+        times.push_back(std::chrono::duration<double, std::milli>(t_end - t_start).count());
+        if (s == 0) {
+            rss_after = current_rss_bytes();
+            cnt = run_cnt;
+        }
+    }
+    result.trace = trace_summary();
 
     // Сохраняем результаты
-    result.time_ms = std::chrono::duration<double, std::milli>(t_end - t_start).count();
+    result.samples = (int)times.size();
+    result.time_ms = sample_mean(times);
+    result.time_stddev_ms = sample_stddev(times);
     result.memory_bytes = (rss_after > rss_before) ? (rss_after - rss_before) : 0;
     result.mul_count = cnt.mul;
     result.add_count = cnt.add;
 
     // Проверяем корректность
-    if (C_reference != nullptr) {
+    if (verify.mode == VerifyMode::FREIVALDS) {
+        auto fr = freivalds_check(A, B, C, verify.trials, verify.tol_factor, verify.seed);
+        result.correctness_error = fr.residual;
+        result.verified = fr.passed;
+    } else if (verify.mode == VerifyMode::FULL && C_reference != nullptr) {
         result.correctness_error = compute_max_diff(C, *C_reference);
     } else {
         result.correctness_error = 0.0;
@@ -168,6 +331,99 @@ std::pair<Matrix<T>, Matrix<T>> generate_matrices(
     }
 }
 
+///--------------------------
+///  Сравнение с базовой линией
+///--------------------------
+enum class CompareStatus {
+    UNCHANGED,   // разница не значима
+    FASTER,      // значимо быстрее
+    SLOWER,      // значимо медленнее, но в пределах порога
+    REGRESSION,  // значимо медленнее и хуже порога
+    UNTESTED     // у одной из сторон < 2 повторов: только ускорение, без проверки значимости
+};
+
+inline const char* compare_status_name(CompareStatus s) {
+    switch (s) {
+        case CompareStatus::FASTER: return "faster";
+        case CompareStatus::SLOWER: return "slower";
+        case CompareStatus::REGRESSION: return "REGRESSION";
+        case CompareStatus::UNTESTED: return "untested";
+        default: return "unchanged";
+    }
+}
+
+// Строка базовой линии и текущего прогона с одним ключом (algorithm, matrix_type, element_type, size)
+struct BenchmarkComparison {
+    std::string algorithm;
+    std::string matrix_type;
+    std::string element_type;
+    int size = 0;
+    double baseline_ms = 0, current_ms = 0;
+    int baseline_samples = 1, current_samples = 1;
+    double speedup = 1;                        // baseline / current, > 1 - стало быстрее
+    double speedup_lo = 1, speedup_hi = 1;     // 95% доверительный интервал
+    bool has_ci = false;                       // у обеих сторон >= 2 повторов
+    CompareStatus status = CompareStatus::UNCHANGED;
+
+    static std::string csv_header() {
+        return "algorithm,matrix_type,element_type,size,baseline_ms,current_ms,baseline_samples,current_samples,"
+               "speedup,speedup_lo,speedup_hi,status";
+    }
+
+    std::string to_csv() const {
+        std::ostringstream oss;
+        oss << algorithm << "," << matrix_type << "," << element_type << "," << size << ","
+            << std::fixed << std::setprecision(6) << baseline_ms << "," << current_ms << ","
+            << baseline_samples << "," << current_samples << ","
+            << std::setprecision(4) << speedup << ",";
+        if (has_ci) oss << speedup_lo << "," << speedup_hi << ",";
+        else oss << ",,";
+        oss << compare_status_name(status);
+        return oss.str();
+    }
+};
+
+// Интервал для отношения средних строится в логарифмах (дельта-метод):
+// se^2 = s_b^2 / (n_b * b^2) + s_c^2 / (n_c * c^2), степени свободы - по Уэлчу.
+// Регрессия - весь интервал ниже 1 и точечная оценка хуже порога: c > b * (1 + threshold).
+// Разброс одной стороны ничего не говорит о другой, поэтому вердикт - только когда повторы есть у обеих.
+inline BenchmarkComparison compare_results(const BenchmarkResult& base, const BenchmarkResult& cur,
+                                           double threshold) {
+    BenchmarkComparison c;
+    c.algorithm = cur.algorithm;
+    c.matrix_type = cur.matrix_type;
+    c.element_type = cur.element_type;
+    c.size = cur.size;
+    c.baseline_ms = base.time_ms;
+    c.current_ms = cur.time_ms;
+    c.baseline_samples = base.samples;
+    c.current_samples = cur.samples;
+    if (base.time_ms <= 0 or cur.time_ms <= 0) return c;
+
+    c.speedup = base.time_ms / cur.time_ms;
+    auto rel_var = [](const BenchmarkResult& r) {
+        return r.time_stddev_ms * r.time_stddev_ms / (r.samples * r.time_ms * r.time_ms);
+    };
+    c.has_ci = base.samples >= 2 and cur.samples >= 2;
+    if (c.has_ci) {
+        double vb = rel_var(base), vc = rel_var(cur);
+        double se = std::sqrt(vb + vc);
+        double denom = vb * vb / (base.samples - 1) + vc * vc / (cur.samples - 1);
+        double df = denom > 0 ? (vb + vc) * (vb + vc) / denom : 1e9;
+        double half = student_t95(df) * se;
+        c.speedup_lo = c.speedup * std::exp(-half);
+        c.speedup_hi = c.speedup * std::exp(half);
+
+        if (c.speedup_lo > 1) c.status = CompareStatus::FASTER;
+        else if (c.speedup_hi < 1)
+            c.status = c.speedup < 1 / (1 + threshold) ? CompareStatus::REGRESSION : CompareStatus::SLOWER;
+    } else {
+        c.speedup_lo = c.speedup_hi = c.speedup;
+        c.status = CompareStatus::UNTESTED;
+    }
+    return c;
+}
+
 // Класс для управления бенчмарками
 class BenchmarkSuite {
 private:
@@ -204,6 +460,77 @@ public:
         std::cout << "Results saved to " << filename << "\n";
     }
 
+    // Читает CSV, записанный save_csv (в том числе старого формата без samples / time_stddev_ms).
+    // Столбцы ищутся по заголовку; false - файла нет или нет обязательных столбцов
+    static bool load_csv(const std::string& filename, std::vector<BenchmarkResult>& out) {
+        std::ifstream file(filename);
+        if (!file.is_open()) {
+            std::cerr << "Failed to open " << filename << " for reading\n";
+            return false;
+        }
+        auto split = [](const std::string& line) {
+            std::vector<std::string> cells;
+            std::stringstream ss(line);
+            std::string cell;
+            while (std::getline(ss, cell, ',')) cells.push_back(cell);
+            return cells;
+        };
+
+        std::string line;
+        if (!std::getline(file, line)) return false;
+        std::map<std::string, size_t> col;
+        auto header = split(line);
+        for (size_t i = 0; i < header.size(); i++) col[header[i]] = i;
+        for (const char* required : {"algorithm", "matrix_type", "element_type", "size", "time_ms"}) {
+            if (!col.count(required)) {
+                std::cerr << filename << ": no column " << required << "\n";
+                return false;
+            }
+        }
+
+        while (std::getline(file, line)) {
+            auto cells = split(line);
+            if (cells.size() < header.size()) continue;
+            auto get = [&](const char* name) { return col.count(name) ? cells[col[name]] : std::string(); };
+            BenchmarkResult r;
+            r.algorithm = get("algorithm");
+            r.matrix_type = get("matrix_type");
+            r.element_type = get("element_type");
+            r.size = std::stoi(get("size"));
+            r.time_ms = std::stod(get("time_ms"));
+            r.memory_bytes = col.count("memory_bytes") ? std::stoull(get("memory_bytes")) : 0;
+            r.mul_count = col.count("mul_count") ? std::stoull(get("mul_count")) : 0;
+            r.add_count = col.count("add_count") ? std::stoull(get("add_count")) : 0;
+            r.correctness_error = col.count("correctness_error") ? std::stod(get("correctness_error")) : 0.0;
+            r.samples = col.count("samples") ? std::stoi(get("samples")) : 1;
+            r.time_stddev_ms = col.count("time_stddev_ms") ? std::stod(get("time_stddev_ms")) : 0.0;
+            out.push_back(r);
+        }
+        return true;
+    }
+
+    // Сопоставляет результаты с baseline по (algorithm, matrix_type, element_type, size);
+    // unmatched - сколько текущих строк не нашлось в baseline
+    std::vector<BenchmarkComparison> compare_to(const std::vector<BenchmarkResult>& baseline,
+                                                double threshold, int* unmatched = nullptr) const {
+        using Key = std::tuple<std::string, std::string, std::string, int>;
+        std::map<Key, const BenchmarkResult*> base;
+        for (const auto& b : baseline) base[Key(b.algorithm, b.matrix_type, b.element_type, b.size)] = &b;
+
+        std::vector<BenchmarkComparison> out;
+        int missing = 0;
+        for (const auto& r : results) {
+            auto it = base.find(Key(r.algorithm, r.matrix_type, r.element_type, r.size));
+            if (it == base.end()) {
+                missing++;
+                continue;
+            }
+            out.push_back(compare_results(*it->second, r, threshold));
+        }
+        if (unmatched) *unmatched = missing;
+        return out;
+    }
+
     void clear() {
         results.clear();
     }
@@ -0,0 +1,113 @@
+//
+// Булева матрица, упакованная по строкам в 64-битные слова
+// Бит j строки i - (data[i * words + j / 64] >> (j % 64)) & 1.
+// Биты за cols в последнем слове строки всегда нулевые - на это опираются
+// сравнение, popcount и произведения в alg_boolean.h.
+//
+
+#ifndef BIT_MATRIX_H
+#define BIT_MATRIX_H
+
+#include "structures.h"
+#include "parallel.h"
+#include <cstdint>
+#include <vector>
+
+struct BitMatrix {
+    int rows = 0, cols = 0;
+    int words = 0;                 // слов на строку
+    std::vector<uint64_t> data;
+
+    BitMatrix() = default;
+    BitMatrix(int r, int c) { resize(r, c); }
+
+    void resize(int r, int c) {
+        rows = r;
+        cols = c;
+        words = (c + 63) / 64;
+        data.assign((size_t)r * words, 0);
+    }
+
+    uint64_t* row(int i) { return data.data() + (size_t)i * words; }
+    const uint64_t* row(int i) const { return data.data() + (size_t)i * words; }
+
+    bool get(int i, int j) const {
+        assert(0 <= i and i < rows and 0 <= j and j < cols);
+        return (row(i)[j >> 6] >> (j & 63)) & 1;
+    }
+
+    void set(int i, int j, bool v = true) {
+        assert(0 <= i and i < rows and 0 <= j and j < cols);
+        uint64_t bit = 1ull << (j & 63);
+        if (v) row(i)[j >> 6] |= bit;
+        else row(i)[j >> 6] &= ~bit;
+    }
+
+    size_t count() const {
+        size_t s = 0;
+        for (uint64_t w : data) s += (size_t)__builtin_popcountll(w);
+        return s;
+    }
+
+    bool operator==(const BitMatrix& o) const {
+        return rows == o.rows and cols == o.cols and data == o.data;
+    }
+    bool operator!=(const BitMatrix& o) const { return !(*this == o); }
+};
+
+// Единичная матрица n x n
+inline BitMatrix bit_identity(int n) {
+    BitMatrix I(n, n);
+    for (int i = 0; i < n; i++) I.set(i, i);
+    return I;
+}
+
+// Транспонирование обходом установленных битов: O(rows * words + nnz)
+inline BitMatrix bit_transpose(const BitMatrix& A) {
+    BitMatrix T(A.cols, A.rows);
+    for (int i = 0; i < A.rows; i++) {
+        const uint64_t* r = A.row(i);
+        for (int w = 0; w < A.words; w++) {
+            uint64_t x = r[w];
+            while (x) {
+                int j = w * 64 + __builtin_ctzll(x);
+                T.row(j)[i >> 6] |= 1ull << (i & 63);
+                x &= x - 1;
+            }
+        }
+    }
+    return T;
+}
+
+///--------------------------
+///  Преобразования
+///--------------------------
+// Ненулевой элемент -> 1
+template <class T>
+BitMatrix to_bit_matrix(MatrixView<const T> A, int num_threads = 0) {
+    BitMatrix R(A.rows, A.cols);
+    parallel_for(0, A.rows, [&](int lo, int hi) {
+        for (int i = lo; i < hi; i++) {
+            uint64_t* dst = R.row(i);
+            for (int j = 0; j < A.cols; j++)
+                if (A(i, j) != T{}) dst[j >> 6] |= 1ull << (j & 63);
+        }
+    }, num_threads, 64);
+    return R;
+}
+
+template <class T>
+BitMatrix to_bit_matrix(const Matrix<T>& A, int num_threads = 0) {
+    return to_bit_matrix<T>(view(A), num_threads);
+}
+
+// 1 -> T(1), 0 -> T{}
+template <class T>
+void from_bit_matrix(const BitMatrix& A, Matrix<T>& C) {
+    C.resize(A.rows, A.cols);
+    for (int i = 0; i < A.rows; i++)
+        for (int j = 0; j < A.cols; j++)
+            C(i, j) = A.get(i, j) ? T(1) : T{};
+}
+
+#endif // BIT_MATRIX_H
@@ -0,0 +1,72 @@
+//
+// Определение CPU и выбор таблицы ядер
+//
+
+#include "dispatch.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace kernels_baseline { extern const KernelTable table; }
+#if defined(__x86_64__) || defined(__i386__)
+namespace kernels_sse42 { extern const KernelTable table; }
+namespace kernels_avx2 { extern const KernelTable table; }
+namespace kernels_avx512 { extern const KernelTable table; }
+namespace kernels_avx512vnni { extern const KernelTable table; }
+#endif
+
+const char* isa_name(CpuIsa isa) {
+    switch (isa) {
+        case CpuIsa::BASELINE: return "baseline";
+        case CpuIsa::SSE42: return "sse42";
+        case CpuIsa::AVX2: return "avx2";
+        case CpuIsa::AVX512: return "avx512";
+        case CpuIsa::AVX512VNNI: return "avx512vnni";
+    }
+    return "unknown";
+}
+
+CpuIsa detect_cpu_isa() {
+#if defined(__x86_64__) || defined(__i386__)
+    // __builtin_cpu_supports учитывает и поддержку ОС (XSAVE / XGETBV для регистров AVX)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") and __builtin_cpu_supports("avx512bw") and
+        __builtin_cpu_supports("avx512vl"))
+        return __builtin_cpu_supports("avx512vnni") ? CpuIsa::AVX512VNNI : CpuIsa::AVX512;
+    if (__builtin_cpu_supports("avx2") and __builtin_cpu_supports("fma") and __builtin_cpu_supports("bmi2"))
+        return CpuIsa::AVX2;
+    if (__builtin_cpu_supports("sse4.2") and __builtin_cpu_supports("popcnt"))
+        return CpuIsa::SSE42;
+#endif
+    return CpuIsa::BASELINE;
+}
+
+const KernelTable* kernel_table(CpuIsa isa) {
+    switch (isa) {
+        case CpuIsa::BASELINE: return &kernels_baseline::table;
+#if defined(__x86_64__) || defined(__i386__)
+        case CpuIsa::SSE42: return &kernels_sse42::table;
+        case CpuIsa::AVX2: return &kernels_avx2::table;
+        case CpuIsa::AVX512: return &kernels_avx512::table;
+        case CpuIsa::AVX512VNNI: return &kernels_avx512vnni::table;
+#endif
+        default: return nullptr;
+    }
+}
+
+// Лучший собранный вариант не выше min(процессор, MATMUL_ISA)
+static const KernelTable& select_kernels() {
+    int level = (int)detect_cpu_isa();
+    if (const char* env = std::getenv("MATMUL_ISA")) {
+        for (int l = (int)CpuIsa::BASELINE; l <= (int)CpuIsa::AVX512VNNI; l++)
+            if (std::strcmp(env, isa_name((CpuIsa)l)) == 0) level = std::min(level, l);
+    }
+    for (; level > (int)CpuIsa::BASELINE; level--)
+        if (const KernelTable* t = kernel_table((CpuIsa)level)) return *t;
+    return kernels_baseline::table;
+}
+
+const KernelTable& kernels() {
+    static const KernelTable& selected = select_kernels();
+    return selected;
+}
@@ -0,0 +1,61 @@
+//
+// Выбор ядер по CPU во время выполнения
+// Горячие ядра собраны в библиотеку в нескольких вариантах (kernels_*.cpp):
+// baseline, SSE4.2, AVX2 + FMA, AVX-512 (F / BW / VL), AVX-512 + VNNI. При первом вызове
+// kernels() процессор опрашивается через CPUID, и дальше все вызовы идут через
+// таблицу указателей лучшего поддерживаемого варианта.
+// Переменная окружения MATMUL_ISA=baseline|sse42|avx2|avx512|avx512vnni ограничивает выбор сверху.
+//
+// Интерфейс таблицы - сырые указатели и шаги, без типов из structures.h:
+// каждый вариант компилирует заголовки в своём пространстве имён (см. kernels_impl.inc).
+// Обёртки над Matrix - в alg_dispatch.h.
+//
+
+#ifndef DISPATCH_H
+#define DISPATCH_H
+
+enum class CpuIsa {
+    BASELINE,
+    SSE42,
+    AVX2,
+    AVX512,
+    AVX512VNNI      // отдельный уровень: VNNI нужен только int8, а есть не на всех AVX-512 CPU
+};
+
+// C(m x n, шаг ldc) = A(m x k, шаг lda) (op) B(k x n, шаг ldb); num_threads = 0 - все ядра
+using GemmKernelF64 = void (*)(const double* A, int lda, const double* B, int ldb,
+                               double* C, int ldc, int m, int k, int n, int num_threads);
+using GemmKernelF32 = void (*)(const float* A, int lda, const float* B, int ldb,
+                               float* C, int ldc, int m, int k, int n, int num_threads);
+// At(cols x rows, шаг ldt) = A(rows x cols, шаг lda)^T
+using TransposeKernelF64 = void (*)(const double* A, int lda, double* At, int ldt,
+                                    int rows, int cols, int num_threads);
+// Пиковые GFLOP/s double на num_threads потоках (микробенчмарк FMA, microbench.h)
+using PeakKernel = double (*)(int num_threads);
+
+struct KernelTable {
+    CpuIsa isa;
+    const char* name;
+    GemmKernelF64 gemm_f64;          // (+, *), упакованное SIMD-ядро alg_semiring.h
+    GemmKernelF32 gemm_f32;
+    GemmKernelF64 min_plus_f64;      // (min, +)
+    GemmKernelF32 min_plus_f32;
+    GemmKernelF64 max_plus_f64;      // (max, +)
+    GemmKernelF32 max_plus_f32;
+    GemmKernelF32 gemm_int8_f32;     // квантование в int8 и умножение (alg_quant.h)
+    TransposeKernelF64 transpose_f64;
+    PeakKernel peak_gflops_f64;
+};
+
+const char* isa_name(CpuIsa isa);
+
+// Лучший уровень, который поддерживают процессор и ОС
+CpuIsa detect_cpu_isa();
+
+// Таблица варианта или nullptr, если он не собран для этой архитектуры
+const KernelTable* kernel_table(CpuIsa isa);
+
+// Выбранная таблица: определяется один раз, потокобезопасно
+const KernelTable& kernels();
+
+#endif // DISPATCH_H
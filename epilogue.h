@@ -0,0 +1,106 @@
+//
+// Эпилоги: поэлементная постобработка результата прямо при записи тайла C
+// Функтор получает (i, j, x) - координаты элемента в C и накопленное значение,
+// и возвращает то, что нужно записать. Всё раскрывается на этапе компиляции.
+//
+
+#ifndef EPILOGUE_H
+#define EPILOGUE_H
+
+#include <algorithm>
+#include <utility>
+
+// Без постобработки
+struct EpIdentity {
+    template <class V>
+    V operator()(int, int, const V& x) const { return x; }
+};
+
+// x * alpha
+template <class S>
+struct EpScale {
+    S alpha;
+    template <class V>
+    V operator()(int, int, const V& x) const { return alpha * x; }
+};
+
+// x + bias[i] - смещение на строку
+template <class S>
+struct EpRowBias {
+    const S* bias;
+    template <class V>
+    V operator()(int i, int, const V& x) const { return x + bias[i]; }
+};
+
+// x + bias[j] - смещение на столбец
+template <class S>
+struct EpColBias {
+    const S* bias;
+    template <class V>
+    V operator()(int, int j, const V& x) const { return x + bias[j]; }
+};
+
+// alpha * x + beta * c(i, j) - накопление GEMM; c - сам приёмник, элемент читается перед
+// своей же записью. При beta == 0 c не читается (в нём может быть мусор или NaN)
+template <class S>
+struct EpAxpby {
+    S alpha, beta;
+    const S* c;
+    int ldc;
+    template <class V>
+    V operator()(int i, int j, const V& x) const {
+        return beta == S{} ? V(alpha * x) : V(alpha * x + beta * c[(size_t)i * ldc + j]);
+    }
+};
+
+// max(x, 0)
+struct EpReLU {
+    template <class V>
+    V operator()(int, int, const V& x) const { return x < V{} ? V{} : x; }
+};
+
+// min(max(x, lo), hi)
+template <class S>
+struct EpClamp {
+    S lo, hi;
+    template <class V>
+    V operator()(int, int, const V& x) const { return std::min<V>(std::max<V>(x, lo), hi); }
+};
+
+// Произвольная поэлементная функция (tanh, sigmoid, ...)
+template <class F>
+struct EpMap {
+    F f;
+    template <class V>
+    auto operator()(int, int, const V& x) const { return f(x); }
+};
+
+// Приведение к другому типу (например double -> float при записи)
+template <class U>
+struct EpCast {
+    template <class V>
+    U operator()(int, int, const V& x) const { return static_cast<U>(x); }
+};
+
+// Последовательное применение: сначала first, затем second
+template <class E1, class E2>
+struct EpChain {
+    E1 first;
+    E2 second;
+    template <class V>
+    auto operator()(int i, int j, const V& x) const { return second(i, j, first(i, j, x)); }
+};
+
+template <class F>
+EpMap<F> ep_map(F f) { return {std::move(f)}; }
+
+template <class E>
+E epilogue(E e) { return e; }
+
+// epilogue(EpRowBias<double>{b}, EpReLU{}, EpCast<float>{}) - применяются слева направо
+template <class E1, class E2, class... Rest>
+auto epilogue(E1 e1, E2 e2, Rest... rest) {
+    return epilogue(EpChain<E1, E2>{e1, e2}, rest...);
+}
+
+#endif // EPILOGUE_H
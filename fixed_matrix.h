@@ -0,0 +1,158 @@
+//
+// FixedMatrix<T, R, C> - матрица с размерами на этапе компиляции и хранением на стеке
+// Плюс полностью развёрнутые ядра умножения малых блоков (от 2x2 до 16x16)
+//
+
+#ifndef FIXED_MATRIX_H
+#define FIXED_MATRIX_H
+
+#include "structures.h"
+#include <utility>
+
+///--------------------------
+///        FixedMatrix
+///--------------------------
+template <class T, int R, int C>
+struct FixedMatrix {
+    static_assert(R > 0 && C > 0, "FixedMatrix dimensions must be positive");
+
+    static constexpr int rows = R;
+    static constexpr int cols = C;
+
+    T a[R * C];
+
+    T* data() { return a; }
+    const T* data() const { return a; }
+    static constexpr int stride() { return C; }
+
+    void zero() {
+        for (int p = 0; p < R * C; ++p) a[p] = T{};
+    }
+
+    T& operator()(int i, int j) {
+        assert(0 <= i and i < R and 0 <= j and j < C);
+        return a[i * C + j];
+    }
+
+    const T& operator()(int i, int j) const {
+        assert(0 <= i and i < R and 0 <= j and j < C);
+        return a[i * C + j];
+    }
+};
+
+template <class T, int R, int C>
+MatrixView<T> view(FixedMatrix<T, R, C>& M) {
+    return { M.data(), R, C, C };
+}
+
+template <class T, int R, int C>
+MatrixView<const T> view(const FixedMatrix<T, R, C>& M) {
+    return { M.data(), R, C, C };
+}
+
+// Копирование из view и обратно (для блоков, которые выгоднее держать на стеке)
+template <class T, int R, int C>
+void load_fixed(MatrixView<const T> V, FixedMatrix<T, R, C>& M) {
+    assert(V.rows == R && V.cols == C);
+    for (int i = 0; i < R; ++i)
+        for (int j = 0; j < C; ++j)
+            M(i, j) = V(i, j);
+}
+
+template <class T, int R, int C>
+void store_fixed(const FixedMatrix<T, R, C>& M, MatrixView<T> V) {
+    assert(V.rows == R && V.cols == C);
+    for (int i = 0; i < R; ++i)
+        for (int j = 0; j < C; ++j)
+            V(i, j) = M(i, j);
+}
+
+///--------------------------
+///  Развёртка на этапе компиляции
+///--------------------------
+// static_for<N>(f) вызывает f(integral_constant<int, 0>) ... f(integral_constant<int, N-1>)
+template <class F, int... I>
+inline void static_for_impl(F&& f, std::integer_sequence<int, I...>) {
+    (f(std::integral_constant<int, I>{}), ...);
+}
+
+template <int N, class F>
+inline void static_for(F&& f) {
+    static_for_impl(f, std::make_integer_sequence<int, N>{});
+}
+
+///--------------------------
+///        Ядра
+///--------------------------
+// C = A * B для блоков M x K и K x N с произвольными шагами строк.
+// Строка C держится в acc[N] (в регистрах), все циклы развёрнуты.
+template <class T, int M, int K, int N>
+inline void fixed_kernel(const T* A, int lda, const T* B, int ldb, T* C, int ldc) {
+    static_assert(M <= 16 && K <= 16 && N <= 16, "fixed kernels are meant for blocks up to 16x16");
+
+    static_for<M>([&](auto i) {
+        T acc[N];
+        static_for<N>([&](auto j) { acc[j] = T{}; });
+        static_for<K>([&](auto p) {
+            const T a = A[i * lda + p];
+            static_for<N>([&](auto j) { acc[j] += a * B[p * ldb + j]; });
+        });
+        static_for<N>([&](auto j) { C[i * ldc + j] = acc[j]; });
+    });
+}
+
+// Подсчёт операций как у mul_naive_view: K умножений и K сложений на элемент C
+template <int M, int K, int N>
+inline void count_fixed_ops(OpCounter* cnt) {
+    if (cnt) {
+        cnt->mul += (uint64_t)M * K * N;
+        cnt->add += (uint64_t)M * K * N;
+    }
+}
+
+template <class T, int M, int K, int N>
+void mul_fixed(const FixedMatrix<T, M, K>& A, const FixedMatrix<T, K, N>& B,
+               FixedMatrix<T, M, N>& C, OpCounter* cnt = nullptr) {
+    fixed_kernel<T, M, K, N>(A.data(), K, B.data(), N, C.data(), N);
+    count_fixed_ops<M, K, N>(cnt);
+}
+
+// То же на view - блоки внутри больших матриц умножаются без копирования
+template <class T, int M, int K, int N>
+void mul_fixed_view(MatrixView<const T> A, MatrixView<const T> B, MatrixView<T> C,
+                    OpCounter* cnt = nullptr) {
+    assert(A.rows == M && A.cols == K);
+    assert(B.rows == K && B.cols == N);
+    assert(C.rows == M && C.cols == N);
+
+    fixed_kernel<T, M, K, N>(A.ptr, A.stride, B.ptr, B.stride, C.ptr, C.stride);
+    count_fixed_ops<M, K, N>(cnt);
+}
+
+// Квадратные блоки n x n, n = 2..16, с выбором специализации во время выполнения.
+// Возвращает false, если для такого размера ядра нет.
+template <class T>
+bool mul_fixed_square_view(MatrixView<const T> A, MatrixView<const T> B, MatrixView<T> C,
+                           OpCounter* cnt = nullptr) {
+    int n = A.rows;
+    if (A.cols != n || B.rows != n || B.cols != n || C.rows != n || C.cols != n) return false;
+
+    using Kernel = void (*)(MatrixView<const T>, MatrixView<const T>, MatrixView<T>, OpCounter*);
+    static constexpr Kernel table[] = {
+        nullptr, nullptr,
+        mul_fixed_view<T, 2, 2, 2>,    mul_fixed_view<T, 3, 3, 3>,
+        mul_fixed_view<T, 4, 4, 4>,    mul_fixed_view<T, 5, 5, 5>,
+        mul_fixed_view<T, 6, 6, 6>,    mul_fixed_view<T, 7, 7, 7>,
+        mul_fixed_view<T, 8, 8, 8>,    mul_fixed_view<T, 9, 9, 9>,
+        mul_fixed_view<T, 10, 10, 10>, mul_fixed_view<T, 11, 11, 11>,
+        mul_fixed_view<T, 12, 12, 12>, mul_fixed_view<T, 13, 13, 13>,
+        mul_fixed_view<T, 14, 14, 14>, mul_fixed_view<T, 15, 15, 15>,
+        mul_fixed_view<T, 16, 16, 16>,
+    };
+
+    if (n < 2 || n > 16) return false;
+    table[n](A, B, C, cnt);
+    return true;
+}
+
+#endif // FIXED_MATRIX_H
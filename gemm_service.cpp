@@ -0,0 +1,151 @@
+//
+// Демон GEMM-сервиса и клиент для проверки (gemm_service.h)
+//   gemm_service serve <socket> [threads]    - работать до SIGINT / SIGTERM
+//   gemm_service stats <socket>              - метрики работающего демона
+//   gemm_service loopback [clients] [requests] - сервер и клиенты в одном процессе,
+//                                              результаты сверяются с наивным умножением
+//
+
+#include "gemm_service.h"
+#include <csignal>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+
+static void print_stats(const ServiceStats& s) {
+    std::printf("requests: %llu (small %llu, large %llu, errors %llu)\n",
+                (unsigned long long)s.requests, (unsigned long long)s.small_requests,
+                (unsigned long long)s.large_requests, (unsigned long long)s.errors);
+    std::printf("batches: %llu, mean batch %.1f\n", (unsigned long long)s.batches, s.mean_batch);
+    std::printf("queue depth: %llu (max %llu), mean wait %.1f us\n",
+                (unsigned long long)s.queue_depth, (unsigned long long)s.max_queue_depth, s.mean_queue_us);
+    std::printf("latency: p50 <= %.0f us, p99 <= %.0f us, max %.0f us\n",
+                s.latency_p50_us, s.latency_p99_us, s.latency_max_us);
+    std::printf("connections: %llu\n", (unsigned long long)s.connections);
+}
+
+static int serve(const std::string& path, int threads) {
+    // Сигналы принимает только main через sigwait: маска наследуется потоками сервера
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGINT);
+    sigaddset(&set, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &set, nullptr);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    ServiceConfig config;
+    config.path = path;
+    config.threads = threads;
+    GemmServer server(config);
+    if (!server.start()) {
+        std::cerr << "cannot listen on " << path << "\n";
+        return 1;
+    }
+    std::cout << "gemm_service: " << path << ", kernels " << kernels().name << "\n";
+    int sig = 0;
+    sigwait(&set, &sig);
+    server.stop();
+    print_stats(server.stats());
+    return 0;
+}
+
+static int query_stats(const std::string& path) {
+    GemmClient client;
+    ServiceStats s;
+    if (!client.connect(path) or !client.stats(s)) {
+        std::cerr << "cannot reach " << path << "\n";
+        return 1;
+    }
+    print_stats(s);
+    return 0;
+}
+
+// Клиент: свой сегмент, случайные малые и изредка большие произведения, сверка каждого
+static bool loopback_client(const std::string& path, int id, int requests) {
+    GemmClient client;
+    if (!client.connect(path)) return false;
+    const int max_dim = 320;
+    SharedSegment seg(3 * (size_t)max_dim * max_dim * sizeof(double) + 256);
+    int64_t sid = seg.ok() ? client.attach(seg) : -1;
+    if (sid < 0) return false;
+
+    std::mt19937 rng(1234 + id);
+    std::uniform_real_distribution<double> val(-1.0, 1.0);
+    bool ok = true;
+    for (int r = 0; r < requests and ok; r++) {
+        bool large = r % 16 == 15;
+        int m = large ? 256 + (int)(rng() % 64) : 1 + (int)(rng() % 48);
+        int k = large ? 256 + (int)(rng() % 64) : 1 + (int)(rng() % 48);
+        int n = large ? 256 + (int)(rng() % 64) : 1 + (int)(rng() % 48);
+
+        seg.reset();
+        uint64_t a = seg.reserve<double>(m, k), b = seg.reserve<double>(k, n), c = seg.reserve<double>(m, n);
+        double* A = seg.at<double>(a);
+        double* B = seg.at<double>(b);
+        for (int i = 0; i < m * k; i++) A[i] = val(rng);
+        for (int i = 0; i < k * n; i++) B[i] = val(rng);
+
+        ServiceResponse resp = client.mul<double>((uint32_t)sid, m, k, n, a, b, c);
+        if (resp.status != ServiceStatus::OK) return false;
+
+        const double* C = seg.at<double>(c);
+        for (int i = 0; i < m and ok; i++)
+            for (int j = 0; j < n; j++) {
+                double s = 0;
+                for (int p = 0; p < k; p++) s += A[i * k + p] * B[p * n + j];
+                if (std::abs(s - C[i * n + j]) > 1e-9 * (k + 1)) {
+                    ok = false;
+                    break;
+                }
+            }
+    }
+    // Запрос за пределы сегмента должен быть отклонён
+    uint64_t id_bad = client.send_mul((uint32_t)sid, ServiceDtype::F64, 1000, 1000, 1000, 0, 1000, 0, 1000, 0, 1000);
+    ServiceResponse resp;
+    if (id_bad == 0 or !client.recv(resp) or resp.status != ServiceStatus::OUT_OF_BOUNDS) ok = false;
+    // Смещение у самого конца адресного пространства: off + размер переполнил бы uint64
+    id_bad = client.send_mul((uint32_t)sid, ServiceDtype::F64, 4, 4, 4, UINT64_MAX - 7, 4, 0, 4, 0, 4);
+    if (id_bad == 0 or !client.recv(resp) or resp.status != ServiceStatus::OUT_OF_BOUNDS) ok = false;
+    return ok and client.detach((uint32_t)sid);
+}
+
+static int loopback(int clients, int requests) {
+    std::signal(SIGPIPE, SIG_IGN);
+    ServiceConfig config;
+    config.path = "/tmp/gemm_service_" + std::to_string(getpid()) + ".sock";
+    GemmServer server(config);
+    if (!server.start()) {
+        std::cerr << "cannot listen on " << config.path << "\n";
+        return 1;
+    }
+
+    std::vector<std::thread> threads;
+    std::vector<char> ok(clients, 0);
+    auto t0 = std::chrono::steady_clock::now();
+    for (int c = 0; c < clients; c++)
+        threads.emplace_back([&, c] { ok[c] = loopback_client(config.path, c, requests); });
+    for (auto& t : threads) t.join();
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+    ServiceStats s = server.stats();
+    server.stop();
+    int failed = 0;
+    for (char x : ok) failed += !x;
+    std::printf("loopback: %d clients x %d requests in %.1f ms, kernels %s, %s\n",
+                clients, requests, ms, kernels().name, failed ? "FAILED" : "all verified");
+    print_stats(s);
+    return failed ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    std::string mode = argc > 1 ? argv[1] : "loopback";
+    if (mode == "serve" and argc > 2) return serve(argv[2], argc > 3 ? std::atoi(argv[3]) : 0);
+    if (mode == "stats" and argc > 2) return query_stats(argv[2]);
+    if (mode == "loopback")
+        return loopback(argc > 2 ? std::atoi(argv[2]) : 8, argc > 3 ? std::atoi(argv[3]) : 200);
+    std::cerr << "usage: gemm_service serve <socket> [threads] | stats <socket> | loopback [clients] [requests]\n";
+    return 2;
+}
@@ -0,0 +1,844 @@
+//
+// Локальный GEMM-сервис: демон на Unix-сокете, операнды - в разделяемой памяти
+// Клиент создаёт сегмент (memfd с печатью от уменьшения на Linux, иначе shm_open), передаёт
+// его дескриптор серверу (SCM_RIGHTS, ATTACH) и дальше шлёт только смещения: сервер читает A, B
+// и пишет C прямо в сегмент, без копий. Несопечатанный сегмент клиент мог бы укоротить после
+// ATTACH, и сервер получил бы SIGBUS, поэтому на Linux сервер принимает только F_SEAL_SHRINK,
+// а где печатей нет - сверяет размер файла перед каждым запросом.
+// Сервер читает сокеты без блокировки, собирая сообщение по частям: клиент, приславший
+// пол-запроса, не задерживает остальные соединения.
+// Малые произведения (m * k * n <= small_work) копятся до batch_max штук или batch_window_us
+// и уходят пачкой в начало очереди пула потоков сервиса, по одному произведению на задачу.
+// Большие режутся на полосы строк C в конце той же очереди; планировщик их не ждёт, поэтому
+// малые, пришедшие во время большого, ждут не дольше одной полосы. Ответ на большой
+// отправляет поток, досчитавший последнюю полосу. Ядра - из matmul_kernels (dispatch.h).
+// Только POSIX; требует компоновки с библиотекой matmul_kernels.
+//
+
+#ifndef GEMM_SERVICE_H
+#define GEMM_SERVICE_H
+
+#include "dispatch.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+///--------------------------
+///  Протокол
+///--------------------------
+// Сообщения фиксированного размера; клиент и сервер на одной машине, порядок байт общий
+static constexpr uint32_t SERVICE_MAGIC = 0x4D4D4753;  // "GSMM"
+
+enum class ServiceOp : uint32_t {
+    ATTACH = 1,   // вместе с сообщением передаётся дескриптор сегмента; size - его размер
+    DETACH = 2,
+    MUL = 3,      // C = A * B в сегменте segment
+    STATS = 4
+};
+
+enum class ServiceDtype : uint32_t {
+    F64 = 0,
+    F32 = 1
+};
+
+enum class ServiceStatus : int32_t {
+    OK = 0,
+    BAD_REQUEST = 1,    // неизвестная операция, неверные размеры
+    BAD_SEGMENT = 2,    // нет такого сегмента, не запечатан, не удалось отобразить
+    OUT_OF_BOUNDS = 3,  // операнд выходит за сегмент или не выровнен
+    SHUTDOWN = 4
+};
+
+struct ServiceRequest {
+    uint32_t magic = SERVICE_MAGIC;
+    ServiceOp op = ServiceOp::MUL;
+    uint64_t id = 0;            // возвращается в ответе
+    uint32_t segment = 0;
+    ServiceDtype dtype = ServiceDtype::F64;
+    int32_t m = 0, k = 0, n = 0;
+    int32_t lda = 0, ldb = 0, ldc = 0;
+    uint64_t size = 0;          // ATTACH: байт в сегменте
+    uint64_t a_off = 0, b_off = 0, c_off = 0;
+};
+
+struct ServiceStats {
+    uint64_t requests = 0;          // принятые MUL
+    uint64_t small_requests = 0;
+    uint64_t large_requests = 0;
+    uint64_t batches = 0;           // пачки малых произведений
+    uint64_t errors = 0;            // отклонённые запросы
+    uint64_t connections = 0;       // открытые соединения
+    uint64_t queue_depth = 0;       // ждут в очереди сейчас
+    uint64_t max_queue_depth = 0;
+    double mean_batch = 0;          // произведений в пачке
+    double mean_queue_us = 0;       // от приёма до начала счёта
+    double latency_p50_us = 0;      // от приёма до отправки ответа
+    double latency_p99_us = 0;
+    double latency_max_us = 0;
+};
+
+struct ServiceResponse {
+    uint32_t magic = SERVICE_MAGIC;
+    ServiceStatus status = ServiceStatus::OK;
+    uint64_t id = 0;
+    uint32_t segment = 0;           // ATTACH: номер сегмента для MUL
+    uint32_t batch = 0;             // MUL: размер пачки, 0 - большое произведение
+    uint64_t queue_ns = 0, compute_ns = 0;
+    ServiceStats stats;             // STATS
+};
+
+#if defined(MSG_NOSIGNAL)
+static constexpr int SERVICE_SEND_FLAGS = MSG_NOSIGNAL;  // закрытый клиент - ошибка, а не SIGPIPE
+#else
+static constexpr int SERVICE_SEND_FLAGS = 0;
+#endif
+
+// Ровно sizeof(T) байт; fd_out - дескриптор из SCM_RIGHTS, если пришёл. false - ошибка или EOF.
+template <class T>
+bool service_recv(int sock, T& msg, int* fd_out = nullptr) {
+    if (fd_out) *fd_out = -1;
+    char* p = reinterpret_cast<char*>(&msg);
+    size_t got = 0;
+    while (got < sizeof(T)) {
+        iovec iov{p + got, sizeof(T) - got};
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+        msghdr mh{};
+        mh.msg_iov = &iov;
+        mh.msg_iovlen = 1;
+        mh.msg_control = control;
+        mh.msg_controllen = sizeof(control);
+        ssize_t r = recvmsg(sock, &mh, 0);
+        if (r < 0 and errno == EINTR) continue;
+        if (r <= 0) return false;
+        for (cmsghdr* c = CMSG_FIRSTHDR(&mh); c; c = CMSG_NXTHDR(&mh, c)) {
+            if (c->cmsg_level == SOL_SOCKET and c->cmsg_type == SCM_RIGHTS) {
+                int fd;
+                std::memcpy(&fd, CMSG_DATA(c), sizeof(int));
+                if (fd_out and *fd_out < 0) *fd_out = fd;
+                else close(fd);
+            }
+        }
+        got += (size_t)r;
+    }
+    return true;
+}
+
+// fd >= 0 - передать дескриптор вместе с сообщением
+template <class T>
+bool service_send(int sock, const T& msg, int fd = -1) {
+    const char* p = reinterpret_cast<const char*>(&msg);
+    size_t sent = 0;
+    while (sent < sizeof(T)) {
+        iovec iov{const_cast<char*>(p + sent), sizeof(T) - sent};
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+        msghdr mh{};
+        mh.msg_iov = &iov;
+        mh.msg_iovlen = 1;
+        if (fd >= 0 and sent == 0) {
+            std::memset(control, 0, sizeof(control));
+            mh.msg_control = control;
+            mh.msg_controllen = sizeof(control);
+            cmsghdr* c = CMSG_FIRSTHDR(&mh);
+            c->cmsg_level = SOL_SOCKET;
+            c->cmsg_type = SCM_RIGHTS;
+            c->cmsg_len = CMSG_LEN(sizeof(int));
+            std::memcpy(CMSG_DATA(c), &fd, sizeof(int));
+        }
+        ssize_t r = sendmsg(sock, &mh, SERVICE_SEND_FLAGS);
+        if (r < 0 and errno == EINTR) continue;
+        if (r <= 0) return false;
+        sent += (size_t)r;
+    }
+    return true;
+}
+
+inline bool service_address(const std::string& path, sockaddr_un& addr) {
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.empty() or path.size() >= sizeof(addr.sun_path)) return false;
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+inline size_t service_elem_bytes(ServiceDtype t) { return t == ServiceDtype::F64 ? sizeof(double) : sizeof(float); }
+
+// Матрица rows x cols с шагом ld по смещению off целиком внутри сегмента и выровнена по элементу.
+// off приходит от клиента: сначала off <= size, затем размах в элементах против остатка -
+// ни сложение, ни умножение не переполняются
+inline bool service_operand_fits(uint64_t off, int rows, int cols, int ld, size_t elem, uint64_t size) {
+    if (rows < 0 or cols < 0 or ld < std::max(cols, 1) or off % elem != 0) return false;
+    if (off > size) return false;
+    if (rows == 0 or cols == 0) return true;
+    uint64_t span = (uint64_t)(rows - 1) * (uint64_t)ld + (uint64_t)cols;  // < 2^62
+    return span <= (size - off) / elem;
+}
+
+///--------------------------
+///  Клиент
+///--------------------------
+// Разделяемый сегмент: имя удаляется сразу, доступ только через переданный дескриптор
+class SharedSegment {
+public:
+    SharedSegment() = default;
+
+    explicit SharedSegment(size_t bytes) {
+#if defined(__linux__) && defined(MFD_ALLOW_SEALING)
+        // Размер запечатан: сервер может держать отображение, не опасаясь SIGBUS
+        fd_ = memfd_create("matmul-segment", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+        if (fd_ < 0) return;
+        bool sized = ftruncate(fd_, (off_t)bytes) == 0 and
+                     fcntl(fd_, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) == 0;
+#else
+        static std::atomic<int> counter{0};
+        std::string name = "/matmul-" + std::to_string(getpid()) + "-" + std::to_string(counter++);
+        fd_ = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd_ < 0) return;
+        shm_unlink(name.c_str());
+        bool sized = ftruncate(fd_, (off_t)bytes) == 0;
+#endif
+        void* p = MAP_FAILED;
+        if (sized) p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (p == MAP_FAILED) {
+            release();
+            return;
+        }
+        data_ = static_cast<char*>(p);
+        size_ = bytes;
+    }
+
+    ~SharedSegment() { release(); }
+
+    SharedSegment(const SharedSegment&) = delete;
+    SharedSegment& operator=(const SharedSegment&) = delete;
+
+    bool ok() const { return data_ != nullptr; }
+    int fd() const { return fd_; }
+    size_t size() const { return size_; }
+    char* data() { return data_; }
+
+    // Место под rows x cols элементов T (шаг cols), выровненное по строке кэша; смещение от начала
+    template <class T>
+    uint64_t reserve(int rows, int cols) {
+        uint64_t off = (used_ + 63) / 64 * 64;
+        uint64_t end = off + (uint64_t)rows * cols * sizeof(T);
+        assert(end <= size_);
+        used_ = end;
+        return off;
+    }
+
+    template <class T>
+    T* at(uint64_t off) { return reinterpret_cast<T*>(data_ + off); }
+
+    void reset() { used_ = 0; }
+
+private:
+    void release() {
+        if (data_) munmap(data_, size_);
+        if (fd_ >= 0) close(fd_);
+        data_ = nullptr;
+        fd_ = -1;
+        size_ = 0;
+    }
+
+    int fd_ = -1;
+    char* data_ = nullptr;
+    size_t size_ = 0;
+    uint64_t used_ = 0;
+};
+
+// Соединение с сервисом. Не потокобезопасен: по клиенту на поток.
+class GemmClient {
+public:
+    GemmClient() = default;
+    ~GemmClient() { disconnect(); }
+
+    GemmClient(const GemmClient&) = delete;
+    GemmClient& operator=(const GemmClient&) = delete;
+
+    bool connect(const std::string& path) {
+        disconnect();
+        sockaddr_un addr;
+        if (!service_address(path, addr)) return false;
+        sock_ = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (sock_ < 0) return false;
+        if (::connect(sock_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            disconnect();
+            return false;
+        }
+        return true;
+    }
+
+    void disconnect() {
+        if (sock_ >= 0) close(sock_);
+        sock_ = -1;
+    }
+
+    bool connected() const { return sock_ >= 0; }
+
+    // Номер сегмента на сервере; -1 - ошибка
+    int64_t attach(const SharedSegment& seg) {
+        ServiceRequest req;
+        req.op = ServiceOp::ATTACH;
+        req.id = next_id_++;
+        req.size = seg.size();
+        ServiceResponse resp;
+        if (!service_send(sock_, req, seg.fd()) or !service_recv(sock_, resp)) return -1;
+        return resp.status == ServiceStatus::OK ? (int64_t)resp.segment : -1;
+    }
+
+    bool detach(uint32_t segment) {
+        ServiceRequest req;
+        req.op = ServiceOp::DETACH;
+        req.id = next_id_++;
+        req.segment = segment;
+        ServiceResponse resp;
+        return service_send(sock_, req) and service_recv(sock_, resp) and resp.status == ServiceStatus::OK;
+    }
+
+    // Отправить MUL без ожидания; ответы приходят в порядке завершения, сверять по id
+    uint64_t send_mul(uint32_t segment, ServiceDtype dtype, int m, int k, int n,
+                      uint64_t a_off, int lda, uint64_t b_off, int ldb, uint64_t c_off, int ldc) {
+        ServiceRequest req;
+        req.op = ServiceOp::MUL;
+        req.id = next_id_++;
+        req.segment = segment;
+        req.dtype = dtype;
+        req.m = m;
+        req.k = k;
+        req.n = n;
+        req.lda = lda;
+        req.ldb = ldb;
+        req.ldc = ldc;
+        req.a_off = a_off;
+        req.b_off = b_off;
+        req.c_off = c_off;
+        return service_send(sock_, req) ? req.id : 0;
+    }
+
+    bool recv(ServiceResponse& resp) { return service_recv(sock_, resp); }
+
+    // Синхронное C = A * B для плотных операндов в сегменте
+    template <class T>
+    ServiceResponse mul(uint32_t segment, int m, int k, int n, uint64_t a_off, uint64_t b_off, uint64_t c_off) {
+        static_assert(std::is_same_v<T, double> or std::is_same_v<T, float>, "service supports double and float");
+        ServiceDtype dtype = std::is_same_v<T, double> ? ServiceDtype::F64 : ServiceDtype::F32;
+        ServiceResponse resp;
+        resp.status = ServiceStatus::BAD_REQUEST;
+        uint64_t id = send_mul(segment, dtype, m, k, n, a_off, k, b_off, n, c_off, n);
+        if (id == 0) return resp;
+        while (service_recv(sock_, resp))
+            if (resp.id == id) return resp;
+        resp.status = ServiceStatus::SHUTDOWN;
+        return resp;
+    }
+
+    bool stats(ServiceStats& out) {
+        ServiceRequest req;
+        req.op = ServiceOp::STATS;
+        req.id = next_id_++;
+        ServiceResponse resp;
+        if (!service_send(sock_, req) or !service_recv(sock_, resp)) return false;
+        out = resp.stats;
+        return true;
+    }
+
+private:
+    int sock_ = -1;
+    uint64_t next_id_ = 1;
+};
+
+///--------------------------
+///  Сервер
+///--------------------------
+struct ServiceConfig {
+    std::string path;                  // путь сокета; существующий файл заменяется
+    int threads = 0;                   // потоков на счёт (0 - все ядра)
+    uint64_t small_work = 96 * 96 * 96;  // m * k * n, до которого произведение считается малым
+    int band_rows = 64;                // наибольшая полоса строк C большого произведения
+    int batch_max = 64;                // малых в пачке
+    int batch_window_us = 200;         // сколько ждать, пока пачка наберётся
+};
+
+class GemmServer {
+    using Clock = std::chrono::steady_clock;
+
+    struct Segment {
+        char* data = nullptr;
+        size_t size = 0;
+        int fd = -1;            // для проверки размера, если сегмент не запечатан
+        bool sealed = false;    // F_SEAL_SHRINK: файл не может стать короче отображения
+        ~Segment() {
+            if (data) munmap(data, size);
+            if (fd >= 0) close(fd);
+        }
+        // Клиент не укоротил файл (для запечатанного - всегда так)
+        bool intact() const {
+            struct stat st;
+            return sealed or (fstat(fd, &st) == 0 and (uint64_t)st.st_size >= size);
+        }
+    };
+
+    struct Connection {
+        int fd = -1;
+        std::mutex write_mutex;                                   // ответы пишут потоки счёта
+        std::unordered_map<uint32_t, std::shared_ptr<Segment>> segments;  // только поток ввода-вывода
+        uint32_t next_segment = 1;
+        // Недочитанный запрос (только поток ввода-вывода)
+        alignas(ServiceRequest) char partial[sizeof(ServiceRequest)];
+        size_t partial_size = 0;
+        int partial_fd = -1;    // дескриптор, пришедший с первой частью
+        ~Connection() {
+            if (fd >= 0) close(fd);
+            if (partial_fd >= 0) close(partial_fd);
+        }
+        void send(const ServiceResponse& resp) {
+            std::lock_guard<std::mutex> lock(write_mutex);
+            service_send(fd, resp);
+        }
+    };
+
+    // Сегмент и соединение удерживаются до ответа, даже если клиент отключился
+    struct Job {
+        ServiceRequest req;
+        std::shared_ptr<Connection> conn;
+        std::shared_ptr<Segment> seg;
+        Clock::time_point received;
+    };
+
+    // Большое произведение, считаемое полосами на пуле
+    struct LargeRun {
+        Job job;
+        Clock::time_point start;
+        std::atomic<int> bands_left{0};
+    };
+
+public:
+    explicit GemmServer(ServiceConfig config) : config_(std::move(config)),
+        pool_(config_.threads > 0 ? config_.threads : default_num_threads()) {}
+
+    ~GemmServer() { stop(); }
+
+    GemmServer(const GemmServer&) = delete;
+    GemmServer& operator=(const GemmServer&) = delete;
+
+    bool start() {
+        sockaddr_un addr;
+        if (!service_address(config_.path, addr)) return false;
+        listen_fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listen_fd_ < 0) return false;
+        unlink(config_.path.c_str());
+        if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 or
+            listen(listen_fd_, 64) != 0 or pipe(wake_) != 0) {
+            close(listen_fd_);
+            listen_fd_ = -1;
+            return false;
+        }
+        running_ = true;
+        io_thread_ = std::thread([this] { io_loop(); });
+        scheduler_thread_ = std::thread([this] { scheduler_loop(); });
+        return true;
+    }
+
+    // Оставшиеся в очереди запросы досчитываются, новые не принимаются
+    void stop() {
+        if (!running_.exchange(false)) return;
+        char c = 0;
+        (void)!write(wake_[1], &c, 1);
+        io_thread_.join();
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            stopping_ = true;
+        }
+        queue_cv_.notify_all();
+        scheduler_thread_.join();
+        {
+            // Задачи на пуле обращаются к метрикам сервера - дожидаемся их до разрушения
+            std::unique_lock<std::mutex> lock(inflight_mutex_);
+            inflight_cv_.wait(lock, [&] { return inflight_ == 0; });
+        }
+        close(listen_fd_);
+        close(wake_[0]);
+        close(wake_[1]);
+        unlink(config_.path.c_str());
+    }
+
+    ServiceStats stats() const {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        ServiceStats s = stats_;
+        s.mean_batch = s.batches ? (double)batched_ / s.batches : 0.0;
+        s.mean_queue_us = completed_ ? queue_us_total_ / completed_ : 0.0;
+        s.latency_p50_us = latency_percentile(0.50);
+        s.latency_p99_us = latency_percentile(0.99);
+        return s;
+    }
+
+private:
+    ///  Приём запросов
+    void io_loop() {
+        std::vector<std::shared_ptr<Connection>> conns;
+        std::vector<pollfd> fds;
+        while (running_) {
+            fds.assign({{wake_[0], POLLIN, 0}, {listen_fd_, POLLIN, 0}});
+            for (auto& c : conns) fds.push_back({c->fd, POLLIN, 0});
+            if (poll(fds.data(), fds.size(), -1) < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            if (fds[0].revents) break;
+
+            std::vector<std::shared_ptr<Connection>> alive;
+            for (size_t i = 0; i < conns.size(); i++) {
+                if (fds[i + 2].revents == 0 or read_messages(conns[i])) alive.push_back(conns[i]);
+            }
+            conns.swap(alive);
+
+            if (fds[1].revents & POLLIN) {
+                int fd = accept(listen_fd_, nullptr, nullptr);
+                if (fd >= 0) {
+                    fcntl(fd, F_SETFD, FD_CLOEXEC);
+                    // Клиент, который не читает ответы, не должен навсегда занять поток сервера
+                    timeval timeout{1, 0};
+                    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+                    auto c = std::make_shared<Connection>();
+                    c->fd = fd;
+                    conns.push_back(std::move(c));
+                }
+            }
+            std::lock_guard<std::mutex> lock(stats_mutex_);
+            stats_.connections = conns.size();
+        }
+    }
+
+    // Всё, что уже пришло, без блокировки: целые запросы обрабатываются, остаток ждёт в partial.
+    // false - соединение закрыто или нарушило протокол
+    bool read_messages(const std::shared_ptr<Connection>& conn) {
+        for (;;) {
+            iovec iov{conn->partial + conn->partial_size, sizeof(ServiceRequest) - conn->partial_size};
+            alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+            msghdr mh{};
+            mh.msg_iov = &iov;
+            mh.msg_iovlen = 1;
+            mh.msg_control = control;
+            mh.msg_controllen = sizeof(control);
+            ssize_t r = recvmsg(conn->fd, &mh, MSG_DONTWAIT);
+            if (r < 0 and errno == EINTR) continue;
+            if (r < 0 and (errno == EAGAIN or errno == EWOULDBLOCK)) return true;
+            if (r <= 0) return false;
+            for (cmsghdr* c = CMSG_FIRSTHDR(&mh); c; c = CMSG_NXTHDR(&mh, c)) {
+                if (c->cmsg_level == SOL_SOCKET and c->cmsg_type == SCM_RIGHTS) {
+                    int fd;
+                    std::memcpy(&fd, CMSG_DATA(c), sizeof(int));
+                    if (conn->partial_fd < 0) conn->partial_fd = fd;
+                    else close(fd);
+                }
+            }
+            conn->partial_size += (size_t)r;
+            if (conn->partial_size < sizeof(ServiceRequest)) continue;
+
+            ServiceRequest req;
+            std::memcpy(&req, conn->partial, sizeof(req));
+            int fd = conn->partial_fd;
+            conn->partial_size = 0;
+            conn->partial_fd = -1;
+            if (!handle_message(conn, req, fd)) return false;
+        }
+    }
+
+    // fd - дескриптор, пришедший с запросом, или -1; закрывается здесь. false - закрыть соединение
+    bool handle_message(const std::shared_ptr<Connection>& conn, const ServiceRequest& req, int fd) {
+        ServiceResponse resp;
+        resp.id = req.id;
+        if (req.magic != SERVICE_MAGIC) {
+            if (fd >= 0) close(fd);
+            return false;
+        }
+
+        switch (req.op) {
+            case ServiceOp::ATTACH: {
+                resp.status = ServiceStatus::BAD_SEGMENT;
+                struct stat st;
+                bool sealed = false;
+#if defined(F_GET_SEALS)
+                int seals = fd >= 0 ? fcntl(fd, F_GET_SEALS) : -1;
+                sealed = seals >= 0 and (seals & F_SEAL_SHRINK);
+                bool acceptable = sealed;   // где печати есть, без них не принимаем
+#else
+                bool acceptable = true;     // размер сверяется перед каждым запросом
+#endif
+                if (fd >= 0 and acceptable and req.size > 0 and fstat(fd, &st) == 0 and
+                    (uint64_t)st.st_size >= req.size) {
+                    void* p = mmap(nullptr, req.size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                    if (p != MAP_FAILED) {
+                        auto seg = std::make_shared<Segment>();
+                        seg->data = static_cast<char*>(p);
+                        seg->size = req.size;
+                        seg->sealed = sealed;
+                        seg->fd = fd;
+                        fd = -1;
+                        resp.segment = conn->next_segment++;
+                        conn->segments[resp.segment] = std::move(seg);
+                        resp.status = ServiceStatus::OK;
+                    }
+                }
+                if (fd >= 0) close(fd);
+                conn->send(resp);
+                return true;
+            }
+            case ServiceOp::DETACH:
+                if (fd >= 0) close(fd);
+                resp.status = conn->segments.erase(req.segment) ? ServiceStatus::OK : ServiceStatus::BAD_SEGMENT;
+                conn->send(resp);
+                return true;
+            case ServiceOp::STATS:
+                if (fd >= 0) close(fd);
+                resp.stats = stats();
+                conn->send(resp);
+                return true;
+            case ServiceOp::MUL:
+                if (fd >= 0) close(fd);
+                submit(conn, req);
+                return true;
+        }
+        if (fd >= 0) close(fd);
+        resp.status = ServiceStatus::BAD_REQUEST;
+        conn->send(resp);
+        return true;
+    }
+
+    void submit(const std::shared_ptr<Connection>& conn, const ServiceRequest& req) {
+        Job job{req, conn, nullptr, Clock::now()};
+        ServiceStatus status = validate(conn, req, job.seg);
+        {
+            std::lock_guard<std::mutex> lock(stats_mutex_);
+            stats_.requests++;
+            if (status != ServiceStatus::OK) stats_.errors++;
+        }
+        if (status != ServiceStatus::OK) {
+            ServiceResponse resp;
+            resp.id = req.id;
+            resp.status = status;
+            conn->send(resp);
+            return;
+        }
+
+        bool small = (uint64_t)req.m * req.k * req.n <= config_.small_work;
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            (small ? small_ : large_).push_back(std::move(job));
+            std::lock_guard<std::mutex> slock(stats_mutex_);
+            stats_.queue_depth = small_.size() + large_.size();
+            stats_.max_queue_depth = std::max(stats_.max_queue_depth, stats_.queue_depth);
+        }
+        queue_cv_.notify_one();
+    }
+
+    ServiceStatus validate(const std::shared_ptr<Connection>& conn, const ServiceRequest& req,
+                           std::shared_ptr<Segment>& seg) const {
+        if (req.dtype != ServiceDtype::F64 and req.dtype != ServiceDtype::F32) return ServiceStatus::BAD_REQUEST;
+        if (req.m < 0 or req.k < 0 or req.n < 0) return ServiceStatus::BAD_REQUEST;
+        auto it = conn->segments.find(req.segment);
+        if (it == conn->segments.end()) return ServiceStatus::BAD_SEGMENT;
+        seg = it->second;
+        if (!seg->intact()) return ServiceStatus::BAD_SEGMENT;
+        size_t e = service_elem_bytes(req.dtype);
+        if (!service_operand_fits(req.a_off, req.m, req.k, req.lda, e, seg->size) or
+            !service_operand_fits(req.b_off, req.k, req.n, req.ldb, e, seg->size) or
+            !service_operand_fits(req.c_off, req.m, req.n, req.ldc, e, seg->size))
+            return ServiceStatus::OUT_OF_BOUNDS;
+        return ServiceStatus::OK;
+    }
+
+    ///  Планировщик
+    void scheduler_loop() {
+        const auto window = std::chrono::microseconds(config_.batch_window_us);
+        for (;;) {
+            std::vector<Job> small, large;
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex_);
+                queue_cv_.wait(lock, [&] { return stopping_ or !small_.empty() or !large_.empty(); });
+                if (small_.empty() and large_.empty()) return;  // stopping_
+                // Пачка малых набирается, пока нет больших и не истекло окно самого старого
+                if (large_.empty() and !stopping_) {
+                    queue_cv_.wait_until(lock, small_.front().received + window, [&] {
+                        return stopping_ or !large_.empty() or (int)small_.size() >= config_.batch_max;
+                    });
+                }
+                size_t take = std::min(small_.size(), (size_t)std::max(1, config_.batch_max));
+                small.assign(std::make_move_iterator(small_.begin()), std::make_move_iterator(small_.begin() + take));
+                small_.erase(small_.begin(), small_.begin() + take);
+                large.assign(std::make_move_iterator(large_.begin()), std::make_move_iterator(large_.end()));
+                large_.clear();
+                std::lock_guard<std::mutex> slock(stats_mutex_);
+                stats_.queue_depth = small_.size();
+            }
+
+            // Ничего не ждём: следующая пачка малых набирается, пока эти считаются
+            if (!small.empty()) dispatch_batch(small);
+            for (auto& job : large) dispatch_large(std::move(job));
+        }
+    }
+
+    void add_inflight(int n) {
+        std::lock_guard<std::mutex> lock(inflight_mutex_);
+        inflight_ += n;
+    }
+
+    void done_inflight() {
+        std::lock_guard<std::mutex> lock(inflight_mutex_);
+        if (--inflight_ == 0) inflight_cv_.notify_all();
+    }
+
+    // Малые - в начало очереди пула, впереди полос больших
+    void dispatch_batch(std::vector<Job>& batch) {
+        {
+            std::lock_guard<std::mutex> lock(stats_mutex_);
+            stats_.batches++;
+            stats_.small_requests += batch.size();
+            batched_ += batch.size();
+        }
+        uint32_t size = (uint32_t)batch.size();
+        add_inflight((int)batch.size());
+        // В обратном порядке, чтобы из начала очереди они выходили в порядке прихода
+        for (auto it = batch.rbegin(); it != batch.rend(); ++it) {
+            auto job = std::make_shared<Job>(std::move(*it));
+            pool_.enqueue_front([this, job, size] {
+                auto start = Clock::now();
+                compute_rows(*job, 0, job->req.m);
+                finish_job(*job, start, size);
+                done_inflight();
+            });
+        }
+    }
+
+    // Примерно по четыре полосы на поток пула, от 16 до band_rows строк: ниже каждая полоса
+    // заново упаковывает B почти зря, выше малые дольше ждут за ней
+    void dispatch_large(Job job) {
+        const int m = job.req.m;
+        int rows = std::clamp((m + 4 * pool_.size() - 1) / (4 * pool_.size()), 16, std::max(16, config_.band_rows));
+        int bands = std::max(1, (m + rows - 1) / rows);
+        auto run = std::make_shared<LargeRun>();
+        run->job = std::move(job);
+        run->start = Clock::now();
+        run->bands_left.store(bands, std::memory_order_relaxed);
+        add_inflight(1);
+        for (int b = 0; b < bands; b++) {
+            int r0 = b * rows, r1 = std::min(m, r0 + rows);
+            pool_.enqueue([this, run, r0, r1] {
+                compute_rows(run->job, r0, r1);
+                if (run->bands_left.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    finish_job(run->job, run->start, 0);
+                    done_inflight();
+                }
+            });
+        }
+    }
+
+    // Строки [r0, r1) C, на одном потоке
+    void compute_rows(const Job& job, int r0, int r1) {
+        const ServiceRequest& r = job.req;
+        char* base = job.seg->data;
+        if (r.dtype == ServiceDtype::F64) {
+            const double* A = reinterpret_cast<const double*>(base + r.a_off) + (size_t)r0 * r.lda;
+            double* C = reinterpret_cast<double*>(base + r.c_off) + (size_t)r0 * r.ldc;
+            kernels().gemm_f64(A, r.lda, reinterpret_cast<const double*>(base + r.b_off), r.ldb,
+                               C, r.ldc, r1 - r0, r.k, r.n, 1);
+        } else {
+            const float* A = reinterpret_cast<const float*>(base + r.a_off) + (size_t)r0 * r.lda;
+            float* C = reinterpret_cast<float*>(base + r.c_off) + (size_t)r0 * r.ldc;
+            kernels().gemm_f32(A, r.lda, reinterpret_cast<const float*>(base + r.b_off), r.ldb,
+                               C, r.ldc, r1 - r0, r.k, r.n, 1);
+        }
+    }
+
+    // Ответ и метрики; batch = 0 - большое произведение
+    void finish_job(Job& job, Clock::time_point start, uint32_t batch) {
+        const ServiceRequest& r = job.req;
+        auto end = Clock::now();
+
+        ServiceResponse resp;
+        resp.id = r.id;
+        resp.batch = batch;
+        resp.queue_ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(start - job.received).count();
+        resp.compute_ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+        job.conn->send(resp);
+
+        double latency_us = std::chrono::duration<double, std::micro>(Clock::now() - job.received).count();
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        if (batch == 0) stats_.large_requests++;
+        completed_++;
+        queue_us_total_ += resp.queue_ns * 1e-3;
+        stats_.latency_max_us = std::max(stats_.latency_max_us, latency_us);
+        latency_hist_[latency_bucket(latency_us)]++;
+    }
+
+    ///  Метрики
+    // Корзина b: задержка в [2^(b-1), 2^b) мкс
+    static constexpr int LATENCY_BUCKETS = 40;
+
+    static int latency_bucket(double us) {
+        int b = 0;
+        while (b + 1 < LATENCY_BUCKETS and us >= (double)(1ull << b)) b++;
+        return b;
+    }
+
+    // Верхняя граница корзины, в которую попадает квантиль q (stats_mutex_ захвачен)
+    double latency_percentile(double q) const {
+        uint64_t total = 0;
+        for (uint64_t c : latency_hist_) total += c;
+        if (total == 0) return 0.0;
+        uint64_t need = (uint64_t)(q * (total - 1)) + 1, acc = 0;
+        for (int b = 0; b < LATENCY_BUCKETS; b++) {
+            acc += latency_hist_[b];
+            if (acc >= need) return std::min((double)(1ull << b), stats_.latency_max_us);
+        }
+        return stats_.latency_max_us;
+    }
+
+    ServiceConfig config_;
+    ThreadPool pool_;
+
+    int listen_fd_ = -1;
+    int wake_[2] = {-1, -1};
+    std::atomic<bool> running_{false};
+    std::thread io_thread_, scheduler_thread_;
+
+    std::mutex queue_mutex_;
+    std::condition_variable queue_cv_;
+    std::deque<Job> small_, large_;
+    bool stopping_ = false;
+
+    std::mutex inflight_mutex_;
+    std::condition_variable inflight_cv_;
+    int inflight_ = 0;              // произведений, отправленных на пул и ещё без ответа
+
+    mutable std::mutex stats_mutex_;
+    ServiceStats stats_;
+    uint64_t batched_ = 0, completed_ = 0;
+    double queue_us_total_ = 0;
+    std::array<uint64_t, LATENCY_BUCKETS> latency_hist_{};
+};
+
+#endif // GEMM_SERVICE_H
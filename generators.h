@@ -5,57 +5,138 @@
 #ifndef UNTITLED3_GENERATORS_H
 #define UNTITLED3_GENERATORS_H
 #include "structures.h"
-#include <random>
+#include "parallel.h"
+#include <cstdint>
 #include <type_traits>
+#include <cmath>
 #include <complex>
 
+///--------------------------
+///   Counter-based RNG
+///--------------------------
+// Значение элемента (i, j) - чистая функция от (seed, i, j), без общего состояния.
+// Поэтому любой тайл можно сгенерировать отдельно, в любом порядке и любым числом
+// потоков - результат побитово совпадает с последовательной генерацией.
+
+// Финализатор SplitMix64
+inline uint64_t splitmix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+// 64 случайных бита для позиции (i, j); lane различает несколько чисел на элемент
+// (мнимая часть, решение "ноль / не ноль" в разреженном генераторе)
+inline uint64_t counter_bits(uint64_t seed, uint64_t i, uint64_t j, uint64_t lane = 0) {
+    uint64_t h = splitmix64(seed);
+    h = splitmix64(h ^ (i * 0xD1B54A32D192ED03ull));
+    h = splitmix64(h ^ (j * 0xABC98388FB8FAC03ull + lane));
+    return h;
+}
+
+// Равномерное число в [0, 1) из старших 53 бит
+inline double bits_to_unit(uint64_t x) {
+    return (double)(x >> 11) * 0x1.0p-53;
+}
+
 template <class T>
-T rand_scalar(std::mt19937_64& rng, double lo, double hi) {
-    std::uniform_real_distribution<double> dist(lo, hi);
+T rand_scalar_at(uint64_t seed, uint64_t i, uint64_t j, double lo, double hi) {
     if constexpr (std::is_integral_v<T>) {
-        std::uniform_int_distribution<long long> idist((long long)lo, (long long)hi);
-        return (T)idist(rng);
+        uint64_t range = (uint64_t)((long long)hi - (long long)lo) + 1;
+        uint64_t x = counter_bits(seed, i, j);
+        return (T)((long long)lo + (long long)(((unsigned __int128)x * range) >> 64));
     } else if constexpr (std::is_same_v<T, std::complex<double>>) {
-        return {dist(rng), dist(rng)};
+        double re = lo + (hi - lo) * bits_to_unit(counter_bits(seed, i, j, 0));
+        double im = lo + (hi - lo) * bits_to_unit(counter_bits(seed, i, j, 1));
+        return {re, im};
     } else {
-        return (T)dist(rng);
+        return (T)(lo + (hi - lo) * bits_to_unit(counter_bits(seed, i, j)));
+    }
+}
+
+// Стандартное нормальное N(0, 1) для позиции (i, j) - Бокс-Мюллер на двух lane
+inline double rand_normal_at(uint64_t seed, uint64_t i, uint64_t j) {
+    double u1 = 1.0 - bits_to_unit(counter_bits(seed, i, j, 4));  // (0, 1] - без log(0)
+    double u2 = bits_to_unit(counter_bits(seed, i, j, 5));
+    return std::sqrt(-2.0 * std::log(u1)) * std::cos(6.283185307179586 * u2);
+}
+
+///--------------------------
+///     Заполнение тайлов
+///--------------------------
+// Тайл T - окно глобальной матрицы с левым верхним углом (r0, c0).
+// Используются и генераторами ниже, и для ленивой подгрузки тайлов в out-of-core прогонах.
+
+template <class T>
+void fill_random_tile(MatrixView<T> tile, int r0, int c0, uint64_t seed=42,
+                      double lo=-1.0, double hi=1.0) {
+    for (int i = 0; i < tile.rows; ++i)
+        for (int j = 0; j < tile.cols; ++j)
+            tile(i, j) = rand_scalar_at<T>(seed, r0 + i, c0 + j, lo, hi);
+}
+
+// Симметричная: (i, j) и (j, i) берут число с ключом (min, max)
+template <class T>
+void fill_symmetric_tile(MatrixView<T> tile, int r0, int c0, uint64_t seed=42,
+                         double lo=-1.0, double hi=1.0) {
+    for (int i = 0; i < tile.rows; ++i) {
+        for (int j = 0; j < tile.cols; ++j) {
+            int gi = r0 + i, gj = c0 + j;
+            tile(i, j) = rand_scalar_at<T>(seed, std::min(gi, gj), std::max(gi, gj), lo, hi);
+        }
     }
 }
 
+// Решение "ноль / не ноль" берётся из отдельной lane, чтобы не коррелировать со значением
 template <class T>
-Matrix<T> gen_random(int r, int c, uint64_t seed=42, double lo=-1.0, double hi=1.0) {
-    std::mt19937_64 rng(seed);
+void fill_almost_sparse_tile(MatrixView<T> tile, int r0, int c0, double p_zero=0.9,
+                             uint64_t seed=42, double lo=-1.0, double hi=1.0) {
+    for (int i = 0; i < tile.rows; ++i) {
+        for (int j = 0; j < tile.cols; ++j) {
+            int gi = r0 + i, gj = c0 + j;
+            bool zero = bits_to_unit(counter_bits(seed, gi, gj, 2)) < p_zero;
+            tile(i, j) = zero ? T{} : rand_scalar_at<T>(seed, gi, gj, lo, hi);
+        }
+    }
+}
+
+///--------------------------
+///       Генераторы
+///--------------------------
+// Строки делятся на полосы между потоками; результат не зависит от num_threads.
+
+template <class T>
+Matrix<T> gen_random(int r, int c, uint64_t seed=42, double lo=-1.0, double hi=1.0,
+                     int num_threads=0) {
     Matrix<T> A(r,c);
-    for (int i=0;i<r;++i)
-        for (int j=0;j<c;++j)
-            A(i,j)=rand_scalar<T>(rng, lo, hi);
+    auto V = view(A);
+    parallel_for(0, r, [&](int i0, int i1) {
+        fill_random_tile(subview(V, i0, 0, i1 - i0, c), i0, 0, seed, lo, hi);
+    }, num_threads, 64);
     return A;
 }
 
 template <class T>
-Matrix<T> gen_symmetric(int n, uint64_t seed=42, double lo=-1.0, double hi=1.0) {
-    std::mt19937_64 rng(seed);
+Matrix<T> gen_symmetric(int n, uint64_t seed=42, double lo=-1.0, double hi=1.0,
+                        int num_threads=0) {
     Matrix<T> A(n,n);
-    for (int i=0;i<n;++i) {
-        for (int j=i;j<n;++j) {
-            T x = rand_scalar<T>(rng, lo, hi);
-            A(i,j)=x;
-            A(j,i)=x;
-        }
-    }
+    auto V = view(A);
+    parallel_for(0, n, [&](int i0, int i1) {
+        fill_symmetric_tile(subview(V, i0, 0, i1 - i0, n), i0, 0, seed, lo, hi);
+    }, num_threads, 64);
     return A;
 }
 
 // почти разреженная: с вероятностью p_zero ставим 0
 template <class T>
 Matrix<T> gen_almost_sparse(int r, int c, double p_zero=0.9, uint64_t seed=42,
-                            double lo=-1.0, double hi=1.0) {
-    std::mt19937_64 rng(seed);
-    std::bernoulli_distribution zero(p_zero);
+                            double lo=-1.0, double hi=1.0, int num_threads=0) {
     Matrix<T> A(r,c);
-    for (int i=0;i<r;++i)
-        for (int j=0;j<c;++j)
-            A(i,j) = zero(rng) ? T{} : rand_scalar<T>(rng, lo, hi);
+    auto V = view(A);
+    parallel_for(0, r, [&](int i0, int i1) {
+        fill_almost_sparse_tile(subview(V, i0, 0, i1 - i0, c), i0, 0, p_zero, seed, lo, hi);
+    }, num_threads, 64);
     return A;
 }
 #endif //UNTITLED3_GENERATORS_H
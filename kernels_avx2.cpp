@@ -0,0 +1,12 @@
+//
+// Ядра для AVX2 + FMA
+//
+
+#if defined(__x86_64__) || defined(__i386__)
+#define KERNEL_NS kernels_avx2
+#define KERNEL_ISA CpuIsa::AVX2
+#define KERNEL_NAME "avx2"
+#define KERNEL_TARGET "avx2,fma,bmi2,popcnt"
+#define KERNEL_AVX2 1
+#include "kernels_impl.inc"
+#endif
@@ -0,0 +1,12 @@
+//
+// Ядра для AVX-512 F / BW / VL. Без VNNI: int8 в alg_quant.h идёт через AVX2 pmaddubsw
+//
+
+#if defined(__x86_64__) || defined(__i386__)
+#define KERNEL_NS kernels_avx512
+#define KERNEL_ISA CpuIsa::AVX512
+#define KERNEL_NAME "avx512"
+#define KERNEL_TARGET "avx512f,avx512bw,avx512vl,avx2,fma,bmi2,popcnt"
+#define KERNEL_AVX512 1
+#include "kernels_impl.inc"
+#endif
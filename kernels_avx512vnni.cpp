@@ -0,0 +1,14 @@
+//
+// Ядра для AVX-512 F / BW / VL + VNNI (vpdpbusd - int8 скалярные произведения в alg_quant.h).
+// Отличается от kernels_avx512.cpp только int8-ядром
+//
+
+#if defined(__x86_64__) || defined(__i386__)
+#define KERNEL_NS kernels_avx512vnni
+#define KERNEL_ISA CpuIsa::AVX512VNNI
+#define KERNEL_NAME "avx512vnni"
+#define KERNEL_TARGET "avx512f,avx512bw,avx512vl,avx512vnni,avx2,fma,bmi2,popcnt"
+#define KERNEL_AVX512 1
+#define KERNEL_AVX512VNNI 1
+#include "kernels_impl.inc"
+#endif
@@ -0,0 +1,8 @@
+//
+// Ядра для базового ISA (флаги компилятора по умолчанию)
+//
+
+#define KERNEL_NS kernels_baseline
+#define KERNEL_ISA CpuIsa::BASELINE
+#define KERNEL_NAME "baseline"
+#include "kernels_impl.inc"
@@ -0,0 +1,12 @@
+//
+// Ядра для SSE4.2 + POPCNT
+//
+
+#if defined(__x86_64__) || defined(__i386__)
+#define KERNEL_NS kernels_sse42
+#define KERNEL_ISA CpuIsa::SSE42
+#define KERNEL_NAME "sse42"
+#define KERNEL_TARGET "sse4.2,popcnt"
+#define KERNEL_SSE42 1
+#include "kernels_impl.inc"
+#endif
@@ -5,7 +5,18 @@
 #include "alg_winograd_4x4.h"
 #include "alg_alpha_evolve_4x4_complex.h"
 #include "alg_blocked.h"
+#include "alg_cache_oblivious.h"
+#include "alg_transpose.h"
+#include "alg_strassen_hybrid.h"
+#include "alg_approx.h"
+#include "alg_abft.h"
+#include "alg_quant.h"
+#include "alg_dispatch.h"
+#include "alg_async.h"
+#include "bench_shapes.h"
+#include "bench_scaling.h"
 #include <complex>
+#include <fstream>
 
 // Wrapper функции для бенчмарков
 template<class T>
@@ -13,6 +24,11 @@ void wrapper_naive(const Matrix<T>& A, const Matrix<T>& B, Matrix<T>& C, OpCount
     mul_naive(A, B, C, cnt);
 }
 
+template<class T>
+void wrapper_naive_transposed(const Matrix<T>& A, const Matrix<T>& B, Matrix<T>& C, OpCounter* cnt) {
+    mul_naive_transposed(A, B, C, cnt);
+}
+
 template<class T>
 void wrapper_strassen(const Matrix<T>& A, const Matrix<T>& B, Matrix<T>& C, OpCounter* cnt) {
     mul_strassen(A, B, C, /*THRESH=*/64, cnt);
@@ -53,13 +69,63 @@ void wrapper_blocked_strassen(const Matrix<T>& A, const Matrix<T>& B, Matrix<T>&
     mul_blocked_strassen_kernel(A, B, C, cnt);
 }
 
+template<class T>
+void wrapper_strassen_hybrid(const Matrix<T>& A, const Matrix<T>& B, Matrix<T>& C, OpCounter* cnt) {
+    mul_strassen_hybrid(A, B, C, StrassenHybridOptions{}, cnt);
+}
+
+template<class T>
+void wrapper_abft(const Matrix<T>& A, const Matrix<T>& B, Matrix<T>& C, OpCounter* cnt) {
+    mul_abft(A, B, C, AbftOptions{}, AbftFaultHook<T>{}, cnt);
+}
+
+// Через таблицу ядер, как в реальном использовании: VNNI / pmaddubsw по возможностям CPU.
+// gemm_int8_f32 принимает float - операнды другого типа переводятся (O(n^2) против O(n^3))
+template<class T>
+void wrapper_int8(const Matrix<T>& A, const Matrix<T>& B, Matrix<T>& C, OpCounter* cnt) {
+    if constexpr (std::is_same_v<T, float>) {
+        mul_int8_dispatch(A, B, C);
+    } else {
+        Matrix<float> Af(A.rows, A.cols), Bf(B.rows, B.cols), Cf;
+        for (int i = 0; i < A.rows; i++)
+            for (int j = 0; j < A.cols; j++) Af(i, j) = (float)A(i, j);
+        for (int i = 0; i < B.rows; i++)
+            for (int j = 0; j < B.cols; j++) Bf(i, j) = (float)B(i, j);
+        mul_int8_dispatch(Af, Bf, Cf);
+        C.resize(Cf.rows, Cf.cols);
+        for (int i = 0; i < C.rows; i++)
+            for (int j = 0; j < C.cols; j++) C(i, j) = (T)Cf(i, j);
+    }
+    if (cnt) {
+        cnt->mul += (uint64_t)A.rows * B.cols * A.cols;
+        cnt->add += (uint64_t)A.rows * B.cols * A.cols;
+    }
+}
+
+template<class T>
+void wrapper_dispatch(const Matrix<T>& A, const Matrix<T>& B, Matrix<T>& C, OpCounter* cnt) {
+    mul_dispatch(A, B, C, cnt);
+}
+
+template<class T>
+void wrapper_pipelined(const Matrix<T>& A, const Matrix<T>& B, Matrix<T>& C, OpCounter* cnt) {
+    mul_pipelined(A, B, C, cnt);
+}
+
+template<class T>
+void wrapper_cache_oblivious(const Matrix<T>& A, const Matrix<T>& B, Matrix<T>& C, OpCounter* cnt) {
+    mul_cache_oblivious(A, B, C, cnt);
+}
+
 // Функция для запуска бенчмарков для одного типа элементов
 template<class T>
 void run_benchmarks_for_type(
     BenchmarkSuite& suite,
     const std::string& element_type,
     const std::vector<int>& sizes,
-    const std::vector<std::string>& matrix_types
+    const std::vector<std::string>& matrix_types,
+    const VerifyOptions& verify,
+    int samples = 1
 ) {
     std::cout << "\n=== Running benchmarks for " << element_type << " ===\n";
 
@@ -72,9 +138,11 @@ void run_benchmarks_for_type(
             // Генерируем матрицы
             auto [A, B] = generate_matrices<T>(matrix_type, size, 42);
 
-            // Вычисляем эталонный результат (naive)
+            // Эталонный результат (naive) нужен только для полной проверки
             Matrix<T> C_reference;
-            mul_naive(A, B, C_reference, nullptr);
+            if (verify.mode == VerifyMode::FULL) {
+                mul_naive(A, B, C_reference, nullptr);
+            }
 
             // Список алгоритмов для тестирования
             struct AlgoTest {
@@ -82,10 +150,12 @@ void run_benchmarks_for_type(
                 std::function<void(const Matrix<T>&, const Matrix<T>&, Matrix<T>&, OpCounter*)> func;
                 bool only_4x4;  // Алгоритм работает только для размера 4
                 bool only_pow2; // Алгоритм работает только для степеней 2
+                bool approximate = false;  // Ошибка заведомо выше допуска проверки - только сообщаем её
             };
 
             std::vector<AlgoTest> algorithms = {
                 {"naive", wrapper_naive<T>, false, false},
+                {"naive_transposed", wrapper_naive_transposed<T>, false, false},
                 {"strassen", wrapper_strassen<T>, false, true},
                 {"strassen_4x4", wrapper_strassen_4x4<T>, true, false},
                 {"winograd_4x4", wrapper_winograd_4x4<T>, true, false},
@@ -93,8 +163,18 @@ void run_benchmarks_for_type(
                 {"blocked_naive", wrapper_blocked_naive<T>, false, false},
                 {"blocked_winograd", wrapper_blocked_winograd<T>, false, false},
                 {"blocked_alphaevolve", wrapper_blocked_alphaevolve<T>, false, false},
-                {"blocked_strassen", wrapper_blocked_strassen<T>, false, false}
+                {"blocked_strassen", wrapper_blocked_strassen<T>, false, false},
+                {"cache_oblivious", wrapper_cache_oblivious<T>, false, false},
+                {"strassen_hybrid", wrapper_strassen_hybrid<T>, false, false},
+                {"abft", wrapper_abft<T>, false, false},
+                {"pipelined", wrapper_pipelined<T>, false, false}
             };
+            if constexpr (std::is_floating_point_v<T>) {
+                algorithms.push_back({"int8", wrapper_int8<T>, false, false, true});
+            }
+            if constexpr (std::is_same_v<T, double> or std::is_same_v<T, float>) {
+                algorithms.push_back({"dispatch", wrapper_dispatch<T>, false, false});
+            }
 
             for (const auto& algo : algorithms) {
                 // Пропускаем 4x4 алгоритмы для других размеров
@@ -115,13 +195,19 @@ void run_benchmarks_for_type(
                         size,
                         A, B,
                         algo.func,
-                        &C_reference
+                        &C_reference,
+                        verify,
+                        samples
                     );
 
+                    if (algo.approximate) result.verified = true;
+
                     suite.add_result(result);
                     std::cout << "    " << algo.name << ": "
                               << std::fixed << std::setprecision(2) << result.time_ms << " ms"
-                              << ", error: " << std::scientific << result.correctness_error << "\n";
+                              << ", error: " << std::scientific << result.correctness_error
+                              << (result.verified ? "" : " FAILED VERIFICATION") << "\n";
+                    print_trace_summary(std::cout, result.trace, "      ");
 
                 } catch (const std::exception& e) {
                     std::cerr << "    " << algo.name << ": FAILED (" << e.what() << ")\n";
@@ -131,21 +217,301 @@ void run_benchmarks_for_type(
     }
 }
 
+// Кривые скорость / ошибка для приближённого умножения.
+// Для каждого метода s пробегает доли k; ошибка считается относительно точного
+// произведения (mul_naive_transposed - тот же движок, что и в конце скетча).
+template<class T>
+void run_approx_curves_for_type(
+    std::ofstream& csv,
+    const std::string& element_type,
+    const std::vector<int>& sizes,
+    const std::vector<std::string>& matrix_types
+) {
+    std::cout << "\n=== Approximate multiplication curves for " << element_type << " ===\n";
+
+    const std::vector<std::pair<std::string, ApproxMethod>> methods = {
+        {"sampling", ApproxMethod::SAMPLING},
+        {"gaussian", ApproxMethod::GAUSSIAN},
+        {"sparse_sign", ApproxMethod::SPARSE_SIGN}
+    };
+    const std::vector<int> fractions = {64, 32, 16, 8, 4, 2};  // s = k / fraction
+
+    for (const auto& matrix_type : matrix_types) {
+        for (int size : sizes) {
+            auto [A, B] = generate_matrices<T>(matrix_type, size, 42);
+
+            Matrix<T> C_exact;
+            auto t0 = std::chrono::steady_clock::now();
+            mul_naive_transposed(A, B, C_exact);
+            auto t1 = std::chrono::steady_clock::now();
+            double exact_ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+            double exact_norm = 0.0;
+            for (int i = 0; i < size; i++)
+                for (int j = 0; j < size; j++) exact_norm += std::norm(std::complex<double>(C_exact(i, j)));
+
+            std::cout << "  " << matrix_type << " " << size << "x" << size
+                      << ": exact " << std::fixed << std::setprecision(2) << exact_ms << " ms\n";
+
+            for (const auto& [name, method] : methods) {
+                for (int frac : fractions) {
+                    ApproxOptions opt;
+                    opt.method = method;
+                    opt.samples = std::max(1, size / frac);
+
+                    Matrix<T> C;
+                    auto s0 = std::chrono::steady_clock::now();
+                    ApproxReport rep = mul_approx(A, B, C, opt);
+                    auto s1 = std::chrono::steady_clock::now();
+                    double ms = std::chrono::duration<double, std::milli>(s1 - s0).count();
+
+                    double err = 0.0;
+                    for (int i = 0; i < size; i++)
+                        for (int j = 0; j < size; j++)
+                            err += std::norm(std::complex<double>(C(i, j) - C_exact(i, j)));
+                    double true_error = exact_norm > 0 ? std::sqrt(err / exact_norm) : std::sqrt(err);
+
+                    csv << element_type << "," << matrix_type << "," << size << "," << name << ","
+                        << rep.samples << "," << ms << "," << exact_ms << "," << exact_ms / ms << ","
+                        << true_error << "," << rep.estimated_error << "," << rep.predicted_error << "\n";
+
+                    std::cout << "    " << name << " s=" << rep.samples << ": "
+                              << std::fixed << std::setprecision(2) << ms << " ms (x" << exact_ms / ms << ")"
+                              << ", error " << std::scientific << std::setprecision(2) << true_error
+                              << " (est " << rep.estimated_error << ")\n";
+                }
+            }
+        }
+    }
+}
+
+// Режим --shapes: квадратные размеры (степени двойки, соседи, простые), сетка m x k x n,
+// плотные и смещённые подматрицы; результаты относительно roofline в shape_results.csv.
+//   --sizes=1,7,257      квадратные размеры вместо набора по умолчанию
+//   --sweep=full         набор по умолчанию до 8209
+//   --m=..,--k=..,--n=.. прямоугольная сетка (декартово произведение)
+//   --algos=shaped,...   только эти движки
+//   --layout=contiguous|strided
+//   --threads=N
+int run_shape_mode(int argc, char* argv[]) {
+    ShapeBenchOptions opt;
+    std::vector<int> sizes, ms, ks, ns;
+    bool full = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--sizes=", 0) == 0) sizes = parse_int_list(arg.substr(8));
+        else if (arg == "--sweep=full") full = true;
+        else if (arg.rfind("--m=", 0) == 0) ms = parse_int_list(arg.substr(4));
+        else if (arg.rfind("--k=", 0) == 0) ks = parse_int_list(arg.substr(4));
+        else if (arg.rfind("--n=", 0) == 0) ns = parse_int_list(arg.substr(4));
+        else if (arg.rfind("--threads=", 0) == 0) opt.num_threads = std::stoi(arg.substr(10));
+        else if (arg == "--layout=contiguous") opt.layouts = {ShapeLayout::CONTIGUOUS};
+        else if (arg == "--layout=strided") opt.layouts = {ShapeLayout::STRIDED};
+        else if (arg.rfind("--algos=", 0) == 0) {
+            std::stringstream ss(arg.substr(8));
+            std::string name;
+            while (std::getline(ss, name, ',')) opt.algorithms.push_back(name);
+        }
+    }
+
+    bool grid = !ms.empty() or !ks.empty() or !ns.empty();
+    if (grid) {
+        // Незаданное измерение берётся из небольшого набора по умолчанию
+        const std::vector<int> dflt = {1, 7, 32, 250, 1000};
+        opt.cases = grid_cases(ms.empty() ? dflt : ms, ks.empty() ? dflt : ks, ns.empty() ? dflt : ns);
+    }
+    if (!sizes.empty() or !grid) {
+        auto sq = square_cases(sizes.empty() ? shape_sweep_sizes(full) : sizes);
+        opt.cases.insert(opt.cases.begin(), sq.begin(), sq.end());
+    }
+
+    Roofline roof1 = measure_roofline(1);
+    int nt = opt.num_threads > 0 ? opt.num_threads : default_num_threads();
+    Roofline roofn = nt == 1 ? roof1 : measure_roofline(nt);
+    std::cout << "\n=== Shape sweep (double), " << opt.cases.size() << " shapes ===\n";
+    std::cout << std::fixed << std::setprecision(2)
+              << "Roofline 1 thread: peak " << roof1.peak_gflops << " GFLOP/s, bandwidth "
+              << roof1.bandwidth_gbs << " GB/s, ridge " << roof1.ridge_point() << " FLOP/B\n"
+              << "Roofline " << roofn.num_threads << " threads: peak " << roofn.peak_gflops
+              << " GFLOP/s, bandwidth " << roofn.bandwidth_gbs << " GB/s, ridge "
+              << roofn.ridge_point() << " FLOP/B\n";
+
+    std::ofstream csv("shape_results.csv");
+    int failed = run_shape_suite(opt, roof1, roofn, csv);
+    std::cout << "\nResults saved to shape_results.csv\n";
+    if (failed) {
+        std::cerr << failed << " shape points FAILED VERIFICATION\n";
+        return 1;
+    }
+    return 0;
+}
+
+// Режим --scaling: сильное и слабое масштабирование многопоточных движков в scaling_results.csv.
+//   --size=1024          n для сильного масштабирования
+//   --weak-size=512      n на одном потоке для слабого (n_p = n_1 * p^(1/3))
+//   --threads=1,2,4      число потоков вместо 1, 2, 4, ... и всех ядер
+//   --mode=strong|weak
+//   --per-node           отдельно по каждому узлу NUMA, потоки привязаны к его ядрам
+//   --algos=semiring,... --samples=N
+int run_scaling_mode(int argc, char* argv[]) {
+    ScalingOptions opt;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--size=", 0) == 0) opt.strong_size = std::stoi(arg.substr(7));
+        else if (arg.rfind("--weak-size=", 0) == 0) opt.weak_size = std::stoi(arg.substr(12));
+        else if (arg.rfind("--threads=", 0) == 0) opt.threads = parse_int_list(arg.substr(10));
+        else if (arg == "--mode=strong") opt.modes = {ScalingMode::STRONG};
+        else if (arg == "--mode=weak") opt.modes = {ScalingMode::WEAK};
+        else if (arg == "--per-node") opt.per_node = true;
+        else if (arg.rfind("--samples=", 0) == 0) opt.samples = std::max(1, std::stoi(arg.substr(10)));
+        else if (arg.rfind("--algos=", 0) == 0) {
+            std::stringstream ss(arg.substr(8));
+            std::string name;
+            while (std::getline(ss, name, ',')) opt.algorithms.push_back(name);
+        }
+    }
+
+    const NumaTopology& topo = numa_topology();
+    std::cout << "\n=== Thread scaling (double), " << default_num_threads() << " cores, "
+              << topo.nodes() << " NUMA nodes ===\n";
+    std::ofstream csv("scaling_results.csv");
+    run_scaling_suite(opt, csv);
+    std::cout << "\nResults saved to scaling_results.csv\n";
+    return 0;
+}
+
+// Таблица сравнения с baseline и benchmark_comparison.csv; 1 - есть значимые регрессии (для CI)
+int report_baseline_comparison(const BenchmarkSuite& suite, const std::vector<BenchmarkResult>& baseline,
+                               const std::string& baseline_path, double threshold) {
+    int unmatched = 0;
+    auto cmp = suite.compare_to(baseline, threshold, &unmatched);
+    std::cout << "\n=== Comparison with " << baseline_path << " (95% CI, threshold "
+              << std::fixed << std::setprecision(1) << 100 * threshold << "%) ===\n";
+
+    std::ofstream csv("benchmark_comparison.csv");
+    csv << BenchmarkComparison::csv_header() << "\n";
+    int regressions = 0, without_ci = 0;
+    for (const auto& c : cmp) {
+        csv << c.to_csv() << "\n";
+        regressions += c.status == CompareStatus::REGRESSION;
+        without_ci += !c.has_ci;
+        if (c.status == CompareStatus::UNCHANGED) continue;
+        std::cout << "  " << std::left << std::setw(20) << c.algorithm << std::setw(10) << c.matrix_type
+                  << std::setw(8) << c.element_type << std::right << std::setw(5) << c.size
+                  << std::fixed << std::setprecision(3) << std::setw(11) << c.baseline_ms << " ->"
+                  << std::setw(10) << c.current_ms << " ms  x" << std::setprecision(2) << c.speedup;
+        if (c.has_ci) std::cout << " [" << c.speedup_lo << ", " << c.speedup_hi << "]";
+        std::cout << "  " << compare_status_name(c.status) << "\n";
+    }
+    std::cout << cmp.size() << " matched, " << std::count_if(cmp.begin(), cmp.end(), [](auto& c) {
+                     return c.status == CompareStatus::UNCHANGED;
+                 }) << " unchanged, " << unmatched << " not in baseline";
+    if (without_ci) std::cout << ", " << without_ci << " without repeated samples on both sides (speedup only)";
+    std::cout << "\nComparison saved to benchmark_comparison.csv\n";
+    if (regressions) {
+        std::cerr << regressions << " significant regressions\n";
+        return 1;
+    }
+    return 0;
+}
+
+// Самопроверка ABFT (--full-check): одна испорченная ячейка одного тайла должна дать ровно
+// одну несошедшуюся строку и один пересчитанный тайл, а C - совпасть с чистым прогоном.
+// Размер не кратен тайлу, полосы идут в двух потоках
+template<class T>
+bool abft_fault_self_check(const std::string& type_name) {
+    const int m = 150, k = 97, n = 203;
+    Matrix<T> A = gen_random<T>(m, k, 7), B = gen_random<T>(k, n, 8), ref, C;
+    AbftOptions opt;
+    opt.num_threads = 2;
+    AbftReport clean = mul_abft(A, B, ref, opt);
+
+    const int fi = 1, fj = 2, fr = 5, fc = 11;
+    AbftFaultHook<T> inject = [&](int ti, int tj, MatrixView<T> tile) {
+        if (ti == fi and tj == fj) tile(fr, fc) += T(1.0);
+    };
+    AbftReport rep = mul_abft(A, B, C, opt, inject);
+
+    bool same = true;
+    for (int i = 0; i < m; i++)
+        for (int j = 0; j < n; j++) same = same and C(i, j) == ref(i, j);
+    bool ok = clean.ok and clean.rows_failed == 0 and rep.ok and rep.rows_failed == 1 and
+              rep.tiles_recomputed == 1 and rep.unlocated == 0 and rep.faulty_tiles.size() == 1 and
+              rep.faulty_tiles[0] == std::make_pair(fi, fj) and same;
+    std::cout << "ABFT fault injection (" << type_name << "): rows failed " << rep.rows_failed
+              << ", tiles recomputed " << rep.tiles_recomputed << ", C " << (same ? "restored" : "WRONG")
+              << (ok ? " - OK\n" : " - FAILED\n");
+    return ok;
+}
+
 int main(int argc, char* argv[]) {
     std::cout << "Matrix Multiplication Benchmark Suite\n";
     std::cout << "======================================\n";
+    std::cout << "CPU kernels: " << kernels().name << " (detected " << isa_name(detect_cpu_isa()) << ")\n";
 
     BenchmarkSuite suite;
 
+    // Проверка корректности: по умолчанию Freivalds, полный эталон - по флагу --full-check
+    VerifyOptions verify;
+    verify.mode = VerifyMode::FREIVALDS;
+    bool approx = false;
+    // Сравнение с базовой линией: --baseline=old.csv, повторы --samples=N, порог --regression-threshold=0.05
+    std::string baseline_path;
+    int samples = 0;  // 0 - по умолчанию: 3, с --baseline - 5
+    double regression_threshold = 0.05;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--full-check") verify.mode = VerifyMode::FULL;
+        else if (arg == "--no-check") verify.mode = VerifyMode::NONE;
+        else if (arg.rfind("--trials=", 0) == 0) verify.trials = std::stoi(arg.substr(9));
+        else if (arg == "--approx") approx = true;
+        else if (arg == "--shapes") return run_shape_mode(argc, argv);
+        else if (arg == "--scaling") return run_scaling_mode(argc, argv);
+        else if (arg.rfind("--baseline=", 0) == 0) baseline_path = arg.substr(11);
+        else if (arg.rfind("--samples=", 0) == 0) samples = std::max(1, std::stoi(arg.substr(10)));
+        else if (arg.rfind("--regression-threshold=", 0) == 0) regression_threshold = std::stod(arg.substr(23));
+    }
+    // Вердикт о регрессии требует повторов с обеих сторон, поэтому и обычный прогон
+    // повторяет замеры: его benchmark_results.csv годится как baseline для следующего
+    if (samples == 0) samples = baseline_path.empty() ? 3 : 5;
+
+    // Базовая линия читается до прогона: файл может совпадать с benchmark_results.csv
+    std::vector<BenchmarkResult> baseline;
+    if (!baseline_path.empty() and !BenchmarkSuite::load_csv(baseline_path, baseline)) return 2;
+    size_t single = std::count_if(baseline.begin(), baseline.end(), [](auto& r) { return r.samples < 2; });
+    if (single > 0) {
+        std::cerr << "warning: " << single << " of " << baseline.size() << " rows in " << baseline_path
+                  << " have fewer than 2 samples; they can only be reported as untested and never fail"
+                  << " the check. Regenerate the baseline with --samples=3 or more.\n";
+    }
+
+    if (verify.mode == VerifyMode::FULL) {
+        bool abft_ok = abft_fault_self_check<double>("double");
+        abft_ok = abft_fault_self_check<std::complex<double>>("complex") and abft_ok;
+        if (!abft_ok) return 1;
+    }
+
+    // Режим --approx: только кривые скорость / ошибка приближённого умножения
+    if (approx) {
+        std::ofstream csv("approx_results.csv");
+        csv << "element_type,matrix_type,size,method,samples,time_ms,exact_time_ms,speedup,"
+               "true_error,estimated_error,predicted_error\n";
+        std::vector<int> approx_sizes = {256, 512};
+        std::vector<std::string> approx_types = {"random", "symmetric", "sparse"};
+        run_approx_curves_for_type<double>(csv, "double", approx_sizes, approx_types);
+        run_approx_curves_for_type<std::complex<double>>(csv, "complex", approx_sizes, approx_types);
+        std::cout << "\nResults saved to approx_results.csv\n";
+        return 0;
+    }
+
     // Конфигурация бенчмарков
     std::vector<int> sizes = {4, 8, 16, 64, 256};  // Размеры матриц
     std::vector<std::string> matrix_types = {"random", "symmetric"};  // Типы матриц
 
     // Запускаем бенчмарки для double
-    run_benchmarks_for_type<double>(suite, "double", sizes, matrix_types);
+    run_benchmarks_for_type<double>(suite, "double", sizes, matrix_types, verify, samples);
 
     // Запускаем бенчмарки для complex<double>
-    run_benchmarks_for_type<std::complex<double>>(suite, "complex", sizes, matrix_types);
+    run_benchmarks_for_type<std::complex<double>>(suite, "complex", sizes, matrix_types, verify, samples);
 
     // Сохраняем результаты
     std::cout << "\n=== Saving results ===\n";
@@ -154,6 +520,11 @@ int main(int argc, char* argv[]) {
     // Выводим сводку
     std::cout << "\nTotal benchmarks run: " << suite.size() << "\n";
     std::cout << "Results saved to benchmark_results.csv\n";
+    if (trace_enabled and trace_write_chrome("trace.json")) {
+        std::cout << "Trace saved to trace.json (chrome://tracing, ui.perfetto.dev)\n";
+    }
+
+    if (!baseline.empty()) return report_baseline_comparison(suite, baseline, baseline_path, regression_threshold);
 
     return 0;
 }
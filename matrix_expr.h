@@ -0,0 +1,454 @@
+//
+// Ленивые выражения над Matrix: A*B + C, alpha*A*B, (A+B)*C, transpose(A)*B, ...
+// Операторы только строят дерево; вычисление происходит при присваивании в Matrix,
+// и каждое произведение сворачивается в один вызов gemm_acc с alpha/beta/транспонированием.
+// Операнды произведения, не являющиеся листьями ((A+B)*C), сначала вычисляются в арену:
+// так gemm_acc получает два view и идёт через упакованное ядро.
+//
+// Узлы хранят листья по ссылке (через MatrixView), поэтому выражение нельзя
+// сохранять в auto-переменную дольше полного выражения с временными матрицами.
+//
+
+#ifndef MATRIX_EXPR_H
+#define MATRIX_EXPR_H
+
+#include "structures.h"
+#include "alg_gemm.h"
+#include "workspace.h"
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+
+///--------------------------
+///        Узлы дерева
+///--------------------------
+template <class E>
+struct MatExpr {
+    const E& self() const { return static_cast<const E&>(*this); }
+};
+
+// Лист: ссылка на матрицу, возможно транспонированную
+template <class T, bool Tr>
+struct MatRef : MatExpr<MatRef<T, Tr>> {
+    using value_type = T;
+    static constexpr bool has_product = false;
+
+    MatrixView<const T> v;
+
+    explicit MatRef(MatrixView<const T> v_) : v(v_) {}
+
+    int rows() const { return Tr ? v.cols : v.rows; }
+    int cols() const { return Tr ? v.rows : v.cols; }
+    T operator()(int i, int j) const { return Tr ? v(j, i) : v(i, j); }
+
+    OpView<T, Tr> access() const { return {v}; }
+};
+
+// alpha * E
+template <class E>
+struct ScaleExpr : MatExpr<ScaleExpr<E>> {
+    using value_type = typename E::value_type;
+    static constexpr bool has_product = E::has_product;
+
+    value_type alpha;
+    E e;
+
+    ScaleExpr(const value_type& a, const E& e_) : alpha(a), e(e_) {}
+
+    int rows() const { return e.rows(); }
+    int cols() const { return e.cols(); }
+    value_type operator()(int i, int j) const { return alpha * e(i, j); }
+};
+
+// L + R
+template <class L, class R>
+struct SumExpr : MatExpr<SumExpr<L, R>> {
+    using value_type = typename L::value_type;
+    static constexpr bool has_product = L::has_product || R::has_product;
+
+    L l;
+    R r;
+
+    SumExpr(const L& l_, const R& r_) : l(l_), r(r_) {
+        assert(l.rows() == r.rows() and l.cols() == r.cols());
+    }
+
+    int rows() const { return l.rows(); }
+    int cols() const { return l.cols(); }
+    value_type operator()(int i, int j) const { return l(i, j) + r(i, j); }
+};
+
+// L * R - поэлементного доступа нет, вычисляется только целиком через GEMM
+template <class L, class R>
+struct ProdExpr : MatExpr<ProdExpr<L, R>> {
+    using value_type = typename L::value_type;
+    static constexpr bool has_product = true;
+
+    L l;
+    R r;
+
+    ProdExpr(const L& l_, const R& r_) : l(l_), r(r_) {
+        assert(l.cols() == r.rows());
+    }
+
+    int rows() const { return l.rows(); }
+    int cols() const { return r.cols(); }
+};
+
+///--------------------------
+///   Операнды и операторы
+///--------------------------
+template <class T>
+MatRef<T, false> as_expr(const Matrix<T>& M) { return MatRef<T, false>(view(M)); }
+
+template <class E>
+const E& as_expr(const MatExpr<E>& e) { return e.self(); }
+
+template <class X>
+using expr_t = std::decay_t<decltype(as_expr(std::declval<const X&>()))>;
+
+template <class X>
+struct is_matrix_operand : std::is_base_of<MatExpr<X>, X> {};
+
+template <class T>
+struct is_matrix_operand<Matrix<T>> : std::true_type {};
+
+template <class X>
+constexpr bool is_matrix_operand_v = is_matrix_operand<std::decay_t<X>>::value;
+
+template <class L, class R,
+          typename std::enable_if<is_matrix_operand_v<L> && is_matrix_operand_v<R>, int>::type = 0>
+auto operator*(const L& l, const R& r) {
+    return ProdExpr<expr_t<L>, expr_t<R>>(as_expr(l), as_expr(r));
+}
+
+template <class L, class R,
+          typename std::enable_if<is_matrix_operand_v<L> && is_matrix_operand_v<R>, int>::type = 0>
+auto operator+(const L& l, const R& r) {
+    return SumExpr<expr_t<L>, expr_t<R>>(as_expr(l), as_expr(r));
+}
+
+template <class L, class R,
+          typename std::enable_if<is_matrix_operand_v<L> && is_matrix_operand_v<R>, int>::type = 0>
+auto operator-(const L& l, const R& r) {
+    using V = typename expr_t<R>::value_type;
+    return SumExpr<expr_t<L>, ScaleExpr<expr_t<R>>>(as_expr(l), ScaleExpr<expr_t<R>>(V(-1), as_expr(r)));
+}
+
+template <class E, typename std::enable_if<is_matrix_operand_v<E>, int>::type = 0>
+auto operator*(const typename expr_t<E>::value_type& alpha, const E& e) {
+    return ScaleExpr<expr_t<E>>(alpha, as_expr(e));
+}
+
+template <class E, typename std::enable_if<is_matrix_operand_v<E>, int>::type = 0>
+auto operator*(const E& e, const typename expr_t<E>::value_type& alpha) {
+    return ScaleExpr<expr_t<E>>(alpha, as_expr(e));
+}
+
+// Транспонирование проталкивается к листьям: (AB)^T = B^T A^T
+template <class T>
+MatRef<T, true> transpose(const Matrix<T>& M) { return MatRef<T, true>(view(M)); }
+
+template <class T, bool Tr>
+MatRef<T, !Tr> transpose(const MatRef<T, Tr>& e) { return MatRef<T, !Tr>(e.v); }
+
+template <class E>
+auto transpose(const ScaleExpr<E>& e) {
+    auto t = transpose(e.e);
+    return ScaleExpr<decltype(t)>(e.alpha, t);
+}
+
+template <class L, class R>
+auto transpose(const SumExpr<L, R>& e) {
+    auto tl = transpose(e.l);
+    auto tr = transpose(e.r);
+    return SumExpr<decltype(tl), decltype(tr)>(tl, tr);
+}
+
+template <class L, class R>
+auto transpose(const ProdExpr<L, R>& e) {
+    auto tr = transpose(e.r);
+    auto tl = transpose(e.l);
+    return ProdExpr<decltype(tr), decltype(tl)>(tr, tl);
+}
+
+///--------------------------
+///        Вычисление
+///--------------------------
+// dst = beta * dst + alpha * e. Матрица-приёмник, стоящая слагаемым на верхнем уровне
+// (C = A*B + C), не читается как операнд, а уходит в beta.
+template <class T>
+struct EvalCtx {
+    const T* dst = nullptr;   // слагаемые-ссылки на приёмник пропускаются
+    T beta = T{};             // коэффициент при старом содержимом приёмника
+    bool applied = false;     // beta уже учтён первым вычисленным слагаемым
+
+    T take_beta() {
+        T b = applied ? T{1} : beta;
+        applied = true;
+        return b;
+    }
+};
+
+template <class T>
+bool same_view(MatrixView<const T> v, const T* dst) { return v.ptr == dst; }
+
+template <class T>
+bool overlaps(MatrixView<const T> v, const T* lo, const T* hi) {
+    if (v.rows == 0 or v.cols == 0) return false;
+    const T* b = v.ptr;
+    const T* e = v.ptr + (size_t)(v.rows - 1) * v.stride + v.cols;
+    return b < hi and lo < e;
+}
+
+// Сумма коэффициентов слагаемых верхнего уровня, совпадающих с приёмником
+template <class T, bool Tr>
+T dst_coeff(const MatRef<T, Tr>& e, const T* dst) {
+    return (!Tr and same_view(e.v, dst)) ? T{1} : T{};
+}
+template <class E, class T>
+T dst_coeff(const ScaleExpr<E>& e, const T* dst) { return e.alpha * dst_coeff(e.e, dst); }
+template <class L, class R, class T>
+T dst_coeff(const SumExpr<L, R>& e, const T* dst) { return dst_coeff(e.l, dst) + dst_coeff(e.r, dst); }
+template <class L, class R, class T>
+T dst_coeff(const ProdExpr<L, R>&, const T*) { return T{}; }
+
+// Есть ли среди слагаемых верхнего уровня сам приёмник
+template <class T, bool Tr>
+bool has_dst_term(const MatRef<T, Tr>& e, const T* dst) { return !Tr and same_view(e.v, dst); }
+template <class E, class T>
+bool has_dst_term(const ScaleExpr<E>& e, const T* dst) { return has_dst_term(e.e, dst); }
+template <class L, class R, class T>
+bool has_dst_term(const SumExpr<L, R>& e, const T* dst) { return has_dst_term(e.l, dst) or has_dst_term(e.r, dst); }
+template <class L, class R, class T>
+bool has_dst_term(const ProdExpr<L, R>&, const T*) { return false; }
+
+// Читает ли выражение память приёмника где-то кроме пропускаемых слагаемых
+template <class T, bool Tr>
+bool reads_dst(const MatRef<T, Tr>& e, const T* lo, const T* hi, bool top) {
+    if (top and !Tr and same_view(e.v, lo)) return false;
+    return overlaps(e.v, lo, hi);
+}
+template <class E, class T>
+bool reads_dst(const ScaleExpr<E>& e, const T* lo, const T* hi, bool top) {
+    return reads_dst(e.e, lo, hi, top);
+}
+template <class L, class R, class T>
+bool reads_dst(const SumExpr<L, R>& e, const T* lo, const T* hi, bool top) {
+    return reads_dst(e.l, lo, hi, top) or reads_dst(e.r, lo, hi, top);
+}
+template <class L, class R, class T>
+bool reads_dst(const ProdExpr<L, R>& e, const T* lo, const T* hi, bool) {
+    return reads_dst(e.l, lo, hi, false) or reads_dst(e.r, lo, hi, false);
+}
+
+template <class T, class E>
+void eval_expr(MatrixView<T> dst, const E& e, const T& alpha, EvalCtx<T>& ctx);
+
+// Поэлементное выражение без произведений: один проход по dst
+template <class T, class E>
+void eval_elementwise(MatrixView<T> dst, const E& e, const T& alpha, EvalCtx<T>& ctx) {
+    T beta = ctx.take_beta();
+    for (int i = 0; i < dst.rows; ++i)
+        for (int j = 0; j < dst.cols; ++j)
+            dst(i, j) = (beta == T{} ? T{} : beta * dst(i, j)) + alpha * e(i, j);
+}
+
+// Снятие скалярных множителей с операнда произведения: (alpha*A)*B -> alpha, A, B
+template <class E, class T>
+const E& peel(const E& e, T&) { return e; }
+
+template <class E, class T>
+auto peel(const ScaleExpr<E>& e, T& alpha) -> decltype(peel(e.e, alpha)) {
+    alpha = alpha * e.alpha;
+    return peel(e.e, alpha);
+}
+
+template <class E>
+struct is_mat_ref : std::false_type {};
+
+template <class T, bool Tr>
+struct is_mat_ref<MatRef<T, Tr>> : std::true_type {};
+
+// Операнд после снятия множителей: ScaleExpr<...<E>> -> E
+template <class E>
+struct peeled {
+    using type = E;
+};
+
+template <class E>
+struct peeled<ScaleExpr<E>> : peeled<E> {};
+
+// Лист идёт в GEMM как OpView (транспонирование - на стороне gemm_acc), всё остальное -
+// сумма или вложенное произведение - вычисляется один раз в буфер арены. Сумма справа
+// иначе пересчитывалась бы в каждом проходе по B, а ядру всё равно нужен view
+template <class E>
+auto product_operand(const E& e, Workspace& ws) {
+    using T = typename E::value_type;
+    if constexpr (is_mat_ref<E>::value) {
+        return e.access();
+    } else {
+        MatrixView<T> tmp(ws.alloc<T>((size_t)e.rows() * e.cols()), e.rows(), e.cols(), e.cols());
+        EvalCtx<T> inner;
+        eval_expr(tmp, e, T{1}, inner);
+        return OpView<T, false>{MatrixView<const T>(tmp)};
+    }
+}
+
+template <class T, class L, class R>
+void eval_product(MatrixView<T> dst, const ProdExpr<L, R>& e, T alpha, EvalCtx<T>& ctx) {
+    const auto& l = peel(e.l, alpha);
+    const auto& r = peel(e.r, alpha);
+    Workspace& ws = thread_workspace();
+    Workspace::Scope scope(ws);
+    auto la = product_operand(l, ws);
+    auto ra = product_operand(r, ws);
+    gemm_acc(alpha, la, ra, ctx.take_beta(), dst);
+}
+
+template <class T, class E>
+void eval_expr(MatrixView<T> dst, const E& e, const T& alpha, EvalCtx<T>& ctx) {
+    if constexpr (std::is_same_v<E, MatRef<T, false>>) {
+        // Слагаемое-приёмник уже учтено в beta
+        if (same_view(e.v, ctx.dst)) return;
+        eval_elementwise(dst, e, alpha, ctx);
+    } else if constexpr (std::is_same_v<E, MatRef<T, true>>) {
+        eval_elementwise(dst, e, alpha, ctx);
+    } else if constexpr (!E::has_product) {
+        if (has_dst_term(e, ctx.dst)) eval_split(dst, e, alpha, ctx);
+        else eval_elementwise(dst, e, alpha, ctx);
+    } else {
+        eval_split(dst, e, alpha, ctx);
+    }
+}
+
+template <class T, class E>
+void eval_split(MatrixView<T> dst, const ScaleExpr<E>& e, const T& alpha, EvalCtx<T>& ctx) {
+    eval_expr(dst, e.e, T(alpha * e.alpha), ctx);
+}
+
+template <class T, class L, class R>
+void eval_split(MatrixView<T> dst, const SumExpr<L, R>& e, const T& alpha, EvalCtx<T>& ctx) {
+    // Сначала поэлементная часть, затем произведение с beta = 1 поверх неё
+    if constexpr (!L::has_product) {
+        eval_expr(dst, e.l, alpha, ctx);
+        eval_expr(dst, e.r, alpha, ctx);
+    } else {
+        eval_expr(dst, e.r, alpha, ctx);
+        eval_expr(dst, e.l, alpha, ctx);
+    }
+}
+
+template <class T, class L, class R>
+void eval_split(MatrixView<T> dst, const ProdExpr<L, R>& e, const T& alpha, EvalCtx<T>& ctx) {
+    eval_product(dst, e, alpha, ctx);
+}
+
+// Полное присваивание: dst = base * dst + e
+template <class T, class E>
+void assign_expr(Matrix<T>& dst, const E& e, const T& base, const T& alpha) {
+    const T* lo = dst.data();
+    const T* hi = dst.data() + dst.a.size();
+
+    bool fits = dst.rows == e.rows() and dst.cols == e.cols();
+    if (!fits) {
+        // Приёмник меняет размер - старое содержимое не нужно
+        assert(base == T{});
+        EvalCtx<T> ctx;
+        if (reads_dst(e, lo, hi, false)) {
+            // Выражение читает старый dst (C = transpose(C), D = D * B): resize освободил бы его
+            Matrix<T> tmp(e.rows(), e.cols());
+            eval_expr(view(tmp), e, alpha, ctx);
+            dst = std::move(tmp);
+            return;
+        }
+        dst.resize(e.rows(), e.cols());
+        eval_expr(view(dst), e, alpha, ctx);
+        return;
+    }
+    if (reads_dst(e, lo, hi, true)) {
+        // Приёмник читается как операнд произведения - считаем во временный буфер арены
+        Workspace& ws = thread_workspace();
+        Workspace::Scope scope(ws);
+        MatrixView<T> tmp(ws.alloc<T>(dst.a.size()), dst.rows, dst.cols, dst.cols);
+        EvalCtx<T> ctx;
+        eval_expr(tmp, e, alpha, ctx);
+        for (int i = 0; i < dst.rows; ++i)
+            for (int j = 0; j < dst.cols; ++j)
+                dst(i, j) = (base == T{} ? T{} : base * dst(i, j)) + tmp(i, j);
+        return;
+    }
+
+    EvalCtx<T> ctx;
+    ctx.dst = lo;
+    ctx.beta = base + alpha * dst_coeff(e, lo);
+    eval_expr(view(dst), e, alpha, ctx);
+    if (!ctx.applied) scale_view(view(dst), ctx.beta);
+}
+
+// Пиковый объём арены при вычислении выражения (без учёта временного буфера присваивания)
+template <class T, bool Tr>
+size_t expr_workspace_bytes(const MatRef<T, Tr>&) { return 0; }
+
+template <class E>
+size_t expr_workspace_bytes(const ScaleExpr<E>& e) { return expr_workspace_bytes(e.e); }
+
+template <class L, class R>
+size_t expr_workspace_bytes(const SumExpr<L, R>& e) {
+    return std::max(expr_workspace_bytes(e.l), expr_workspace_bytes(e.r));
+}
+
+template <class L, class R>
+size_t expr_workspace_bytes(const ProdExpr<L, R>& e) {
+    using T = typename L::value_type;
+    using PL = typename peeled<L>::type;
+    using PR = typename peeled<R>::type;
+    size_t ls = is_mat_ref<PL>::value ? 0 : Workspace::aligned_size((size_t)e.l.rows() * e.l.cols() * sizeof(T));
+    size_t rs = is_mat_ref<PR>::value ? 0 : Workspace::aligned_size((size_t)e.r.rows() * e.r.cols() * sizeof(T));
+    size_t peak_l = ls + expr_workspace_bytes(e.l);
+    size_t peak_r = ls + rs + expr_workspace_bytes(e.r);
+    size_t peak_gemm = ls + rs + gemm_workspace_bytes<T>(e.rows(), e.l.cols(), e.cols(),
+                                                         std::is_same_v<PL, MatRef<T, true>>,
+                                                         std::is_same_v<PR, MatRef<T, true>>);
+    return std::max({peak_l, peak_r, peak_gemm});
+}
+
+// Для присваивания dst = e: плюс буфер размера dst, если dst читается операндом
+template <class T, class E>
+size_t assign_workspace_bytes(const Matrix<T>& dst, const MatExpr<E>& e) {
+    const T* lo = dst.data();
+    const T* hi = dst.data() + dst.a.size();
+    bool fits = dst.rows == e.self().rows() and dst.cols == e.self().cols();
+    size_t tmp = (fits and reads_dst(e.self(), lo, hi, true)) ? Workspace::aligned_size(dst.a.size() * sizeof(T)) : 0;
+    return tmp + expr_workspace_bytes(e.self());
+}
+
+template <class T>
+template <class E>
+Matrix<T>::Matrix(const MatExpr<E>& e) : Matrix(e.self().rows(), e.self().cols()) {
+    EvalCtx<T> ctx;
+    eval_expr(view(*this), e.self(), T{1}, ctx);
+}
+
+template <class T>
+template <class E>
+Matrix<T>& Matrix<T>::operator=(const MatExpr<E>& e) {
+    assign_expr(*this, e.self(), T{}, T{1});
+    return *this;
+}
+
+template <class T>
+template <class E>
+Matrix<T>& Matrix<T>::operator+=(const MatExpr<E>& e) {
+    assign_expr(*this, e.self(), T{1}, T{1});
+    return *this;
+}
+
+template <class T>
+template <class E>
+Matrix<T>& Matrix<T>::operator-=(const MatExpr<E>& e) {
+    assign_expr(*this, e.self(), T{1}, T{-1});
+    return *this;
+}
+
+#endif // MATRIX_EXPR_H
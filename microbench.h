@@ -0,0 +1,128 @@
+//
+// Микробенчмарк пиковой производительности double
+// Каждый поток крутит PEAK_CHAINS независимых цепочек a = a * x + y на самых широких
+// векторах, которые разрешает ISA (AVX-512, AVX2 + FMA, SSE2, NEON): их достаточно,
+// чтобы скрыть задержку FMA, и ничего не читается из памяти.
+// Собирается внутри каждого варианта ядер (kernels_impl.inc), вызывается через kernels().
+//
+
+#ifndef MICROBENCH_H
+#define MICROBENCH_H
+
+#include "parallel.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+static constexpr int PEAK_CHAINS = 12;
+
+#if defined(__AVX512F__)
+struct PeakVec {
+    using V = __m512d;
+    static constexpr int W = 8, FLOPS = 2;
+    static V set1(double x) { return _mm512_set1_pd(x); }
+    static V fma(V a, V x, V y) { return _mm512_fmadd_pd(a, x, y); }
+    static double sum(V a) {
+        alignas(64) double t[8];
+        _mm512_store_pd(t, a);
+        return t[0] + t[1] + t[2] + t[3] + t[4] + t[5] + t[6] + t[7];
+    }
+};
+#elif defined(__AVX__)
+struct PeakVec {
+    using V = __m256d;
+    static constexpr int W = 4, FLOPS = 2;
+#if defined(__FMA__)
+    static V fma(V a, V x, V y) { return _mm256_fmadd_pd(a, x, y); }
+#else
+    static V fma(V a, V x, V y) { return _mm256_add_pd(_mm256_mul_pd(a, x), y); }
+#endif
+    static V set1(double x) { return _mm256_set1_pd(x); }
+    static double sum(V a) {
+        alignas(32) double t[4];
+        _mm256_store_pd(t, a);
+        return t[0] + t[1] + t[2] + t[3];
+    }
+};
+#elif defined(__SSE2__)
+struct PeakVec {
+    using V = __m128d;
+    static constexpr int W = 2, FLOPS = 2;
+    static V set1(double x) { return _mm_set1_pd(x); }
+    static V fma(V a, V x, V y) { return _mm_add_pd(_mm_mul_pd(a, x), y); }
+    static double sum(V a) {
+        alignas(16) double t[2];
+        _mm_store_pd(t, a);
+        return t[0] + t[1];
+    }
+};
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+struct PeakVec {
+    using V = float64x2_t;
+    static constexpr int W = 2, FLOPS = 2;
+    static V set1(double x) { return vdupq_n_f64(x); }
+    static V fma(V a, V x, V y) { return vfmaq_f64(y, a, x); }
+    static double sum(V a) { return vaddvq_f64(a); }
+};
+#else
+struct PeakVec {
+    using V = double;
+    static constexpr int W = 1, FLOPS = 2;
+    static V set1(double x) { return x; }
+    static V fma(V a, V x, V y) { return a * x + y; }
+    static double sum(V a) { return a; }
+};
+#endif
+
+// iters шагов по всем цепочкам; возвращает сумму, чтобы цикл не выбросил компилятор
+inline double peak_loop(int64_t iters) {
+    using V = PeakVec::V;
+    V acc[PEAK_CHAINS];
+    for (int c = 0; c < PEAK_CHAINS; c++) acc[c] = PeakVec::set1(1.0 + c * 1e-3);
+    // Неподвижная точка a = a * x + y - y / (1 - x): значения не растут и не уходят в денормалы
+    const V x = PeakVec::set1(0.999999), y = PeakVec::set1(1e-6);
+    for (int64_t it = 0; it < iters; it++)
+        for (int c = 0; c < PEAK_CHAINS; c++) acc[c] = PeakVec::fma(acc[c], x, y);
+    double s = 0;
+    for (int c = 0; c < PEAK_CHAINS; c++) s += PeakVec::sum(acc[c]);
+    return s;
+}
+
+// GFLOP/s всех num_threads потоков (0 - все ядра); каждый поток работает ~50 мс
+inline double peak_gflops_f64(int num_threads) {
+    if (num_threads <= 0) num_threads = default_num_threads();
+    const int64_t flops_per_iter = (int64_t)PEAK_CHAINS * PeakVec::W * PeakVec::FLOPS;
+
+    // Калибровка в одном потоке: сколько итераций занимают ~50 мс
+    int64_t iters = 1 << 16;
+    volatile double sink = 0;
+    for (;;) {
+        auto t0 = std::chrono::steady_clock::now();
+        sink = sink + peak_loop(iters);
+        double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        if (s > 0.01 or iters > ((int64_t)1 << 40)) {
+            iters = (int64_t)(iters * 0.05 / std::max(s, 1e-9));
+            break;
+        }
+        iters *= 4;
+    }
+
+    std::vector<double> sums(num_threads);
+    auto t0 = std::chrono::steady_clock::now();
+    parallel_for(0, num_threads, [&](int lo, int hi) {
+        for (int t = lo; t < hi; t++) sums[t] = peak_loop(iters);
+    }, num_threads);
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    for (double x : sums) sink = sink + x;
+    return (double)flops_per_iter * iters * num_threads / s * 1e-9;
+}
+
+#endif // MICROBENCH_H
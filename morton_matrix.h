@@ -0,0 +1,149 @@
+//
+// Тайловое хранение в порядке Мортона (Z-order)
+// Матрица режется на тайлы TS x TS; каждый тайл непрерывен (row-major внутри),
+// а сами тайлы лежат в Z-порядке. Сетка тайлов прямоугольная: строки и столбцы
+// добиваются до своих степеней двойки R x C по отдельности. Она хранится как полоса
+// квадратов S x S (S = min(R, C)), каждый в Z-порядке, так что любой выровненный
+// квадрант до S x S тайлов непрерывен - на этом держится кэш-независимая рекурсия
+// в alg_cache_oblivious.h, а тонкая матрица не раздувается до квадрата.
+//
+
+#ifndef MORTON_MATRIX_H
+#define MORTON_MATRIX_H
+
+#include "structures.h"
+#include "parallel.h"
+#include <cstdint>
+#include <vector>
+
+// Чередование битов: x -> биты на чётных позициях
+inline uint64_t morton_spread(uint32_t x) {
+    uint64_t v = x;
+    v = (v | (v << 16)) & 0x0000FFFF0000FFFFull;
+    v = (v | (v << 8))  & 0x00FF00FF00FF00FFull;
+    v = (v | (v << 4))  & 0x0F0F0F0F0F0F0F0Full;
+    v = (v | (v << 2))  & 0x3333333333333333ull;
+    v = (v | (v << 1))  & 0x5555555555555555ull;
+    return v;
+}
+
+// Номер тайла (ti, tj) в Z-порядке: строка - старший бит пары,
+// поэтому квадранты идут как 00, 01, 10, 11
+inline uint64_t morton_index(uint32_t ti, uint32_t tj) {
+    return (morton_spread(ti) << 1) | morton_spread(tj);
+}
+
+inline int next_pow2(int x) {
+    int p = 1;
+    while (p < x) p *= 2;
+    return p;
+}
+
+template <class T, int TS = 16>
+struct MortonMatrix {
+    static constexpr int TILE = TS;
+
+    int rows = 0, cols = 0;              // логический размер
+    int grid_rows = 0, grid_cols = 0;    // тайлов по строкам / столбцам (степени двойки)
+    int square_bits = 0;                 // log2(min(grid_rows, grid_cols)) - сторона Z-квадрата
+    std::vector<T> a;
+
+    MortonMatrix() = default;
+
+    MortonMatrix(int r, int c) { resize(r, c); }
+
+    void resize(int r, int c) {
+        rows = r;
+        cols = c;
+        grid_rows = next_pow2((r + TS - 1) / TS);
+        grid_cols = next_pow2((c + TS - 1) / TS);
+        square_bits = 0;
+        while ((2 << square_bits) <= std::min(grid_rows, grid_cols)) square_bits++;
+        a.assign((size_t)grid_rows * grid_cols * TS * TS, T{});
+    }
+
+    int tile_rows() const { return (rows + TS - 1) / TS; }
+    int tile_cols() const { return (cols + TS - 1) / TS; }
+
+    // Номер тайла: номер квадрата в полосе (по длинной стороне ненулевой лишь один из
+    // ti >> square_bits, tj >> square_bits), затем Z-порядок внутри квадрата
+    uint64_t tile_index(int ti, int tj) const {
+        uint32_t mask = (1u << square_bits) - 1;
+        uint64_t square = (uint64_t)((ti >> square_bits) | (tj >> square_bits));
+        return (square << (2 * square_bits)) | morton_index(ti & mask, tj & mask);
+    }
+
+    // Начало тайла (или квадранта с этим левым верхним тайлом)
+    T* tile(int ti, int tj) { return a.data() + tile_index(ti, tj) * TS * TS; }
+    const T* tile(int ti, int tj) const { return a.data() + tile_index(ti, tj) * TS * TS; }
+
+    T& operator()(int i, int j) {
+        assert(0 <= i and i < rows and 0 <= j and j < cols);
+        return tile(i / TS, j / TS)[(i % TS) * TS + (j % TS)];
+    }
+
+    const T& operator()(int i, int j) const {
+        assert(0 <= i and i < rows and 0 <= j and j < cols);
+        return tile(i / TS, j / TS)[(i % TS) * TS + (j % TS)];
+    }
+};
+
+// Row-major -> Morton. Полосы тайлов по строкам конвертируются параллельно;
+// хвосты тайлов за границей матрицы остаются нулями.
+template <class T, int TS>
+void to_morton(MatrixView<const T> src, MortonMatrix<T, TS>& dst) {
+    dst.resize(src.rows, src.cols);
+    int tr = dst.tile_rows(), tc = dst.tile_cols();
+
+    parallel_for(0, tr, [&](int t0, int t1) {
+        for (int ti = t0; ti < t1; ti++) {
+            int r0 = ti * TS;
+            int h = std::min(TS, src.rows - r0);
+            for (int tj = 0; tj < tc; tj++) {
+                int c0 = tj * TS;
+                int w = std::min(TS, src.cols - c0);
+                T* t = dst.tile(ti, tj);
+                for (int i = 0; i < h; i++) {
+                    const T* s = src.ptr + (size_t)(r0 + i) * src.stride + c0;
+                    for (int j = 0; j < w; j++) t[i * TS + j] = s[j];
+                }
+            }
+        }
+    }, 0, 4);
+}
+
+template <class T, int TS>
+void to_morton(const Matrix<T>& src, MortonMatrix<T, TS>& dst) {
+    to_morton(view(src), dst);
+}
+
+// Morton -> row-major
+template <class T, int TS>
+void from_morton(const MortonMatrix<T, TS>& src, MatrixView<T> dst) {
+    assert(dst.rows == src.rows and dst.cols == src.cols);
+    int tr = src.tile_rows(), tc = src.tile_cols();
+
+    parallel_for(0, tr, [&](int t0, int t1) {
+        for (int ti = t0; ti < t1; ti++) {
+            int r0 = ti * TS;
+            int h = std::min(TS, src.rows - r0);
+            for (int tj = 0; tj < tc; tj++) {
+                int c0 = tj * TS;
+                int w = std::min(TS, src.cols - c0);
+                const T* t = src.tile(ti, tj);
+                for (int i = 0; i < h; i++) {
+                    T* d = dst.ptr + (size_t)(r0 + i) * dst.stride + c0;
+                    for (int j = 0; j < w; j++) d[j] = t[i * TS + j];
+                }
+            }
+        }
+    }, 0, 4);
+}
+
+template <class T, int TS>
+void from_morton(const MortonMatrix<T, TS>& src, Matrix<T>& dst) {
+    dst.resize(src.rows, src.cols);
+    from_morton(src, view(dst));
+}
+
+#endif // MORTON_MATRIX_H
@@ -0,0 +1,321 @@
+//
+// NUMA: топология, размещение памяти и привязка потоков
+// Matrix заполняет буфер нулями в одном потоке, и все страницы оказываются на узле
+// этого потока. NumaMatrix выделяет нетронутые страницы (mmap) и касается их
+// параллельно теми же полосами строк, что и parallel_for с тем же num_threads, -
+// каждая полоса ложится на узел потока, который потом её и считает.
+// Топология читается из /sys/devices/system/node; если её нет - один узел со всеми ядрами.
+// Привязка и политика памяти работают на Linux; на других системах это пустые операции.
+//
+
+#ifndef NUMA_H
+#define NUMA_H
+
+#include "structures.h"
+#include "parallel.h"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#endif
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+///--------------------------
+///  Топология
+///--------------------------
+struct NumaTopology {
+    std::vector<int> node_ids;                // номера узлов в системе (узлы без ядер пропущены)
+    std::vector<std::vector<int>> node_cpus;  // ядра каждого узла
+
+    int nodes() const { return (int)node_cpus.size(); }
+    int cpus() const {
+        int s = 0;
+        for (auto& c : node_cpus) s += (int)c.size();
+        return s;
+    }
+};
+
+// Формат cpulist / online: "0-3,8-11"
+inline std::vector<int> parse_cpu_list(const std::string& text) {
+    std::vector<int> out;
+    std::stringstream ss(text);
+    std::string part;
+    while (std::getline(ss, part, ',')) {
+        if (part.empty() or part == "\n") continue;
+        int lo = 0, hi = 0;
+        size_t dash = part.find('-');
+        try {
+            lo = std::stoi(part.substr(0, dash));
+            hi = dash == std::string::npos ? lo : std::stoi(part.substr(dash + 1));
+        } catch (...) {
+            continue;
+        }
+        for (int c = lo; c <= hi; c++) out.push_back(c);
+    }
+    return out;
+}
+
+inline NumaTopology read_numa_topology(const std::string& root = "/sys/devices/system/node") {
+    NumaTopology topo;
+    std::ifstream online(root + "/online");
+    std::string line;
+    if (online and std::getline(online, line)) {
+        for (int node : parse_cpu_list(line)) {
+            std::ifstream f(root + "/node" + std::to_string(node) + "/cpulist");
+            std::string cpus;
+            if (f and std::getline(f, cpus)) {
+                auto list = parse_cpu_list(cpus);
+                if (list.empty()) continue;
+                topo.node_ids.push_back(node);
+                topo.node_cpus.push_back(list);
+            }
+        }
+    }
+    // Нет sysfs (не Linux, контейнер без /sys) - один узел
+    if (topo.node_cpus.empty()) {
+        std::vector<int> all(default_num_threads());
+        for (int c = 0; c < (int)all.size(); c++) all[c] = c;
+        topo.node_ids = {0};
+        topo.node_cpus = {all};
+    }
+    return topo;
+}
+
+inline const NumaTopology& numa_topology() {
+    static const NumaTopology topo = read_numa_topology();
+    return topo;
+}
+
+///--------------------------
+///  Привязка потоков
+///--------------------------
+// Узлы ниже нумеруются индексом в NumaTopology, системный номер - node_ids[node].
+// Поток t из n: узлы получают непрерывные блоки потоков пропорционально числу ядер,
+// внутри узла - ядра по кругу. Так полосы 0..n-1 идут по узлам подряд.
+inline int numa_node_for_thread(int t, int num_threads) {
+    const NumaTopology& topo = numa_topology();
+    int total = topo.cpus(), acc = 0;
+    for (int node = 0; node < topo.nodes(); node++) {
+        acc += (int)topo.node_cpus[node].size();
+        if ((int64_t)t * total < (int64_t)acc * num_threads) return node;
+    }
+    return topo.nodes() - 1;
+}
+
+inline int numa_cpu_for_thread(int t, int num_threads) {
+    const NumaTopology& topo = numa_topology();
+    int node = numa_node_for_thread(t, num_threads);
+    int first = t;
+    while (first > 0 and numa_node_for_thread(first - 1, num_threads) == node) first--;
+    const auto& cpus = topo.node_cpus[node];
+    return cpus[(t - first) % cpus.size()];
+}
+
+// false - привязка не поддерживается или не удалась
+inline bool pin_current_thread(const std::vector<int>& cpus) {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int c : cpus)
+        if (c >= 0 and c < CPU_SETSIZE) CPU_SET(c, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpus;
+    return false;
+#endif
+}
+
+inline bool pin_current_thread_to_cpu(int cpu) { return pin_current_thread({cpu}); }
+
+inline bool pin_current_thread_to_node(int node) {
+    const NumaTopology& topo = numa_topology();
+    if (node < 0 or node >= topo.nodes()) return false;
+    return pin_current_thread(topo.node_cpus[node]);
+}
+
+inline void numa_place_thread(int t, int num_threads) {
+    pin_current_thread_to_cpu(numa_cpu_for_thread(t, num_threads));
+}
+
+// Включает привязку потоков во всех parallel_for (и в ядрах библиотеки matmul_kernels)
+inline void set_numa_pinning(bool enabled) {
+    parallel_thread_placement() = enabled ? &numa_place_thread : nullptr;
+}
+
+// Системный номер узла, на котором лежит страница с адресом p; -1 - неизвестно (страница не тронута, не Linux)
+inline int numa_node_of_address(const void* p) {
+#if defined(__linux__) && defined(SYS_get_mempolicy)
+    int node = -1;
+    constexpr unsigned long MPOL_F_NODE = 1, MPOL_F_ADDR = 2;
+    if (syscall(SYS_get_mempolicy, &node, nullptr, 0ul, p, MPOL_F_NODE | MPOL_F_ADDR) == 0) return node;
+#else
+    (void)p;
+#endif
+    return -1;
+}
+
+///--------------------------
+///  Память
+///--------------------------
+enum class NumaPolicy {
+    FIRST_TOUCH,   // страница на узле потока, который первым её записал (полосы строк)
+    INTERLEAVE,    // страницы по кругу по всем узлам (mbind MPOL_INTERLEAVE)
+};
+
+// Нетронутый буфер из анонимных страниц: они читаются как нули, пока их не записали
+template <class T>
+class NumaBuffer {
+    static_assert(std::is_trivially_copyable_v<T>, "NumaBuffer relies on zero pages being T{}");
+
+public:
+    NumaBuffer() = default;
+
+    explicit NumaBuffer(size_t n, NumaPolicy policy = NumaPolicy::FIRST_TOUCH) : n_(n) {
+        bytes_ = n * sizeof(T);
+        if (bytes_ == 0) return;
+#if defined(__unix__) || defined(__APPLE__)
+        void* p = mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) throw std::bad_alloc();
+        ptr_ = static_cast<T*>(p);
+        mapped_ = true;
+#else
+        ptr_ = static_cast<T*>(::operator new(bytes_));
+        std::memset(ptr_, 0, bytes_);
+#endif
+        if (policy == NumaPolicy::INTERLEAVE) interleave();
+    }
+
+    ~NumaBuffer() { release(); }
+
+    NumaBuffer(const NumaBuffer&) = delete;
+    NumaBuffer& operator=(const NumaBuffer&) = delete;
+
+    NumaBuffer(NumaBuffer&& o) noexcept { *this = std::move(o); }
+    NumaBuffer& operator=(NumaBuffer&& o) noexcept {
+        if (this != &o) {
+            release();
+            ptr_ = std::exchange(o.ptr_, nullptr);
+            n_ = std::exchange(o.n_, 0);
+            bytes_ = std::exchange(o.bytes_, 0);
+            mapped_ = std::exchange(o.mapped_, false);
+        }
+        return *this;
+    }
+
+    T* data() { return ptr_; }
+    const T* data() const { return ptr_; }
+    size_t size() const { return n_; }
+
+private:
+    void interleave() {
+#if defined(__linux__) && defined(SYS_mbind)
+        const NumaTopology& topo = numa_topology();
+        if (topo.nodes() < 2) return;
+        // Только узлы с ядрами: память узлов без ядер (CXL, HBM) сюда не попадает
+        std::vector<unsigned long> mask(4, 0);
+        for (int id : topo.node_ids)
+            if (id >= 0 and id < 256) mask[id / 64] |= 1ul << (id % 64);
+        constexpr int MPOL_INTERLEAVE = 3;
+        // Неудача (нет прав, ядро без NUMA) - остаётся first touch
+        syscall(SYS_mbind, ptr_, bytes_, MPOL_INTERLEAVE, mask.data(), 256ul + 1, 0u);
+#endif
+    }
+
+    void release() {
+        if (ptr_ == nullptr) return;
+#if defined(__unix__) || defined(__APPLE__)
+        if (mapped_) munmap(ptr_, bytes_);
+#else
+        ::operator delete(ptr_);
+#endif
+        ptr_ = nullptr;
+    }
+
+    T* ptr_ = nullptr;
+    size_t n_ = 0, bytes_ = 0;
+    bool mapped_ = false;
+};
+
+///--------------------------
+///  NumaMatrix
+///--------------------------
+// Плотная row-major матрица в NumaBuffer; алгоритмы работают с ней через view()
+template <class T>
+struct NumaMatrix {
+    int rows = 0, cols = 0;
+    NumaBuffer<T> buf;
+
+    NumaMatrix() = default;
+
+    // Страницы полосы строк t касаются в потоке t (с привязкой, если она включена)
+    NumaMatrix(int r, int c, NumaPolicy policy = NumaPolicy::FIRST_TOUCH, int num_threads = 0)
+        : rows(r), cols(c), buf((size_t)r * c, policy) {
+        T* p = buf.data();
+        size_t row_bytes = (size_t)c * sizeof(T);
+        parallel_for(0, r, [&](int lo, int hi) {
+            std::memset(static_cast<void*>(p + (size_t)lo * c), 0, (size_t)(hi - lo) * row_bytes);
+        }, num_threads);
+    }
+
+    T* data() { return buf.data(); }
+    const T* data() const { return buf.data(); }
+    int stride() const { return cols; }
+
+    T& operator()(int i, int j) {
+        assert(0 <= i and i < rows and 0 <= j and j < cols);
+        return buf.data()[(size_t)i * cols + j];
+    }
+
+    const T& operator()(int i, int j) const {
+        assert(0 <= i and i < rows and 0 <= j and j < cols);
+        return buf.data()[(size_t)i * cols + j];
+    }
+};
+
+template <class T>
+MatrixView<T> view(NumaMatrix<T>& M) {
+    return { M.data(), M.rows, M.cols, M.stride() };
+}
+
+template <class T>
+MatrixView<const T> view(const NumaMatrix<T>& M) {
+    return { M.data(), M.rows, M.cols, M.stride() };
+}
+
+// Копия Matrix с размещением по полосам: каждая полоса копируется (и касается) своим потоком
+template <class T>
+NumaMatrix<T> to_numa(const Matrix<T>& A, NumaPolicy policy = NumaPolicy::FIRST_TOUCH,
+                      int num_threads = 0) {
+    NumaMatrix<T> R;
+    R.rows = A.rows;
+    R.cols = A.cols;
+    R.buf = NumaBuffer<T>((size_t)A.rows * A.cols, policy);
+    T* dst = R.data();
+    const T* src = A.data();
+    parallel_for(0, A.rows, [&](int lo, int hi) {
+        std::memcpy(static_cast<void*>(dst + (size_t)lo * A.cols), src + (size_t)lo * A.cols,
+                    (size_t)(hi - lo) * A.cols * sizeof(T));
+    }, num_threads);
+    return R;
+}
+
+template <class T>
+void from_numa(const NumaMatrix<T>& A, Matrix<T>& C) {
+    C.resize(A.rows, A.cols);
+    std::memcpy(static_cast<void*>(C.data()), A.data(), (size_t)A.rows * A.cols * sizeof(T));
+}
+
+#endif // NUMA_H
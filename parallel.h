@@ -0,0 +1,92 @@
+//
+// Простой параллельный цикл поверх std::thread
+// Диапазон [begin, end) режется на равные непрерывные полосы, по одной на поток
+//
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+// Число потоков по умолчанию: все доступные ядра
+inline int default_num_threads() {
+    unsigned hw = std::thread::hardware_concurrency();
+    return hw == 0 ? 1 : (int)hw;
+}
+
+// Размещение потоков: если задано, вызывается первым делом в потоке полосы t из n
+// (numa.h привязывает поток к ядру узла, которому принадлежит полоса)
+using ThreadPlacement = void (*)(int t, int num_threads);
+
+inline ThreadPlacement& parallel_thread_placement() {
+    static ThreadPlacement placement = nullptr;
+    return placement;
+}
+
+// Наблюдатель полос: если задан, получает время работы полосы t из n (для замера дисбаланса).
+// Вызывается из потока полосы, поэтому должен быть потокобезопасным
+using BandObserver = void (*)(int t, int num_threads, double busy_ms);
+
+inline BandObserver& parallel_band_observer() {
+    static BandObserver observer = nullptr;
+    return observer;
+}
+
+template <class F>
+void parallel_run_band(F& f, int lo, int hi, int t, int num_threads, BandObserver observe) {
+    if (observe == nullptr) {
+        f(lo, hi);
+        return;
+    }
+    auto t0 = std::chrono::steady_clock::now();
+    f(lo, hi);
+    observe(t, num_threads, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count());
+}
+
+// Вызывает f(lo, hi) для полос [lo, hi), покрывающих [begin, end).
+// grain - минимальная длина полосы, чтобы не плодить потоки на мелких задачах.
+// Разбиение статическое: полоса t всегда достаётся потоку t.
+template <class F>
+void parallel_for(int begin, int end, F&& f, int num_threads = 0, int grain = 1) {
+    int total = end - begin;
+    if (total <= 0) return;
+
+    if (num_threads <= 0) num_threads = default_num_threads();
+    num_threads = std::min(num_threads, std::max(1, total / std::max(1, grain)));
+
+    BandObserver observe = parallel_band_observer();
+    if (num_threads == 1) {
+        parallel_run_band(f, begin, end, 0, 1, observe);
+        return;
+    }
+
+    // С размещением все полосы идут в новых потоках: привязка вызывающего потока не меняется
+    ThreadPlacement place = parallel_thread_placement();
+
+    std::vector<std::thread> workers;
+    workers.reserve(num_threads);
+
+    int chunk = total / num_threads;
+    int rest = total % num_threads;
+    int lo = begin;
+    for (int t = 0; t < num_threads; t++) {
+        int hi = lo + chunk + (t < rest ? 1 : 0);
+        if (t + 1 == num_threads and place == nullptr) {
+            // Последнюю полосу считает вызывающий поток
+            parallel_run_band(f, lo, hi, t, num_threads, observe);
+        } else {
+            workers.emplace_back([&f, place, observe, t, num_threads, lo, hi] {
+                if (place) place(t, num_threads);
+                parallel_run_band(f, lo, hi, t, num_threads, observe);
+            });
+        }
+        lo = hi;
+    }
+
+    for (auto& w : workers) w.join();
+}
+
+#endif // PARALLEL_H
@@ -0,0 +1,82 @@
+//
+// Модель roofline: пик FLOP/s и пропускная способность памяти этой машины
+// Пик - микробенчмарк FMA выбранного варианта ядер (kernels().peak_gflops_f64),
+// пропускная способность - STREAM triad a = b + s * c на массивах больше кэша.
+// Достижимая производительность при интенсивности I (FLOP на байт): min(пик, I * BW).
+//
+
+#ifndef ROOFLINE_H
+#define ROOFLINE_H
+
+#include "dispatch.h"
+#include "parallel.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+struct Roofline {
+    double peak_gflops = 0;      // GFLOP/s
+    double bandwidth_gbs = 0;    // GB/s
+    int num_threads = 0;
+
+    double attainable_gflops(double intensity) const {
+        return std::min(peak_gflops, intensity * bandwidth_gbs);
+    }
+
+    // Интенсивность, начиная с которой упираемся в вычисления
+    double ridge_point() const { return bandwidth_gbs > 0 ? peak_gflops / bandwidth_gbs : 0.0; }
+};
+
+// Обязательный трафик GEMM m x k x n: прочитать A и B и записать C по одному разу
+inline double gemm_flops(int m, int k, int n) { return 2.0 * m * k * n; }
+
+inline double gemm_min_bytes(int m, int k, int n, size_t elem_bytes) {
+    return (double)elem_bytes * ((double)m * k + (double)k * n + (double)m * n);
+}
+
+// STREAM triad, лучший из repeats проходов; bytes - размер одного массива
+inline double measure_bandwidth_gbs(int num_threads = 0, size_t bytes = (size_t)64 << 20, int repeats = 5) {
+    if (num_threads <= 0) num_threads = default_num_threads();
+    const size_t n = bytes / sizeof(double);
+    std::unique_ptr<double[]> a(new double[n]), b(new double[n]), c(new double[n]);
+    const int chunks = num_threads * 16;
+    auto bands = [&](auto&& f) {
+        parallel_for(0, chunks, [&](int lo, int hi) {
+            f(n * lo / chunks, n * hi / chunks);
+        }, num_threads);
+    };
+    // Первое касание теми же полосами, что и замер
+    bands([&](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; i++) {
+            a[i] = 0.0;
+            b[i] = 1.0;
+            c[i] = 2.0;
+        }
+    });
+
+    double best = 0;
+    const double s = 0.5;
+    for (int r = 0; r < repeats; r++) {
+        auto t0 = std::chrono::steady_clock::now();
+        bands([&](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; i++) a[i] = b[i] + s * c[i];
+        });
+        double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        best = std::max(best, 3.0 * n * sizeof(double) / sec * 1e-9);
+    }
+    volatile double sink = a[n / 2];
+    (void)sink;
+    return best;
+}
+
+inline Roofline measure_roofline(int num_threads = 0) {
+    Roofline r;
+    r.num_threads = num_threads <= 0 ? default_num_threads() : num_threads;
+    r.peak_gflops = kernels().peak_gflops_f64(r.num_threads);
+    r.bandwidth_gbs = measure_bandwidth_gbs(r.num_threads);
+    return r;
+}
+
+#endif // ROOFLINE_H
@@ -0,0 +1,102 @@
+//
+// Полукольца для обобщённого умножения C(i, j) = ⊕_p A(i, p) ⊗ B(p, j)
+// Полукольцо - тип со статическими zero() (нейтральный для ⊕ и поглощающий для ⊗),
+// one() (нейтральный для ⊗), add(x, y) = x ⊕ y и mul(x, y) = x ⊗ y.
+// Стандартные полукольца дополнительно объявляют add_op / mul_op - по ним
+// alg_semiring.h выбирает SIMD-ядро; для пользовательских работает скалярное.
+//
+
+#ifndef SEMIRING_H
+#define SEMIRING_H
+
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+
+enum class SemiOp {
+    PLUS,
+    TIMES,
+    MIN,
+    MAX
+};
+
+// +inf для типов с бесконечностью, иначе максимум (и симметрично для -inf)
+template <class T>
+constexpr T semiring_inf() {
+    if constexpr (std::numeric_limits<T>::has_infinity) return std::numeric_limits<T>::infinity();
+    else return std::numeric_limits<T>::max();
+}
+
+template <class T>
+constexpr T semiring_neg_inf() {
+    if constexpr (std::numeric_limits<T>::has_infinity) return -std::numeric_limits<T>::infinity();
+    else return std::numeric_limits<T>::lowest();
+}
+
+// x + y для ⊗ тропических полукольец: absorb (их zero) поглощает, целые насыщаются в
+// [lowest, max], а не переполняются (для целых zero = max / lowest, и max + w было бы UB)
+template <class T>
+constexpr T semiring_tropical_add(const T& x, const T& y, const T& absorb) {
+    if constexpr (std::is_integral_v<T>) {
+        if (x == absorb or y == absorb) return absorb;
+        T r;
+        if (__builtin_add_overflow(x, y, &r)) return y > 0 ? semiring_inf<T>() : semiring_neg_inf<T>();
+        return r;
+    } else {
+        return x + y;
+    }
+}
+
+// Обычная арифметика (+, *)
+template <class T>
+struct PlusTimes {
+    using value_type = T;
+    static constexpr SemiOp add_op = SemiOp::PLUS;
+    static constexpr SemiOp mul_op = SemiOp::TIMES;
+
+    static T zero() { return T{}; }
+    static T one() { return T(1); }
+    static T add(const T& x, const T& y) { return x + y; }
+    static T mul(const T& x, const T& y) { return x * y; }
+};
+
+// Тропическое (min, +): кратчайшие пути, zero = +inf - нет ребра
+template <class T>
+struct MinPlus {
+    using value_type = T;
+    static constexpr SemiOp add_op = SemiOp::MIN;
+    static constexpr SemiOp mul_op = SemiOp::PLUS;
+
+    static T zero() { return semiring_inf<T>(); }
+    static T one() { return T{}; }
+    static T add(const T& x, const T& y) { return std::min(x, y); }
+    static T mul(const T& x, const T& y) { return semiring_tropical_add(x, y, zero()); }
+};
+
+// (max, +): самые длинные пути в DAG, критический путь расписания
+template <class T>
+struct MaxPlus {
+    using value_type = T;
+    static constexpr SemiOp add_op = SemiOp::MAX;
+    static constexpr SemiOp mul_op = SemiOp::PLUS;
+
+    static T zero() { return semiring_neg_inf<T>(); }
+    static T one() { return T{}; }
+    static T add(const T& x, const T& y) { return std::max(x, y); }
+    static T mul(const T& x, const T& y) { return semiring_tropical_add(x, y, zero()); }
+};
+
+// (max, *) на неотрицательных числах: самый надёжный путь, Витерби
+template <class T>
+struct MaxTimes {
+    using value_type = T;
+    static constexpr SemiOp add_op = SemiOp::MAX;
+    static constexpr SemiOp mul_op = SemiOp::TIMES;
+
+    static T zero() { return T{}; }
+    static T one() { return T(1); }
+    static T add(const T& x, const T& y) { return std::max(x, y); }
+    static T mul(const T& x, const T& y) { return x * y; }
+};
+
+#endif // SEMIRING_H
@@ -10,6 +10,8 @@
 #include <cassert>
 #include <type_traits>
 
+template <class E> struct MatExpr;
+
 ///--------------------------
 ///        Matrix
 ///--------------------------
@@ -21,6 +23,12 @@ struct Matrix {
     Matrix() = default;
     Matrix(int r, int c) : rows(r), cols(c), a((size_t)r * c, T{}) {}
 
+    // Вычисление ленивых выражений A*B + C и т.п. (определены в matrix_expr.h)
+    template <class E> Matrix(const MatExpr<E>& e);
+    template <class E> Matrix& operator=(const MatExpr<E>& e);
+    template <class E> Matrix& operator+=(const MatExpr<E>& e);
+    template <class E> Matrix& operator-=(const MatExpr<E>& e);
+
     void resize(int r, int c) {
         rows = r; cols = c;
         a.assign((size_t)r * (size_t)c, T{});
@@ -0,0 +1,179 @@
+//
+// Пул потоков с общей очередью задач
+// В отличие от parallel_for потоки создаются один раз. TaskGroup позволяет ждать
+// группу задач; ожидающий поток сам выполняет задачи из очереди, поэтому задачи
+// могут порождать вложенные группы (рекурсивные алгоритмы) без взаимной блокировки.
+//
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include "parallel.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+class ThreadPool {
+public:
+    // num_threads <= 0 - по числу ядер
+    explicit ThreadPool(int num_threads = 0) {
+        if (num_threads <= 0) num_threads = default_num_threads();
+        workers_.reserve(num_threads);
+        for (int t = 0; t < num_threads; t++) {
+            workers_.emplace_back([this] { worker_loop(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (auto& w : workers_) w.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const { return (int)workers_.size(); }
+
+    // Поставить задачу в очередь без результата
+    void enqueue(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push_back(std::move(task));
+        }
+        cv_.notify_one();
+    }
+
+    // Поставить задачу в начало очереди: её возьмёт первый освободившийся поток
+    // раньше уже ожидающих (для запросов, чувствительных к задержке)
+    void enqueue_front(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push_front(std::move(task));
+        }
+        cv_.notify_one();
+    }
+
+    // Поставить задачу в очередь; результат (или исключение) - через future
+    template <class F>
+    auto submit(F&& f) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+        using R = std::invoke_result_t<std::decay_t<F>>;
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+        std::future<R> result = task->get_future();
+        enqueue([task] { (*task)(); });
+        return result;
+    }
+
+    // Выполнить одну задачу из очереди в текущем потоке. false - очередь пуста.
+    bool try_run_one() {
+        std::function<void()> task;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (queue_.empty()) return false;
+            task = std::move(queue_.front());
+            queue_.pop_front();
+        }
+        task();
+        return true;
+    }
+
+private:
+    void worker_loop() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this] { return stop_ or !queue_.empty(); });
+                if (stop_ and queue_.empty()) return;
+                task = std::move(queue_.front());
+                queue_.pop_front();
+            }
+            task();
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> queue_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stop_ = false;
+};
+
+// Общий пул процесса: создаётся при первом обращении
+inline ThreadPool& global_thread_pool() {
+    static ThreadPool pool;
+    return pool;
+}
+
+// Группа задач с ожиданием. Первое исключение из задач пробрасывается из wait().
+class TaskGroup {
+public:
+    explicit TaskGroup(ThreadPool& pool = global_thread_pool()) : pool_(pool) {}
+
+    // Группа не должна разрушаться с невыполненными задачами
+    ~TaskGroup() { wait_no_throw(); }
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    template <class F>
+    void run(F&& f) {
+        pending_.fetch_add(1, std::memory_order_relaxed);
+        pool_.enqueue([this, f = std::forward<F>(f)]() mutable {
+            std::exception_ptr err;
+            try {
+                f();
+            } catch (...) {
+                err = std::current_exception();
+            }
+            // Под мьютексом: после выхода из wait() группа может быть сразу разрушена
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (err and !error_) error_ = err;
+            if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) done_.notify_all();
+        });
+    }
+
+    // Ждём все задачи группы, помогая пулу выполнять очередь
+    void wait() {
+        wait_no_throw();
+        if (error_) {
+            std::exception_ptr e = error_;
+            error_ = nullptr;
+            std::rethrow_exception(e);
+        }
+    }
+
+private:
+    void wait_no_throw() {
+        while (pending_.load(std::memory_order_acquire) > 0) {
+            if (pool_.try_run_one()) continue;
+            // Очередь пуста: оставшиеся задачи уже выполняются другими потоками.
+            // Спим недолго - они могут породить вложенные задачи, которые стоит подхватить.
+            std::unique_lock<std::mutex> lock(mutex_);
+            done_.wait_for(lock, std::chrono::microseconds(200),
+                           [this] { return pending_.load(std::memory_order_acquire) == 0; });
+        }
+        // Дожидаемся, пока последняя задача отпустит мьютекс
+        std::lock_guard<std::mutex> lock(mutex_);
+    }
+
+    ThreadPool& pool_;
+    std::atomic<int> pending_{0};
+    std::mutex mutex_;
+    std::condition_variable done_;
+    std::exception_ptr error_;
+};
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,288 @@
+//
+// Трассировка фаз умножения: упаковка, ядро, граничные блоки, запись в C, выделения памяти
+// Точка трассировки - MATMUL_TRACE_SCOPE(PACK) и т.п.: замеряет свою область видимости;
+// MATMUL_TRACE_SCOPE_PHASE(expr) - то же с фазой, выбираемой во время выполнения.
+// Точки ставятся на уровне тайлов и панелей, не в самых внутренних циклах: чтение TSC и запись
+// события стоят десятки тактов.
+// Без MATMUL_ENABLE_TRACE макрос пуст, и ничего из этого файла в сборку не попадает.
+//
+// У каждого потока своя дорожка: кольцевой буфер событий (пишет только владелец, чтение -
+// по атомарному head) и точные суммы по фазам, которые не теряются при переполнении кольца.
+// Потоки parallel_for короткоживущие, поэтому дорожка по завершении потока возвращается
+// в пул и достаётся следующему: число дорожек = наибольшее число одновременных потоков.
+// Экспорт (trace_write_chrome, trace_summary) - когда умножения не идут.
+//
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#ifdef MATMUL_ENABLE_TRACE
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#endif
+
+enum class TracePhase : uint8_t {
+    PACK,        // копирование операнда в упакованные панели
+    KERNEL,      // микроядро / полные блоки
+    BOUNDARY,    // граничные блоки (mul_naive_view)
+    WRITE_BACK,  // запись результата в C через эпилог
+    ALLOC,       // обращение арены к системному аллокатору
+    COUNT
+};
+
+static constexpr int TRACE_PHASES = (int)TracePhase::COUNT;
+
+inline const char* trace_phase_name(TracePhase p) {
+    switch (p) {
+        case TracePhase::PACK: return "pack";
+        case TracePhase::KERNEL: return "kernel";
+        case TracePhase::BOUNDARY: return "boundary";
+        case TracePhase::WRITE_BACK: return "write_back";
+        case TracePhase::ALLOC: return "alloc";
+        default: return "?";
+    }
+}
+
+// Итог по фазе с последнего trace_reset_summary()
+struct TracePhaseStats {
+    TracePhase phase = TracePhase::PACK;
+    uint64_t events = 0;
+    double total_ms = 0;     // сумма по всем потокам
+    double max_us = 0;       // самое длинное событие
+    int threads = 0;         // дорожек, где фаза встречалась
+    double imbalance = 1;    // max / среднее время фазы по этим дорожкам
+};
+
+#ifdef MATMUL_ENABLE_TRACE
+
+static constexpr bool trace_enabled = true;
+static constexpr size_t TRACE_RING_EVENTS = 1 << 15;  // на дорожку, степень двойки
+
+// Время в тиках: TSC на x86 (дешевле steady_clock), иначе наносекунды
+inline uint64_t trace_ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+struct TraceEvent {
+    uint64_t start = 0, end = 0;
+    TracePhase phase = TracePhase::PACK;
+};
+
+struct TraceLane {
+    int id = 0;
+    std::vector<TraceEvent> ring;
+    std::atomic<uint64_t> head{0};   // всего записано событий
+    uint64_t ticks[TRACE_PHASES] = {};
+    uint64_t count[TRACE_PHASES] = {};
+    uint64_t longest[TRACE_PHASES] = {};
+
+    explicit TraceLane(int lane_id) : id(lane_id), ring(TRACE_RING_EVENTS) {}
+
+    void record(TracePhase p, uint64_t start, uint64_t end) {
+        uint64_t h = head.load(std::memory_order_relaxed);
+        ring[h & (TRACE_RING_EVENTS - 1)] = {start, end, p};
+        head.store(h + 1, std::memory_order_release);
+        int i = (int)p;
+        ticks[i] += end - start;
+        count[i]++;
+        longest[i] = std::max(longest[i], end - start);
+    }
+
+    void reset_summary() {
+        std::fill(ticks, ticks + TRACE_PHASES, 0);
+        std::fill(count, count + TRACE_PHASES, 0);
+        std::fill(longest, longest + TRACE_PHASES, 0);
+    }
+};
+
+// Все дорожки процесса; мьютекс только при выдаче / возврате дорожки и экспорте
+struct TraceRegistry {
+    std::mutex mu;
+    std::vector<std::unique_ptr<TraceLane>> lanes;
+    std::vector<TraceLane*> free_lanes;
+    uint64_t origin_ticks = trace_ticks();
+    std::chrono::steady_clock::time_point origin_time = std::chrono::steady_clock::now();
+
+    TraceLane* acquire() {
+        std::lock_guard<std::mutex> lock(mu);
+        if (!free_lanes.empty()) {
+            TraceLane* lane = free_lanes.back();
+            free_lanes.pop_back();
+            return lane;
+        }
+        lanes.push_back(std::make_unique<TraceLane>((int)lanes.size()));
+        return lanes.back().get();
+    }
+
+    void release(TraceLane* lane) {
+        std::lock_guard<std::mutex> lock(mu);
+        free_lanes.push_back(lane);
+    }
+
+    // Тиков в микросекунде: TSC сверяется со steady_clock на всём времени работы
+    double ticks_per_us() {
+#if defined(__x86_64__) || defined(__i386__)
+        auto elapsed = std::chrono::steady_clock::now() - origin_time;
+        if (elapsed < std::chrono::milliseconds(10)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10) - elapsed);
+        }
+        uint64_t t = trace_ticks();
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - origin_time).count();
+        return (double)(t - origin_ticks) / us;
+#else
+        return 1e3;
+#endif
+    }
+};
+
+inline TraceRegistry& trace_registry() {
+    static TraceRegistry registry;
+    return registry;
+}
+
+// Дорожка текущего потока: берётся при первой точке трассировки, отдаётся при выходе потока
+inline TraceLane& trace_lane() {
+    struct Holder {
+        TraceLane* lane = trace_registry().acquire();
+        ~Holder() { trace_registry().release(lane); }
+    };
+    static thread_local Holder holder;
+    return *holder.lane;
+}
+
+class TraceScope {
+public:
+    explicit TraceScope(TracePhase phase) : phase_(phase), start_(trace_ticks()) {}
+    ~TraceScope() { trace_lane().record(phase_, start_, trace_ticks()); }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+private:
+    TracePhase phase_;
+    uint64_t start_;
+};
+
+#define MATMUL_TRACE_CAT2(a, b) a##b
+#define MATMUL_TRACE_CAT(a, b) MATMUL_TRACE_CAT2(a, b)
+#define MATMUL_TRACE_SCOPE(phase) TraceScope MATMUL_TRACE_CAT(trace_scope_, __LINE__)(TracePhase::phase)
+#define MATMUL_TRACE_SCOPE_PHASE(expr) TraceScope MATMUL_TRACE_CAT(trace_scope_, __LINE__)(expr)
+
+// Обнуляет суммы по фазам (кольца событий не трогает)
+inline void trace_reset_summary() {
+    TraceRegistry& reg = trace_registry();
+    std::lock_guard<std::mutex> lock(reg.mu);
+    for (auto& lane : reg.lanes) lane->reset_summary();
+}
+
+// Фазы, встретившиеся с последнего trace_reset_summary(), в порядке TracePhase
+inline std::vector<TracePhaseStats> trace_summary() {
+    TraceRegistry& reg = trace_registry();
+    double tpu = reg.ticks_per_us();
+    std::lock_guard<std::mutex> lock(reg.mu);
+    std::vector<TracePhaseStats> out;
+    for (int i = 0; i < TRACE_PHASES; i++) {
+        TracePhaseStats s;
+        s.phase = (TracePhase)i;
+        uint64_t total = 0, busiest = 0, longest = 0;
+        for (auto& lane : reg.lanes) {
+            if (lane->count[i] == 0) continue;
+            s.events += lane->count[i];
+            s.threads++;
+            total += lane->ticks[i];
+            busiest = std::max(busiest, lane->ticks[i]);
+            longest = std::max(longest, lane->longest[i]);
+        }
+        if (s.events == 0) continue;
+        s.total_ms = total / tpu * 1e-3;
+        s.max_us = longest / tpu;
+        s.imbalance = total > 0 ? (double)busiest * s.threads / total : 1.0;
+        out.push_back(s);
+    }
+    return out;
+}
+
+// Chrome trace-event JSON (chrome://tracing, Perfetto): событие "X" на каждую запись колец,
+// tid - номер дорожки. При переполнении кольца остаются последние TRACE_RING_EVENTS событий.
+inline void trace_export_chrome(std::ostream& out) {
+    TraceRegistry& reg = trace_registry();
+    double tpu = reg.ticks_per_us();
+    std::lock_guard<std::mutex> lock(reg.mu);
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    bool first = true;
+    auto sep = [&] {
+        if (!first) out << ",\n";
+        first = false;
+    };
+    out << std::fixed << std::setprecision(3);
+    for (auto& lane : reg.lanes) {
+        sep();
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << lane->id
+            << ",\"args\":{\"name\":\"lane " << lane->id << "\"}}";
+        uint64_t head = lane->head.load(std::memory_order_acquire);
+        uint64_t first_event = head > TRACE_RING_EVENTS ? head - TRACE_RING_EVENTS : 0;
+        for (uint64_t e = first_event; e < head; e++) {
+            const TraceEvent& ev = lane->ring[e & (TRACE_RING_EVENTS - 1)];
+            sep();
+            out << "{\"name\":\"" << trace_phase_name(ev.phase) << "\",\"cat\":\"matmul\",\"ph\":\"X\",\"pid\":1,"
+                << "\"tid\":" << lane->id << ",\"ts\":" << (double)(ev.start - reg.origin_ticks) / tpu
+                << ",\"dur\":" << (double)(ev.end - ev.start) / tpu << "}";
+        }
+    }
+    out << "\n]}\n";
+}
+
+inline bool trace_write_chrome(const std::string& path) {
+    std::ofstream out(path);
+    if (!out) return false;
+    trace_export_chrome(out);
+    return (bool)out;
+}
+
+#else
+
+static constexpr bool trace_enabled = false;
+
+#define MATMUL_TRACE_SCOPE(phase) do {} while (0)
+#define MATMUL_TRACE_SCOPE_PHASE(expr) do {} while (0)
+
+inline void trace_reset_summary() {}
+inline std::vector<TracePhaseStats> trace_summary() { return {}; }
+inline void trace_export_chrome(std::ostream&) {}
+inline bool trace_write_chrome(const std::string&) { return false; }
+
+#endif // MATMUL_ENABLE_TRACE
+
+// Таблица по фазам: число событий, время, доля, самое длинное событие, дисбаланс потоков
+inline void print_trace_summary(std::ostream& out, const std::vector<TracePhaseStats>& stats,
+                                const std::string& indent = "") {
+    double total = 0;
+    for (auto& s : stats) total += s.total_ms;
+    for (auto& s : stats) {
+        out << indent << std::left << std::setw(11) << trace_phase_name(s.phase) << std::right
+            << std::setw(9) << s.events << " ev "
+            << std::fixed << std::setprecision(3) << std::setw(10) << s.total_ms << " ms "
+            << std::setprecision(1) << std::setw(5) << (total > 0 ? 100 * s.total_ms / total : 0.0) << "%"
+            << "  max " << std::setprecision(1) << std::setw(8) << s.max_us << " us"
+            << "  threads " << s.threads << " (imbalance " << std::setprecision(2) << s.imbalance << ")\n";
+    }
+}
+
+#endif // TRACE_H
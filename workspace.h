@@ -0,0 +1,154 @@
+//
+// Рабочая область (арена) для временных буферов алгоритмов
+// Bump-аллокатор: выделение - сдвиг указателя, освобождение - откат к метке (Workspace::Scope).
+// У каждого потока свой экземпляр (thread_workspace()), поэтому синхронизация не нужна.
+// После первого вызова арена уже нужного размера, и горячий путь не обращается к malloc.
+//
+
+#ifndef WORKSPACE_H
+#define WORKSPACE_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+#include "trace.h"
+
+class Workspace {
+public:
+    static constexpr size_t ALIGN = 64;  // строка кэша / ширина AVX-512
+
+    // Метка для отката: номер куска и смещение в нём
+    struct Mark {
+        size_t chunk = 0;
+        size_t offset = 0;
+    };
+
+    // Откатывает арену к состоянию на момент создания
+    class Scope {
+    public:
+        explicit Scope(Workspace& ws) : ws_(ws), mark_(ws.mark()) {}
+        ~Scope() { ws_.rewind(mark_); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        Workspace& ws_;
+        Mark mark_;
+    };
+
+    Workspace() = default;
+    explicit Workspace(size_t bytes) { reserve(bytes); }
+
+    Workspace(const Workspace&) = delete;
+    Workspace& operator=(const Workspace&) = delete;
+
+    static size_t aligned_size(size_t bytes) { return (bytes + ALIGN - 1) / ALIGN * ALIGN; }
+
+    // Гарантирует, что bytes поместятся в один кусок без новых выделений
+    void reserve(size_t bytes) {
+        bytes = aligned_size(bytes);
+        if (chunks_.size() == 1 and chunks_[0].size >= bytes) return;
+        if (cur_.chunk == 0 and cur_.offset == 0) {
+            chunks_.clear();
+            add_chunk(bytes);
+        }
+    }
+
+    // n элементов T, выровненных по ALIGN; память не обнулена (кроме нетривиальных T)
+    template <class T>
+    T* alloc(size_t n) {
+        // Откат Scope не вызывает деструкторы
+        static_assert(std::is_trivially_destructible_v<T>, "Workspace holds trivially destructible types only");
+        size_t bytes = aligned_size(n * sizeof(T));
+        void* p = alloc_bytes(bytes);
+        if constexpr (!std::is_trivially_default_constructible_v<T>) {
+            T* t = static_cast<T*>(p);
+            for (size_t i = 0; i < n; i++) new (t + i) T();
+        }
+        return static_cast<T*>(p);
+    }
+
+    Mark mark() const { return cur_; }
+
+    void rewind(Mark m) {
+        assert(m.chunk < cur_.chunk or (m.chunk == cur_.chunk and m.offset <= cur_.offset));
+        cur_ = m;
+        // Полностью пустая арена из нескольких кусков сливается в один - дальше без выделений
+        if (cur_.chunk == 0 and cur_.offset == 0 and chunks_.size() > 1) {
+            size_t total = 0;
+            for (auto& c : chunks_) total += c.size;
+            chunks_.clear();
+            add_chunk(total);
+        }
+    }
+
+    size_t capacity() const {
+        size_t total = 0;
+        for (auto& c : chunks_) total += c.size;
+        return total;
+    }
+
+    size_t used() const {
+        size_t total = cur_.offset;
+        for (size_t i = 0; i < cur_.chunk; i++) total += chunks_[i].size;
+        return total;
+    }
+
+    size_t high_water() const { return high_water_; }
+
+    // Сколько раз арена обращалась к системному аллокатору (для проверки горячего пути)
+    size_t heap_allocations() const { return heap_allocations_; }
+
+private:
+    struct Chunk {
+        std::unique_ptr<unsigned char[]> raw;
+        unsigned char* base = nullptr;
+        size_t size = 0;
+    };
+
+    void add_chunk(size_t bytes) {
+        MATMUL_TRACE_SCOPE(ALLOC);
+        Chunk c;
+        c.raw.reset(new unsigned char[bytes + ALIGN]);
+        auto addr = reinterpret_cast<uintptr_t>(c.raw.get());
+        c.base = c.raw.get() + (ALIGN - addr % ALIGN) % ALIGN;
+        c.size = bytes;
+        chunks_.push_back(std::move(c));
+        heap_allocations_++;
+    }
+
+    void* alloc_bytes(size_t bytes) {
+        if (chunks_.empty()) add_chunk(std::max<size_t>(bytes, 64 * 1024));
+
+        // Переходим к следующему куску, пока текущий не вмещает запрос
+        while (cur_.offset + bytes > chunks_[cur_.chunk].size) {
+            if (cur_.chunk + 1 == chunks_.size()) {
+                add_chunk(std::max(bytes, 2 * chunks_.back().size));
+            }
+            cur_.chunk++;
+            cur_.offset = 0;
+        }
+
+        void* p = chunks_[cur_.chunk].base + cur_.offset;
+        cur_.offset += bytes;
+        high_water_ = std::max(high_water_, used());
+        return p;
+    }
+
+    std::vector<Chunk> chunks_;
+    Mark cur_;
+    size_t high_water_ = 0;
+    size_t heap_allocations_ = 0;
+};
+
+// Арена текущего потока
+inline Workspace& thread_workspace() {
+    static thread_local Workspace ws;
+    return ws;
+}
+
+#endif // WORKSPACE_H